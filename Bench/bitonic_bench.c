@@ -0,0 +1,569 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "../lib/bitonic.h"
+#include "../lib/bitonic_adaptive.h"
+#include "../lib/bitonic_simd.h"
+
+#define BENCH_MAX_SIZES 32
+#define BENCH_MAX_LOG2 33
+#define BENCH_MAX_THREADS 16
+#define BENCH_FEW_UNIQUE 16
+#define BENCH_ZIPF_EXPONENT 1.0
+
+/* How an engine is driven */
+typedef enum
+{
+    RUN_NETWORK,  // bitonic_sort in the given schedule
+    RUN_LOCAL,    // bitonic_sort_local with the given local engine
+    RUN_QSORT     // C library qsort baseline
+} bench_kind;
+
+typedef struct
+{
+    const char *name;
+    bench_kind kind;
+    int engine;  // bitonic_engine or local_sort_engine
+    int serial;  // 1: always one thread
+} bench_engine;
+
+static const bench_engine bench_engines[] = {
+    {"serial", RUN_NETWORK, BITONIC_ENGINE_FLAT, 1},
+    {"openmp", RUN_NETWORK, BITONIC_ENGINE_FLAT, 0},
+    {"blocks", RUN_NETWORK, BITONIC_ENGINE_BLOCKS, 0},
+    {"tasks", RUN_NETWORK, BITONIC_ENGINE_TASKS, 0},
+    {"hybrid", RUN_LOCAL, LOCAL_SORT_HYBRID, 0},
+    {"radix", RUN_LOCAL, LOCAL_SORT_RADIX, 0},
+    {"qsort", RUN_QSORT, 0, 1},
+};
+#define BENCH_ENGINES ((int)(sizeof(bench_engines) / sizeof(bench_engines[0])))
+
+typedef enum
+{
+    DIST_UNIFORM,
+    DIST_SORTED,
+    DIST_REVERSE,
+    DIST_FEW_UNIQUE,
+    DIST_ZIPF,
+    BENCH_DISTS
+} bench_dist;
+
+static const char *const bench_dists[BENCH_DISTS] = {"uniform", "sorted", "reverse", "few-unique", "zipf"};
+
+/* Adaptive plan names, indexed by bitonic_adaptive_plan */
+static const char *const bench_plans[] = {"full", "sorted", "reversed", "runs", "sparse"};
+
+/**
+ * Function: mix64
+ * ---------------
+ * splitmix64 finalizer: a counter-based generator, so element i of an input
+ * is the same for every thread count and run.
+ */
+static uint64_t mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/* Uniform double in [0, 1) from the i-th draw of a stream */
+static double unit(uint64_t seed, uint64_t i)
+{
+    return (double)(mix64(seed ^ mix64(i)) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Zipf sampler: rejection-inversion (Hoermann & Derflinger) over the ranks
+ * 1..n with exponent s, O(1) per draw for any n.
+ */
+typedef struct
+{
+    double s;
+    double h_x1;
+    double h_n;
+    double threshold;
+    long long n;
+} zipf_sampler;
+
+static double zipf_helper1(double x)
+{
+    return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+static double zipf_helper2(double x)
+{
+    return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+}
+
+/* Integral of the hat function, (x^(1-s) - 1) / (1 - s) */
+static double zipf_h_integral(const zipf_sampler *z, double x)
+{
+    double lx = log(x);
+    return zipf_helper2((1.0 - z->s) * lx) * lx;
+}
+
+static double zipf_h(const zipf_sampler *z, double x)
+{
+    return exp(-z->s * log(x));
+}
+
+static double zipf_h_integral_inverse(const zipf_sampler *z, double x)
+{
+    double t = x * (1.0 - z->s);
+    if (t < -1.0)
+        t = -1.0;
+    return exp(zipf_helper1(t) * x);
+}
+
+static void zipf_init(zipf_sampler *z, long long n, double s)
+{
+    z->n = n;
+    z->s = s;
+    z->h_x1 = zipf_h_integral(z, 1.5) - 1.0;
+    z->h_n = zipf_h_integral(z, n + 0.5);
+    z->threshold = 2.0 - zipf_h_integral_inverse(z, zipf_h_integral(z, 2.5) - zipf_h(z, 2.0));
+}
+
+static long long zipf_draw(const zipf_sampler *z, uint64_t seed, uint64_t i)
+{
+    for (uint64_t attempt = 0;; ++attempt)
+    {
+        double u = z->h_n + unit(seed + attempt, i) * (z->h_x1 - z->h_n);
+        double x = zipf_h_integral_inverse(z, u);
+        long long k = (long long)(x + 0.5);
+        if (k < 1)
+            k = 1;
+        else if (k > z->n)
+            k = z->n;
+        if (k - x <= z->threshold || u >= zipf_h_integral(z, k + 0.5) - zipf_h(z, (double)k))
+            return k;
+    }
+}
+
+/**
+ * Function: generate
+ * ------------------
+ * Fills data[0, n) with distribution 'dist' in parallel:
+ * - uniform: independent values over the whole int range
+ * - sorted / reverse: 0..n-1 ascending / descending
+ * - few-unique: BENCH_FEW_UNIQUE distinct random values
+ * - zipf: ranks drawn with P(k) ~ 1 / k^s, scrambled over the int range so
+ *   the frequent keys are not simply the smallest ones
+ */
+static void generate(int *data, long long n, bench_dist dist, uint64_t seed)
+{
+    zipf_sampler zipf;
+    zipf_init(&zipf, n, BENCH_ZIPF_EXPONENT);
+    uint64_t stream = mix64(seed + (uint64_t)dist);
+
+#pragma omp parallel for schedule(static)
+    for (long long i = 0; i < n; ++i)
+    {
+        uint32_t value;
+        switch (dist)
+        {
+        case DIST_SORTED:
+            value = (uint32_t)i;
+            break;
+        case DIST_REVERSE:
+            value = (uint32_t)(n - 1 - i);
+            break;
+        case DIST_FEW_UNIQUE:
+            value = (uint32_t)mix64(stream + mix64((uint64_t)i) % BENCH_FEW_UNIQUE);
+            break;
+        case DIST_ZIPF:
+            value = (uint32_t)zipf_draw(&zipf, stream, (uint64_t)i) * 2654435761u;
+            break;
+        default:
+            value = (uint32_t)mix64(stream ^ mix64((uint64_t)i));
+            break;
+        }
+        data[i] = (int)value;
+    }
+}
+
+/* Order-independent fingerprint of a multiset of values */
+static uint64_t fingerprint(const int *data, long long n)
+{
+    uint64_t sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+    for (long long i = 0; i < n; ++i)
+        sum += mix64((uint64_t)(uint32_t)data[i]);
+    return sum;
+}
+
+static int is_sorted(const int *data, long long n)
+{
+    int sorted = 1;
+#pragma omp parallel for reduction(& : sorted) schedule(static)
+    for (long long i = 1; i < n; ++i)
+        sorted &= (data[i - 1] <= data[i]);
+    return sorted;
+}
+
+static int int_compare(const void *a, const void *b)
+{
+    int lhs = *(const int *)a;
+    int rhs = *(const int *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static int run_engine(const bench_engine *engine, bitonic_context *ctx, int *data, long long n)
+{
+    switch (engine->kind)
+    {
+    case RUN_NETWORK:
+        bitonic_context_set_engine(ctx, (bitonic_engine)engine->engine);
+        return bitonic_sort(ctx, data, n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE);
+    case RUN_LOCAL:
+        return bitonic_sort_local(ctx, data, n, (local_sort_engine)engine->engine);
+    case RUN_QSORT:
+        qsort(data, (size_t)n, sizeof(int), int_compare);
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * Function: adaptive_plan
+ * -----------------------
+ * The presortedness plan bitonic_sort takes on 'input' for this engine: a
+ * name from bench_plans, "off" when the fast paths are turned off, or "none"
+ * for engines that never scan (local engines, qsort).
+ */
+static const char *adaptive_plan(const bench_engine *engine, int adaptive, const int *input, long long n)
+{
+    if (engine->kind != RUN_NETWORK)
+        return "none";
+    if (!adaptive)
+        return "off";
+    bitonic_adaptive_scan scan;
+    bitonic_adaptive_measure(input, n, omp_get_max_threads(), &scan);
+    return bench_plans[scan.plan];
+}
+
+static int double_compare(const void *a, const void *b)
+{
+    double lhs = *(const double *)a;
+    double rhs = *(const double *)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+/* Percentile q of sorted[0, count), interpolating between neighbours */
+static double percentile(const double *sorted, int count, double q)
+{
+    double pos = q * (count - 1);
+    int lo = (int)pos;
+    int hi = (lo + 1 < count) ? lo + 1 : lo;
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+/**
+ * Function: parse_list
+ * --------------------
+ * Parses "a,b,c-d" into up to 'max' integers (ranges inclusive).
+ * Returns the count, or -1 if the list is malformed or out of [lo, hi].
+ */
+static int parse_list(const char *text, int *values, int max, int lo, int hi)
+{
+    int count = 0;
+    const char *p = text;
+    while (*p)
+    {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p)
+            return -1;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1)
+                return -1;
+            p = end;
+        }
+        if (first < lo || last > hi || last < first)
+            return -1;
+        for (long v = first; v <= last; ++v)
+        {
+            if (count == max)
+                return -1;
+            values[count++] = (int)v;
+        }
+        if (*p == ',')
+            ++p;
+        else if (*p)
+            return -1;
+    }
+    return count;
+}
+
+/* Index of 'name' in names[0, count), or -1 */
+static int find_name(const char *name, size_t length, const char *const *names, int count, size_t stride)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const char *candidate = *(const char *const *)((const char *)names + i * stride);
+        if (strlen(candidate) == length && strncmp(candidate, name, length) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * Function: parse_names
+ * ---------------------
+ * Marks the entries of a comma-separated name list in selected[] ("all"
+ * selects every entry). Returns 0 on success, -1 for an unknown name.
+ */
+static int parse_names(const char *text, const char *const *names, int count, size_t stride, int *selected)
+{
+    memset(selected, 0, (size_t)count * sizeof(int));
+    if (strcmp(text, "all") == 0)
+    {
+        for (int i = 0; i < count; ++i)
+            selected[i] = 1;
+        return 0;
+    }
+    const char *p = text;
+    while (*p)
+    {
+        size_t length = strcspn(p, ",");
+        int index = find_name(p, length, names, count, stride);
+        if (index < 0)
+            return -1;
+        selected[index] = 1;
+        p += length;
+        if (*p == ',')
+            ++p;
+    }
+    return 0;
+}
+
+/**
+ * Function: main
+ * --------------
+ * Benchmark harness for libbitonic: generates the inputs in process, runs
+ * every selected engine on every size, distribution and thread count with
+ * warmup and repeated timed runs, checks each result and writes one row of
+ * timing statistics (min, p10, median, p90, max) per configuration as CSV
+ * or JSON, which graph/plot_comparison.py plots directly.
+ *
+ * Usage: bitonic_bench [--sizes=LIST] [--dists=LIST] [--engines=LIST]
+ *                      [--threads=LIST] [--warmup=W] [--repeat=R]
+ *                      [--adaptive=on|off] [--seed=S] [--format=csv|json]
+ *                      [--out=PATH]
+ *   --sizes    log2 of the input sizes, e.g. 10-33 or 16,20,24 (default 10-24);
+ *              sizes past 2^31 check the 64-bit paths (2 x 4 bytes per value)
+ *   --dists    uniform, sorted, reverse, few-unique, zipf or all (default all)
+ *   --engines  serial (the Serial program's one-thread SIMD network),
+ *              openmp, blocks, tasks (the OpenMP program's schedules),
+ *              hybrid (SIMD bitonic blocks + parallel merges), radix, qsort
+ *              or all (default serial,openmp,hybrid,qsort)
+ *   --threads  thread counts for the parallel engines (default
+ *              OMP_NUM_THREADS); serial and qsort always run on one
+ *   --warmup   untimed runs per configuration (default 1)
+ *   --repeat   timed runs per configuration (default 5)
+ *   --adaptive presortedness fast paths of the network engines (default:
+ *              BITONIC_ADAPTIVE, on unless it is 0); off times the engines
+ *              themselves on sorted and reverse input, which the fast paths
+ *              otherwise answer with one memory scan
+ *   --seed     input generator seed (default 42); the inputs depend only on
+ *              the seed, distribution and size
+ *   --format   csv (default) or json
+ *   --out      result file (default OutputFiles/bench.csv or .json)
+ *
+ * Each timed run sorts a fresh copy of the same input; copies, checks and
+ * generation are not timed. Every row records the adaptive plan taken.
+ */
+int main(int argc, char **argv)
+{
+    int sizes[BENCH_MAX_SIZES];
+    int size_count = parse_list("10-24", sizes, BENCH_MAX_SIZES, 1, BENCH_MAX_LOG2);
+    int threads[BENCH_MAX_THREADS] = {omp_get_max_threads()};
+    int thread_count = 1;
+    int dist_on[BENCH_DISTS];
+    int engine_on[BENCH_ENGINES];
+    int warmup = 1;
+    int repeat = 5;
+    unsigned long long seed = 42;
+    int adaptive = bitonic_adaptive_enabled();
+    int json = 0;
+    const char *out_path = NULL;
+    int bad_option = 0;
+
+    parse_names("all", bench_dists, BENCH_DISTS, sizeof(bench_dists[0]), dist_on);
+    parse_names("serial,openmp,hybrid,qsort", &bench_engines[0].name, BENCH_ENGINES, sizeof(bench_engines[0]),
+                engine_on);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--sizes=", 8) == 0)
+            bad_option |= (size_count = parse_list(argv[i] + 8, sizes, BENCH_MAX_SIZES, 1, BENCH_MAX_LOG2)) <= 0;
+        else if (strncmp(argv[i], "--threads=", 10) == 0)
+            bad_option |= (thread_count = parse_list(argv[i] + 10, threads, BENCH_MAX_THREADS, 1, 4096)) <= 0;
+        else if (strncmp(argv[i], "--dists=", 8) == 0)
+            bad_option |= parse_names(argv[i] + 8, bench_dists, BENCH_DISTS, sizeof(bench_dists[0]), dist_on);
+        else if (strncmp(argv[i], "--engines=", 10) == 0)
+            bad_option |= parse_names(argv[i] + 10, &bench_engines[0].name, BENCH_ENGINES,
+                                      sizeof(bench_engines[0]), engine_on);
+        else if (strncmp(argv[i], "--warmup=", 9) == 0)
+            bad_option |= (warmup = atoi(argv[i] + 9)) < 0;
+        else if (strncmp(argv[i], "--repeat=", 9) == 0)
+            bad_option |= (repeat = atoi(argv[i] + 9)) < 1;
+        else if (strcmp(argv[i], "--adaptive=on") == 0)
+            adaptive = 1;
+        else if (strcmp(argv[i], "--adaptive=off") == 0)
+            adaptive = 0;
+        else if (strncmp(argv[i], "--seed=", 7) == 0)
+            seed = strtoull(argv[i] + 7, NULL, 10);
+        else if (strcmp(argv[i], "--format=csv") == 0)
+            json = 0;
+        else if (strcmp(argv[i], "--format=json") == 0)
+            json = 1;
+        else if (strncmp(argv[i], "--out=", 6) == 0)
+            out_path = argv[i] + 6;
+        else
+            bad_option = 1;  // Unknown option: print usage
+    }
+    if (bad_option)
+    {
+        fprintf(stderr,
+                "Usage: %s [--sizes=10-24] [--dists=uniform,sorted,reverse,few-unique,zipf|all] "
+                "[--engines=serial,openmp,blocks,tasks,hybrid,radix,qsort|all] [--threads=1,2,4] "
+                "[--warmup=W] [--repeat=R] [--adaptive=on|off] [--seed=S] [--format=csv|json] [--out=PATH]\n",
+                argv[0]);
+        return 1;
+    }
+    if (!out_path)
+    {
+        system("mkdir -p OutputFiles");
+        out_path = json ? "OutputFiles/bench.json" : "OutputFiles/bench.csv";
+    }
+    FILE *out = fopen(out_path, "w");
+    if (!out)
+    {
+        perror(out_path);
+        return 1;
+    }
+
+    // One context per thread count: teams and arenas persist across sizes
+    bitonic_context *serial_ctx = bitonic_context_create(1);
+    bitonic_context *ctxs[BENCH_MAX_THREADS] = {NULL};
+    int ok = (serial_ctx != NULL);
+    for (int t = 0; t < thread_count && ok; ++t)
+        ok = ((ctxs[t] = bitonic_context_create(threads[t])) != NULL);
+    if (ok)
+    {
+        bitonic_context_set_adaptive(serial_ctx, adaptive);
+        for (int t = 0; t < thread_count; ++t)
+            bitonic_context_set_adaptive(ctxs[t], adaptive);
+    }
+    double *times = malloc((size_t)repeat * sizeof(double));
+    if (!ok || !times)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+
+    if (json)
+        fprintf(out, "{\n  \"simd\": \"%s\",\n  \"seed\": %llu,\n  \"adaptive\": %s,\n  \"results\": [",
+                bitonic_simd_isa(), seed, adaptive ? "true" : "false");
+    else
+        fprintf(out, "engine,distribution,n,threads,adaptive,warmup,repeat,min_s,p10_s,median_s,p90_s,max_s,"
+                     "melem_per_s\n");
+
+    int rows = 0;
+    int failed = 0;
+    for (int s = 0; s < size_count && !failed; ++s)
+    {
+        long long n = 1LL << sizes[s];
+        int *input = malloc((size_t)n * sizeof(int));
+        int *work = malloc((size_t)n * sizeof(int));
+        if (!input || !work)
+        {
+            fprintf(stderr, "Cannot allocate 2 x %lld ints; skipping larger sizes\n", n);
+            free(input);
+            free(work);
+            break;
+        }
+        bitonic_context_first_touch(ctxs[thread_count - 1], work, n, sizeof(int));
+
+        for (int d = 0; d < BENCH_DISTS && !failed; ++d)
+        {
+            if (!dist_on[d])
+                continue;
+            generate(input, n, (bench_dist)d, seed);
+            uint64_t expected = fingerprint(input, n);
+
+            for (int e = 0; e < BENCH_ENGINES && !failed; ++e)
+            {
+                const bench_engine *engine = &bench_engines[e];
+                if (!engine_on[e])
+                    continue;
+                const char *plan = adaptive_plan(engine, adaptive, input, n);
+                for (int t = 0; t < (engine->serial ? 1 : thread_count) && !failed; ++t)
+                {
+                    bitonic_context *ctx = engine->serial ? serial_ctx : ctxs[t];
+                    int team = engine->serial ? 1 : threads[t];
+                    for (int r = 0; r < warmup + repeat && !failed; ++r)
+                    {
+                        memcpy(work, input, (size_t)n * sizeof(int));
+                        double start = omp_get_wtime();
+                        int status = run_engine(engine, ctx, work, n);
+                        double end = omp_get_wtime();
+                        if (status != 0 || !is_sorted(work, n) || fingerprint(work, n) != expected)
+                        {
+                            fprintf(stderr, "%s failed on %s n=%lld threads=%d\n", engine->name, bench_dists[d], n,
+                                    team);
+                            failed = 1;
+                        }
+                        if (r >= warmup)
+                            times[r - warmup] = end - start;
+                    }
+                    if (failed)
+                        break;
+
+                    qsort(times, repeat, sizeof(double), double_compare);
+                    double median = percentile(times, repeat, 0.5);
+                    double rate = (double)n / median / 1e6;
+                    if (json)
+                        fprintf(out,
+                                "%s\n    {\"engine\": \"%s\", \"distribution\": \"%s\", \"n\": %lld, \"threads\": %d, "
+                                "\"adaptive\": \"%s\", \"warmup\": %d, \"repeat\": %d, \"min_s\": %.9f, "
+                                "\"p10_s\": %.9f, \"median_s\": %.9f, \"p90_s\": %.9f, \"max_s\": %.9f, \"melem_per_s\": %.3f}",
+                                rows ? "," : "", engine->name, bench_dists[d], n, team, plan, warmup, repeat, times[0],
+                                percentile(times, repeat, 0.1), median, percentile(times, repeat, 0.9),
+                                times[repeat - 1], rate);
+                    else
+                        fprintf(out, "%s,%s,%lld,%d,%s,%d,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.3f\n", engine->name,
+                                bench_dists[d], n, team, plan, warmup, repeat, times[0], percentile(times, repeat, 0.1),
+                                median, percentile(times, repeat, 0.9), times[repeat - 1], rate);
+                    fflush(out);
+                    ++rows;
+                    printf("%-8s %-10s n=2^%-2d threads=%-3d %-8s median %.6f s (%.1f Melem/s)\n", engine->name,
+                           bench_dists[d], sizes[s], team, plan, median, rate);
+                    fflush(stdout);
+                }
+            }
+        }
+        free(input);
+        free(work);
+    }
+
+    if (json)
+        fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    printf("%d results written to %s\n", rows, out_path);
+
+    free(times);
+    for (int t = 0; t < thread_count; ++t)
+        bitonic_context_destroy(ctxs[t]);
+    bitonic_context_destroy(serial_ctx);
+    return failed ? 1 : 0;
+}
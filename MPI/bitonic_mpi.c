@@ -1,288 +1,146 @@
 #include <mpi.h>
+#include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 
-/**
- * Function: next_power_of_two
- * ----------------------------
- * Calculates the next power of 2 greater than or equal to n.
- * This is needed because bitonic sort requires array size to be a power of 2.
- * 
- 
- */
-static int next_power_of_two(int n)
-{
-    int p = 1;
-    while (p < n)
-    {
-        p <<= 1;  // Left shift is equivalent to multiplying by 2
-    }
-    return p;
-}
+#include "../lib/bitonic.h"
+#include "../lib/bitonic_dist.h"
+#include "../lib/bitonic_trace.h"
 
-/**
- * Function: int_compare
- * ---------------------
- * Comparison function for qsort to sort integers in ascending order.
- * 
- 
- * 
- * Purpose: Used by qsort() to compare two integers
+/*
+ * Driver for the distributed sort in libbitonic_mpi (lib/bitonic_dist.c):
+ * option parsing, data distribution, timing and reporting.
  */
-static int int_compare(const void *a, const void *b)
-{
-    int lhs = *(const int *)a;
-    int rhs = *(const int *)b;
-    if (lhs < rhs)
-        return -1;
-    if (lhs > rhs)
-        return 1;
-    return 0;
-}
 
 /**
- * Function: read_input_rank0
- * --------------------------
- * Reads integer values from an input file (only called by rank 0 process).
- * Uses dynamic memory allocation that grows as needed (starts at 1024, doubles when full).
-
- * 
- * Purpose: Loads the dataset to be sorted from file into memory (master process only)
+ * Function: sort_records
+ * ----------------------
+ * Steps 2-12 of main for typed records: rank 0 reads and numbers the
+ * records, bitonic_dist_scatterv distributes them (short blocks padded with
+ * records that order last), each rank sorts its block with the specialized network,
+ * and the blocks are ordered by the compare-split network or merged on
+ * rank 0. Returns 0 on success.
  */
-static int read_input_rank0(const char *path, int **data_out)
+static int sort_records(bitonic_context *ctx, const char *input_path, const bitonic_key_ops *ops, int rank,
+                        int world_size, int rank0_merge, int gather, bitonic_output_format output_format)
 {
-    FILE *fp = fopen(path, "r");
-    if (!fp)
+    MPI_Datatype type = bitonic_dist_record_type(ops);
+    char *global_data = NULL;
+    long long original_count = 0;
+    long long *counts = malloc(world_size * sizeof(long long));
+    long long *displs = malloc(world_size * sizeof(long long));
+    if (!counts || !displs)
     {
-        perror("Failed to open input file");
-        return -1;
-    }
-
-    int capacity = 1024;  // Initial capacity
-    int size = 0;         // Current number of elements
-    int *buffer = malloc(capacity * sizeof(int));
-    if (!buffer)
-    {
-        fclose(fp);
         fprintf(stderr, "Memory allocation failed\n");
-        return -1;
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
-    while (1)
+    if (rank == 0)
     {
-        int value;
-        int scanned = fscanf(fp, "%d", &value);
-        if (scanned == 1)
-        {
-            // If buffer is full, double its capacity
-            if (size == capacity)
-            {
-                capacity *= 2;
-                int *tmp = realloc(buffer, capacity * sizeof(int));
-                if (!tmp)
-                {
-                    free(buffer);
-                    fclose(fp);
-                    fprintf(stderr, "Memory allocation failed\n");
-                    return -1;
-                }
-                buffer = tmp;
-            }
-            buffer[size++] = value;
-        }
-        else if (scanned == EOF)
-        {
-            break;  // End of file reached
-        }
-        else
+        void *records = NULL;
+        original_count = bitonic_read(ctx, input_path, ops->codec, &records);
+        if (original_count <= 0)
         {
-            free(buffer);
-            fclose(fp);
-            fprintf(stderr, "Invalid data in input file\n");
-            return -1;
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
+        ops->number(records, original_count);  // Payload = input position
+        global_data = records;
     }
 
-    fclose(fp);
-    *data_out = buffer;
-    return size;
-}
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_DISTRIBUTE, &trace);
+    MPI_Bcast(&original_count, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    long long local_n = bitonic_dist_chunk(original_count, world_size);
+    bitonic_dist_layout(original_count, local_n, world_size, counts, displs);
 
-/**
- * Function: compare_and_swap
- * --------------------------
- * Bitonic comparator: compares two elements and swaps them if they're in wrong order.
- * This is the fundamental operation in bitonic sort.
+    char *local_data = malloc((size_t)local_n * ops->size);
+    if (!local_data)
+    {
+        fprintf(stderr, "Rank %d failed to allocate local buffer\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    bitonic_context_first_touch(ctx, local_data, local_n, ops->size);
+    bitonic_dist_scatterv(MPI_COMM_WORLD, global_data, counts, displs, local_data, type, 0);
+    bitonic_trace_end(BITONIC_PHASE_DISTRIBUTE, &trace);
+    bitonic_trace_begin(BITONIC_PHASE_PAD, &trace);
+    ops->fill_max(local_data, counts[rank], local_n);
+    bitonic_trace_end(BITONIC_PHASE_PAD, &trace);
+    free(global_data);
 
- * 
- * Purpose: Ensures elements are ordered correctly based on sort direction
- * - If direction is ascending (1): ensures a <= b
- * - If direction is descending (0): ensures a >= b
- */
-static void compare_and_swap(int *a, int *b, int direction)
-{
-    if ((direction == 1 && *a > *b) || (direction == 0 && *a < *b))
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    if (bitonic_sort(ctx, local_data, local_n, ops->key, ops->payload) != 0)
     {
-        int tmp = *a;
-        *a = *b;
-        *b = tmp;
+        fprintf(stderr, "Rank %d failed to sort its block (memory allocation failed)\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (!rank0_merge)
+    {
+        bitonic_dist_exchange_records(ctx, MPI_COMM_WORLD, local_data, local_n, ops, type);
     }
-}
 
-/**
- * Function: bitonic_merge
- * -----------------------
- * Recursively merges two bitonic sequences into one sorted sequence.
- * A bitonic sequence is one that first increases then decreases (or vice versa).
- *
- * 
- * Algorithm:
- * 1. Compare and swap elements that are 'size/2' apart
- * 2. Recursively merge the two halves
- * 
- * Purpose: Merges two adjacent bitonic sequences into one sorted sequence
- */
-static void bitonic_merge(int *data, int start, int size, int direction)
-{
-    if (size > 1)
+    char *all_data = NULL;
+    if (gather && rank == 0)
     {
-        int mid = size / 2;
-        // Compare elements in first half with corresponding elements in second half
-        for (int i = start; i < start + mid; ++i)
+        all_data = malloc((size_t)(original_count > 0 ? original_count : 1) * ops->size);
+        if (!all_data)
         {
-            compare_and_swap(&data[i], &data[i + mid], direction);
+            fprintf(stderr, "Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
-        // Recursively merge both halves
-        bitonic_merge(data, start, mid, direction);
-        bitonic_merge(data, start + mid, mid, direction);
     }
-}
-
-/**
- * Function: bitonic_sort_recursive
- * --------------------------------
- * Recursively builds and sorts a bitonic sequence using divide-and-conquer.
- * This is the classic recursive bitonic sort algorithm.
- * 
- * Algorithm:
- * 1. Divide array into two halves
- * 2. Sort first half in ascending order (creates ascending bitonic sequence)
- * 3. Sort second half in descending order (creates descending bitonic sequence)
- * 4. Merge both halves to get final sorted sequence
- * 
- * Purpose: Each MPI process uses this to sort its local data before distributed merge
- */
-static void bitonic_sort_recursive(int *data, int start, int size, int direction)
-{
-    if (size > 1)
+    if (gather)
     {
-        int mid = size / 2;
-        // Sort first half in ascending order
-        bitonic_sort_recursive(data, start, mid, 1);
-        // Sort second half in descending order
-        bitonic_sort_recursive(data, start + mid, mid, 0);
-        // Merge entire sequence in desired direction
-        bitonic_merge(data, start, size, direction);
+        bitonic_trace_begin(BITONIC_PHASE_GATHER, &trace);
+        bitonic_dist_gatherv(MPI_COMM_WORLD, local_data, all_data, counts, displs, type, 0);
+        bitonic_trace_end(BITONIC_PHASE_GATHER, &trace);
     }
-}
-
-/**
- * Function: merge_exchange
- * ------------------------
- * Performs a compare-exchange operation between two MPI processes.
- * This is the distributed version of compare_and_swap for inter-process communication.
- * 
- * @param local: Local data array of this process
- * @param local_n: Number of elements in local array
- * @param partner: Rank of the partner process to exchange with
- * @param ascending: Direction flag (1 = keep smaller half, 0 = keep larger half)
- * 
- * Algorithm:
- * 1. Exchange local data with partner process (MPI_Sendrecv)
- * 2. Merge both arrays into a sorted combined array
- * 3. If ascending: keep the smaller half of merged data
- *    If descending: keep the larger half of merged data (reversed)
- * 
- * Purpose: Enables distributed bitonic sort by allowing processes to exchange
- *          and redistribute data to maintain global sort order
- */
-static void merge_exchange(int *local, int local_n, int partner, int ascending)
-{
-    int *recv_buf = malloc(local_n * sizeof(int));
-    int *merged = malloc(2 * local_n * sizeof(int));
-    if (!recv_buf || !merged)
+    if (rank0_merge && rank == 0 && bitonic_dist_merge_records_rank0(ctx, all_data, original_count, local_n, ops) != 0)
     {
-        fprintf(stderr, "Memory allocation failed during merge\n");
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
-    // Exchange data with partner process (simultaneous send and receive)
-    MPI_Sendrecv(local, local_n, MPI_INT, partner, 0,
-                 recv_buf, local_n, MPI_INT, partner, 0,
-                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double end = MPI_Wtime();
+
+    int verified = gather ? 1 : bitonic_dist_verify_records(MPI_COMM_WORLD, local_data, local_n, ops, type);
 
-    // Merge the two sorted arrays
-    int i = 0, j = 0, m = 0;
-    while (i < local_n && j < local_n)
+    int status = 0;
+    if (rank == 0)
     {
-        if (local[i] <= recv_buf[j])
-        {
-            merged[m++] = local[i++];
-        }
-        else
+        if (gather)
         {
-            merged[m++] = recv_buf[j++];
+            status = bitonic_write(ctx, bitonic_output_path("mpi", output_format), ops->codec, all_data,
+                                   original_count, output_format);
         }
-    }
-    while (i < local_n)
-        merged[m++] = local[i++];
-    while (j < local_n)
-        merged[m++] = recv_buf[j++];
 
-    if (ascending)
-    {
-        // Ascending: keep smaller half (first half of merged array)
-        memcpy(local, merged, local_n * sizeof(int));
-    }
-    else
-    {
-        // Descending: keep larger half in reverse order (last half of merged array)
-        for (int idx = 0; idx < local_n; ++idx)
+        printf("Processes: %d\n", world_size);
+        printf("Threads per rank: %d\n", omp_get_max_threads());
+        printf("Merge: %s\n", rank0_merge ? "rank 0" : "exchange network");
+        printf("Keys: %s\n", ops->name);
+        printf("I/O: rank 0\n");
+        if (!gather)
         {
-            local[idx] = merged[2 * local_n - 1 - idx];
+            printf("Distributed result verified: %s\n", verified ? "yes" : "no");
         }
-    }
+        bitonic_arena_stats stats;
+        bitonic_context_stats(ctx, &stats);
+        printf("Scratch peak (bytes): %zu\n", stats.peak);  // Rank 0's arena high-water mark
+        printf("Execution time (s): %.6f\n", end - start);
 
-    free(merged);
-    free(recv_buf);
-}
+        free(all_data);
+    }
 
+    bitonic_dist_trace_report(MPI_COMM_WORLD, "mpi");
 
-/**
- * Function: write_output_rank0
- * ----------------------------
- * Writes the sorted array to an output file (only called by rank 0 process).
- * Numbers are written on a single line, separated by spaces.
- * 
- * Purpose: Saves the final sorted result to a file for verification
- */
-static void write_output_rank0(const char *path, const int *data, int count)
-{
-    FILE *fp = fopen(path, "w");
-    if (!fp)
-    {
-        perror("Failed to open output file");
-        return;
-    }
-    for (int i = 0; i < count; ++i)
-    {
-        // Write number, add space unless it's the last element
-        fprintf(fp, "%d%s", data[i], (i + 1 == count) ? "" : " ");
-    }
-    fprintf(fp, "\n");
-    fclose(fp);
+    MPI_Type_free(&type);
+    free(local_data);
+    free(counts);
+    free(displs);
+    return status;
 }
 
 /**
@@ -290,196 +148,465 @@ static void write_output_rank0(const char *path, const int *data, int count)
  * --------------
  * Main entry point for the MPI distributed bitonic sort program.
  * 
+ * Usage: bitonic_mpi <input_file> [--hybrid] [--rank0-merge] [--no-gather] [--local-sort=ENGINE]
+ *                    [--output=FORMAT] [--mpi-io] [--key=TYPE] [--payload=TYPE] [--top-k=K]
+ *                    [--sample-sort]
+ *   --hybrid       Hybrid MPI + OpenMP mode: run one rank per socket or node
+ *                  with OMP_NUM_THREADS threads each; the local sort defaults
+ *                  to the OpenMP bitonic engine and every exchange round uses
+ *                  a communication thread plus parallel merge-path merging
+ *   --rank0-merge  Gather the sorted chunks and merge them serially on rank 0
+ *                  (the original algorithm) instead of the exchange network
+ *   --no-gather    Leave the sorted result distributed across the ranks and
+ *                  only verify it (no output file is written)
+ *   --local-sort   Engine for each rank's local phase: radix (default),
+ *                  openmp (default with --hybrid), flat, blocks or tasks
+ *                  (openmp in that schedule), hybrid, bitonic, insertion,
+ *                  recursive or qsort
+ *   --output       Result format: text (default), binary or none
+ *   --mpi-io       Collective MPI-IO: each rank reads its own byte range of a
+ *                  binary input and writes its sorted partition at its global
+ *                  offset, so no rank holds more than one chunk (needs the
+ *                  exchange network or --sample-sort)
+ *   --key          Key type: int32 (default), int64, uint64, float or double
+ *   --payload      Carry the input position with each key: none (default),
+ *                  index32 or index64 (text output as key:index)
+ *   --top-k        Output only the K smallest values: each rank selects its
+ *                  own K and a binomial tree merges the lists towards rank 0,
+ *                  sending K values per rank (int32 keys; any process count;
+ *                  --rank0-merge and --no-gather do not apply)
+ *   --sample-sort  Sample sort instead of the bitonic network: local sort,
+ *                  P - 1 splitters from regular samples and one
+ *                  MPI_Alltoallv, then a merge of the received runs (int32
+ *                  keys; any process count; blocks end up uneven)
+ * 
+ * Any --key other than int32 or any --payload sorts typed records with
+ * sort_records (exchange network without pipelining, --hybrid,
+ * --local-sort and --mpi-io do not apply).
+ * 
  * Overall Process:
  * 1. Initialize MPI and get process rank/size
- * 2. Rank 0 reads input and pads to appropriate size
- * 3. Distribute data chunks to all processes
+ * 2. Rank 0 reads input
+ * 3. Distribute ceil(n / P)-element chunks with MPI_Scatterv (point-to-point
+ *    pieces once offsets pass INT_MAX); the last rank(s) pad their short
+ *    block locally (with --mpi-io each rank reads its own chunk instead)
  * 4. Each process sorts its local chunk
- * 5. Gather all sorted chunks back to rank 0
- * 6. Rank 0 merges all chunks into final sorted array
+ * 5. Ranks run the bitonic compare-split network with their hypercube
+ *    partners (or gather to rank 0 and merge there with --rank0-merge, or
+ *    redistribute once by splitters with --sample-sort)
+ * 6. Optionally gather the globally sorted blocks to rank 0 (with --mpi-io
+ *    each rank writes its block instead)
  * 7. Output results and timing information
  */
 int main(int argc, char **argv)
 {
-    // Step 1: Initialize MPI
-    MPI_Init(&argc, &argv);
+    // Step 1: Initialize MPI (only the master thread of a rank calls MPI)
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
 
     int rank, world_size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);      // Get this process's rank (ID)
     MPI_Comm_size(MPI_COMM_WORLD, &world_size); // Get total number of processes
 
-    if (argc < 2)
+    const char *input_path = NULL;
+    int rank0_merge = 0;
+    int gather = 1;
+    int hybrid = 0;
+    const char *local_engine = NULL;
+    const char *output_name = "text";
+    const char *key_name = "int32";
+    const char *payload_name = "none";
+    int mpi_io = 0;
+    long long topk = 0;
+    int sample_sort = 0;
+    for (int a = 1; a < argc; ++a)
+    {
+        if (strcmp(argv[a], "--hybrid") == 0)
+            hybrid = 1;
+        else if (strcmp(argv[a], "--rank0-merge") == 0)
+            rank0_merge = 1;
+        else if (strcmp(argv[a], "--no-gather") == 0)
+            gather = 0;
+        else if (strncmp(argv[a], "--local-sort=", 13) == 0)
+            local_engine = argv[a] + 13;
+        else if (strcmp(argv[a], "--mpi-io") == 0)
+            mpi_io = 1;
+        else if (strcmp(argv[a], "--sample-sort") == 0)
+            sample_sort = 1;
+        else if (strncmp(argv[a], "--output=", 9) == 0)
+            output_name = argv[a] + 9;
+        else if (strncmp(argv[a], "--key=", 6) == 0)
+            key_name = argv[a] + 6;
+        else if (strncmp(argv[a], "--payload=", 10) == 0)
+            payload_name = argv[a] + 10;
+        else if (strncmp(argv[a], "--top-k=", 8) == 0)
+        {
+            char *end;
+            topk = strtoll(argv[a] + 8, &end, 10);
+            if (*end || topk <= 0)
+            {
+                input_path = NULL;
+                break;
+            }
+        }
+        else if (!input_path && argv[a][0] != '-')
+            input_path = argv[a];
+        else
+        {
+            input_path = NULL;  // Unknown option: print usage
+            break;
+        }
+    }
+
+    if (!input_path)
     {
         if (rank == 0)
         {
-            fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+            fprintf(stderr, "Usage: %s <input_file> [--hybrid] [--rank0-merge] [--no-gather] [--local-sort=ENGINE] [--output=text|binary|none] [--mpi-io] [--key=int32|int64|uint64|float|double] [--payload=none|index32|index64] [--top-k=K] [--sample-sort]\n", argv[0]);
         }
         MPI_Finalize();
         return 1;
     }
 
-    int *global_data = NULL;
-    int original_count = 0;
-    int padded_count = 0;
+    if (!local_engine)
+    {
+        local_engine = hybrid ? "openmp" : "radix";
+    }
 
-    // Step 2: Rank 0 reads input and prepares data
-    if (rank == 0)
+    if (!bitonic_dist_engine_valid(local_engine))
     {
-        original_count = read_input_rank0(argv[1], &global_data);
-        if (original_count <= 0)
+        if (rank == 0)
         {
-            MPI_Abort(MPI_COMM_WORLD, 1);
+            fprintf(stderr, "Unknown local sort engine '%s'\n", local_engine);
         }
+        MPI_Finalize();
+        return 1;
+    }
 
-        // Calculate padded size: must be power of 2 AND divisible by world_size
-        padded_count = next_power_of_two(original_count);
-        while (padded_count % world_size != 0)
+    bitonic_output_format output_format;
+    if (bitonic_parse_output_format(output_name, &output_format) != 0)
+    {
+        if (rank == 0)
         {
-            padded_count <<= 1;  // Keep doubling until divisible
+            fprintf(stderr, "Unknown output format '%s'\n", output_name);
         }
+        MPI_Finalize();
+        return 1;
+    }
 
-        // Pad array with INT_MAX (so padding sorts to the end)
-        int required = padded_count - original_count;
-        int *tmp = realloc(global_data, padded_count * sizeof(int));
-        if (!tmp)
+    bitonic_key_type key;
+    bitonic_payload_type payload;
+    if (bitonic_key_parse(key_name, &key) != 0 || bitonic_payload_parse(payload_name, &payload) != 0)
+    {
+        if (rank == 0)
         {
-            free(global_data);
-            fprintf(stderr, "Memory allocation failed\n");
-            MPI_Abort(MPI_COMM_WORLD, 1);
+            fprintf(stderr, "Unknown key type '%s' or payload '%s'\n", key_name, payload_name);
         }
-        global_data = tmp;
-        for (int i = 0; i < required; ++i)
+        MPI_Finalize();
+        return 1;
+    }
+    int typed = (key != BITONIC_KEY_INT32 || payload != BITONIC_PAYLOAD_NONE);
+    const char *option_error = NULL;
+    if (typed && mpi_io)
+        option_error = "--mpi-io supports int32 keys without payload only";
+    else if (typed && topk)
+        option_error = "--top-k supports int32 keys without payload only";
+    else if (typed && sample_sort)
+        option_error = "--sample-sort supports int32 keys without payload only";
+    else if (sample_sort && (topk || rank0_merge))
+        option_error = "--sample-sort replaces the merge; it does not combine with --top-k or --rank0-merge";
+    else if (payload != BITONIC_PAYLOAD_NONE && output_format == BITONIC_OUTPUT_BINARY)
+        option_error = "Binary output holds keys only; use --output=text with --payload";
+    if (option_error)
+    {
+        if (rank == 0)
         {
-            global_data[original_count + i] = INT_MAX;
+            fprintf(stderr, "%s\n", option_error);
         }
+        MPI_Finalize();
+        return 1;
     }
 
-    // Step 3: Broadcast counts to all processes
-    MPI_Bcast(&original_count, 1, MPI_INT, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&padded_count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    // Threads per rank for the exchange rounds (1 = pipelined single-thread merge)
+    int exchange_threads = hybrid ? omp_get_max_threads() : 1;
+    if (hybrid && thread_support < MPI_THREAD_FUNNELED)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "MPI library lacks MPI_THREAD_FUNNELED; exchanges stay single-threaded\n");
+        }
+        exchange_threads = 1;
+    }
 
-    // Step 4: Allocate local buffer for this process's chunk
-    int local_n = padded_count / world_size;  // Each process gets equal chunk
-    int *local_data = malloc(local_n * sizeof(int));
-    if (!local_data)
+    if (topk)
     {
-        fprintf(stderr, "Rank %d failed to allocate local buffer\n", rank);
+        rank0_merge = 0;  // The top-k tree replaces the merge and runs on any process count
+    }
+
+    // The exchange network pairs ranks across hypercube dimensions
+    if (!topk && !sample_sort && !rank0_merge && (world_size & (world_size - 1)) != 0)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Process count %d is not a power of 2; using rank-0 merge\n", world_size);
+        }
+        rank0_merge = 1;
+    }
+    if (rank0_merge && mpi_io)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "--mpi-io needs the exchange network (power-of-2 process count, no --rank0-merge) or --sample-sort\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    if (rank0_merge)
+    {
+        gather = 1;  // The rank-0 merge needs every chunk on rank 0
+    }
+    if (mpi_io || topk)
+    {
+        gather = 0;  // Every rank writes its own partition, or rank 0 only the top k
+    }
+
+    // Library context: this rank's OpenMP team and reusable scratch
+    bitonic_context *ctx = bitonic_context_create(0);
+    if (!ctx)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
-    // Step 5: Distribute data chunks to all processes
-    MPI_Scatter(global_data, local_n, MPI_INT, local_data, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+    if (typed)
+    {
+        int status = sort_records(ctx, input_path, bitonic_key_ops_for(key, payload), rank, world_size,
+                                  rank0_merge, gather, output_format);
+        bitonic_context_destroy(ctx);
+        MPI_Finalize();
+        return status == 0 ? 0 : 1;
+    }
+
+    int *global_data = NULL;
+    long long original_count = 0;
+    long long local_n = 0;
+    bitonic_trace_mark trace;
+    int *local_data = NULL;
+    long long *counts = malloc(world_size * sizeof(long long));
+    long long *displs = malloc(world_size * sizeof(long long));
+    if (!counts || !displs)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    if (mpi_io)
+    {
+        // Steps 2-5 with MPI-IO: every rank reads only its own chunk
+        if (bitonic_dist_read_partition(ctx, MPI_COMM_WORLD, input_path, &local_data, &local_n, &original_count) != 0)
+        {
+            bitonic_context_destroy(ctx);
+            MPI_Finalize();
+            return 1;
+        }
+        bitonic_dist_layout(original_count, local_n, world_size, counts, displs);
+    }
+    else
+    {
+        // Step 2: Rank 0 reads input
+        if (rank == 0)
+        {
+            void *values = NULL;
+            original_count = bitonic_read(ctx, input_path, &bitonic_int_codec, &values);
+            global_data = values;
+            if (original_count <= 0)
+            {
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+
+        // Step 3: Broadcast the count; every rank derives the same layout
+        bitonic_trace_begin(BITONIC_PHASE_DISTRIBUTE, &trace);
+        MPI_Bcast(&original_count, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+        local_n = bitonic_dist_chunk(original_count, world_size);
+        bitonic_dist_layout(original_count, local_n, world_size, counts, displs);
+
+        // Step 4: Allocate local buffer for this process's chunk
+        local_data = malloc((size_t)local_n * sizeof(int));
+        if (!local_data)
+        {
+            fprintf(stderr, "Rank %d failed to allocate local buffer\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        // Pages land on the nodes of the threads that sort them (hybrid mode)
+        bitonic_context_first_touch(ctx, local_data, local_n, sizeof(int));
+
+        // Step 5: Distribute the real values (uneven counts), then pad the
+        // short blocks locally with INT_MAX so they sort to the end
+        bitonic_dist_scatterv(MPI_COMM_WORLD, global_data, counts, displs, local_data, MPI_INT, 0);
+        bitonic_trace_end(BITONIC_PHASE_DISTRIBUTE, &trace);
+        bitonic_trace_begin(BITONIC_PHASE_PAD, &trace);
+        for (long long i = counts[rank]; i < local_n; ++i)
+        {
+            local_data[i] = INT_MAX;
+        }
+        bitonic_trace_end(BITONIC_PHASE_PAD, &trace);
+
+        // The input copy on rank 0 is no longer needed
+        free(global_data);
+        global_data = NULL;
+    }
 
     // Step 6: Start timing after data distribution
     MPI_Barrier(MPI_COMM_WORLD);
     double start = MPI_Wtime();
 
-    // Step 7: Each process independently sorts its local data
-    bitonic_sort_recursive(local_data, 0, local_n, 1);
-
-    // Step 8: Gather all sorted chunks back to rank 0
-    // All processes send their sorted data to rank 0, which will merge them
-    int *all_data = NULL;
-    if (rank == 0)
+    // With --top-k the selection tree replaces steps 7-10
+    int *top = NULL;
+    long long top_n = 0;
+    if (topk)
     {
-        all_data = malloc(padded_count * sizeof(int));
-        if (!all_data)
+        if (topk > original_count)
+        {
+            topk = original_count;  // Only padding lies beyond the real values
+        }
+        if (rank == 0 && !(top = malloc((size_t)topk * sizeof(int))))
         {
             fprintf(stderr, "Memory allocation failed\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
+        top_n = bitonic_dist_topk(ctx, MPI_COMM_WORLD, local_data, local_n, topk, top);
     }
 
-    MPI_Gather(local_data, local_n, MPI_INT, all_data, local_n, MPI_INT, 0, MPI_COMM_WORLD);
-
-    // Step 9: Rank 0 merges all sorted chunks
-    if (rank == 0)
+    // With --sample-sort one splitter-based redistribution replaces steps 7-8;
+    // the sorted blocks differ in length, so every rank collects the new counts
+    if (sample_sort)
     {
-        // Allocate temporary buffer for merge operations
-        int *temp_buf = malloc(padded_count * sizeof(int));
-        if (!temp_buf)
+        int *sorted = NULL;
+        if (bitonic_dist_sample_sort(ctx, MPI_COMM_WORLD, local_data, counts[rank], local_engine, &sorted,
+                                     &local_n) != 0)
         {
-            fprintf(stderr, "Memory allocation failed\n");
+            fprintf(stderr, "Memory allocation failed during local sort\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
-
-        // Iteratively merge sorted chunks (merge sort approach)
-        // Start with chunks of size local_n, double merge_width each iteration
-        int *current = all_data;
-        int *next = temp_buf;
-
-        for (int merge_width = local_n; merge_width < padded_count; merge_width *= 2)
+        free(local_data);
+        local_data = sorted;
+        MPI_Allgather(&local_n, 1, MPI_LONG_LONG, counts, 1, MPI_LONG_LONG, MPI_COMM_WORLD);
+        long long at = 0;
+        for (int r = 0; r < world_size; at += counts[r++])
         {
-            int res_idx = 0;
-            // Merge pairs of sorted subarrays
-            for (int base = 0; base < padded_count; base += 2 * merge_width)
-            {
-                int left_end = base + merge_width;
-                int right_end = (base + 2 * merge_width < padded_count) ? base + 2 * merge_width : padded_count;
-                if (left_end > padded_count)
-                    left_end = padded_count;
-
-                // Merge two sorted subarrays: [base, left_end) and [left_end, right_end)
-                int l = base, r = left_end;
-                while (l < left_end && r < right_end)
-                {
-                    if (current[l] <= current[r])
-                    {
-                        next[res_idx++] = current[l++];
-                    }
-                    else
-                    {
-                        next[res_idx++] = current[r++];
-                    }
-                }
-                // Copy remaining elements
-                while (l < left_end)
-                    next[res_idx++] = current[l++];
-                while (r < right_end)
-                    next[res_idx++] = current[r++];
-            }
-
-            // Swap buffers (avoid copying entire array)
-            int *swap = current;
-            current = next;
-            next = swap;
+            displs[r] = at;
         }
+    }
+
+    // Step 7: Each process independently sorts its local data
+    if (!topk && !sample_sort && bitonic_dist_local_sort(ctx, local_data, local_n, local_engine) != 0)
+    {
+        fprintf(stderr, "Memory allocation failed during local sort\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Step 8: Globally order the blocks with the compare-split network
+    if (!topk && !sample_sort && !rank0_merge)
+    {
+        bitonic_dist_exchange(ctx, MPI_COMM_WORLD, local_data, local_n, exchange_threads);
+    }
 
-        // Copy result back to all_data if needed
-        if (current != all_data)
+    // Step 9: Optionally gather all sorted chunks back to rank 0 (only the
+    // real values: each rank's padding is at the end of its sorted block)
+    int *all_data = NULL;
+    if (gather && rank == 0)
+    {
+        all_data = malloc((size_t)original_count * sizeof(int));
+        if (!all_data)
         {
-            memcpy(all_data, current, padded_count * sizeof(int));
+            fprintf(stderr, "Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
+    }
 
-        free(temp_buf);
+    if (gather)
+    {
+        bitonic_trace_begin(BITONIC_PHASE_GATHER, &trace);
+        bitonic_dist_gatherv(MPI_COMM_WORLD, local_data, all_data, counts, displs, MPI_INT, 0);
+        bitonic_trace_end(BITONIC_PHASE_GATHER, &trace);
     }
 
-    // Step 10: Stop timing and synchronize all processes
+    // Step 10: With --rank0-merge, rank 0 merges all sorted chunks
+    if (rank0_merge && rank == 0 && bitonic_dist_merge_rank0(ctx, all_data, original_count, local_n) != 0)
+    {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // Step 11: Stop timing and synchronize all processes
     MPI_Barrier(MPI_COMM_WORLD);
     double end = MPI_Wtime();
 
-    int *gathered = NULL;
-    if (rank == 0)
+    int verified = (gather || topk) ? 1 : bitonic_dist_verify(MPI_COMM_WORLD, local_data, local_n);
+
+    // Step 12: Write output (each rank its own partition with --mpi-io) and
+    // display results on rank 0
+    if (mpi_io && sample_sort && output_format != BITONIC_OUTPUT_NONE)
     {
-        gathered = all_data;
+        bitonic_dist_write_blocks(ctx, MPI_COMM_WORLD, bitonic_output_path("mpi", output_format), local_data, local_n,
+                                  output_format);
+    }
+    else if (mpi_io && !topk && output_format != BITONIC_OUTPUT_NONE)
+    {
+        bitonic_dist_write_partition(ctx, MPI_COMM_WORLD, bitonic_output_path("mpi", output_format), local_data,
+                                     local_n, original_count, output_format);
     }
-
-    // Step 11: Rank 0 writes output and displays results
     if (rank == 0)
     {
-        // Write sorted output (excluding padding elements)
-        write_output_rank0("OutputFiles/mpi_output.txt", gathered, original_count);
-        
+        if (gather)
+        {
+            // Write sorted output (excluding padding elements)
+            bitonic_write(ctx, bitonic_output_path("mpi", output_format), &bitonic_int_codec, all_data,
+                          original_count, output_format);
+        }
+        else if (topk)
+        {
+            bitonic_write(ctx, bitonic_output_path("mpi", output_format), &bitonic_int_codec, top, top_n,
+                          output_format);
+        }
+
         // Display performance metrics
         printf("Processes: %d\n", world_size);
+        printf("Threads per rank: %d\n", omp_get_max_threads());
+        printf("Merge: %s\n", topk          ? "top-k tree"
+                               : sample_sort ? "sample sort"
+                               : rank0_merge ? "rank 0"
+                                             : "exchange network");
+        if (!topk)
+        {
+            printf("Local sort: %s\n", local_engine);
+        }
+        printf("I/O: %s\n", mpi_io ? "MPI-IO" : "rank 0");
+        if (topk)
+        {
+            printf("Top-k: %lld\n", topk);
+        }
+        else if (!gather)
+        {
+            printf("Distributed result verified: %s\n", verified ? "yes" : "no");
+        }
+        bitonic_arena_stats stats;
+        bitonic_context_stats(ctx, &stats);
+        printf("Scratch peak (bytes): %zu\n", stats.peak);  // Rank 0's arena high-water mark
         printf("Execution time (s): %.6f\n", end - start);
-        
-        free(gathered);
+
+        free(all_data);
+        free(top);
     }
 
-    // Step 12: Clean up and finalize
+    // With BITONIC_TRACE set, rank 0 writes the phase breakdown of all ranks
+    bitonic_dist_trace_report(MPI_COMM_WORLD, "mpi");
+
+    // Step 13: Clean up and finalize
     free(local_data);
-    free(global_data);
+    free(counts);
+    free(displs);
+    bitonic_context_destroy(ctx);
 
     MPI_Finalize();
     return 0;
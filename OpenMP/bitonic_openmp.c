@@ -1,233 +1,301 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <limits.h>
+#include <string.h>
 #include <omp.h>
 
-/**
- * Function: next_power_of_two
- * ----------------------------
- * Calculates the next power of 2 greater than or equal to n.
- * This is needed because bitonic sort requires array size to be a power of 2.
+#include "../lib/bitonic.h"
+#include "../lib/bitonic_simd.h"
+#include "../lib/bitonic_trace.h"
 
+/**
+ * Function: parse_size
+ * --------------------
+ * Parses a byte count with an optional K, M or G (binary) suffix.
+ * Returns 0 on success, -1 for an invalid or zero size.
  */
-static int next_power_of_two(int n)
+static int parse_size(const char *text, size_t *bytes)
 {
-    int p = 1;
-    while (p < n)
-    {
-        p <<= 1;  // Left shift is equivalent to multiplying by 2
-    }
-    return p;
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    int shift = 0;
+    if (end == text)
+        return -1;
+    if (*end == 'K' || *end == 'k')
+        shift = 10;
+    else if (*end == 'M' || *end == 'm')
+        shift = 20;
+    else if (*end == 'G' || *end == 'g')
+        shift = 30;
+    if (shift)
+        ++end;
+    if (*end != '\0' || value == 0 || value > (SIZE_MAX >> shift))
+        return -1;
+    *bytes = (size_t)(value << shift);
+    return 0;
 }
 
 /**
- * Function: read_input
+ * Function: merge_into
  * --------------------
- * Reads integer values from an input file and stores them in a dynamically allocated array.
- * Uses dynamic memory allocation that grows as needed (starts at 1024, doubles when full).
- * 
- * @param path: Path to the input file containing integers
- * @param out_data: Pointer to store the allocated array of integers
- * @return: Number of integers read, or -1 on error
- * 
- * Purpose: Loads the dataset to be sorted from file into memory
+ * --merge-into mode: reads the new values from delta_path and the already
+ * sorted values from sorted_path (text or binary, e.g. an earlier
+ * openmp_output), sorts only the new values and merges them into the
+ * sorted ones with bitonic_merge_sorted, then writes the merged output.
+ * The timed part is the delta sort plus the merge. Returns the exit status.
  */
-static int read_input(const char *path, int **out_data)
+static int merge_into(bitonic_context *ctx, const char *delta_path, const char *sorted_path,
+                      bitonic_output_format output_format)
 {
-    FILE *fp = fopen(path, "r");
-    if (!fp)
+    void *delta = NULL, *sorted = NULL;
+    long long delta_n = bitonic_read(ctx, delta_path, &bitonic_int_codec, &delta);
+    long long sorted_n = (delta_n >= 0) ? bitonic_read(ctx, sorted_path, &bitonic_int_codec, &sorted) : -1;
+    if (delta_n < 0 || sorted_n < 0)
     {
-        perror("Failed to open input file");
-        return -1;
+        fprintf(stderr, "Failed to read '%s'\n", (delta_n < 0) ? delta_path : sorted_path);
+        free(delta);
+        free(sorted);
+        return 1;
     }
 
-    int capacity = 1024;  // Initial capacity
-    int size = 0;         // Current number of elements
-    int *buffer = malloc(capacity * sizeof(int));
-    if (!buffer)
+    // Either side may be empty: an empty batch writes the sorted file back
+    // unchanged, an empty sorted file gets the sorted batch
+    int *merged = malloc((size_t)(sorted_n + delta_n + 1) * sizeof(int));
+    if (!merged)
     {
-        fclose(fp);
         fprintf(stderr, "Memory allocation failed\n");
-        return -1;
-    }
-
-    while (1)
-    {
-        int value;
-        int scanned = fscanf(fp, "%d", &value);
-        if (scanned == 1)
-        {
-            // If buffer is full, double its capacity
-            if (size == capacity)
-            {
-                capacity *= 2;
-                int *tmp = realloc(buffer, capacity * sizeof(int));
-                if (!tmp)
-                {
-                    free(buffer);
-                    fclose(fp);
-                    fprintf(stderr, "Memory allocation failed\n");
-                    return -1;
-                }
-                buffer = tmp;
-            }
-            buffer[size++] = value;
-        }
-        else if (scanned == EOF)
-        {
-            break;  // End of file reached
-        }
-        else
-        {
-            free(buffer);
-            fclose(fp);
-            fprintf(stderr, "Invalid data in input file\n");
-            return -1;
-        }
+        free(delta);
+        free(sorted);
+        return 1;
     }
+    bitonic_context_first_touch(ctx, merged, sorted_n + delta_n, sizeof(int));
 
-    fclose(fp);
-    *out_data = buffer;
-    return size;
-}
-
-/**
- * Function: write_output
- * ----------------------
- * Writes the sorted array to an output file.
- * Numbers are written on a single line, separated by spaces.
- * 
- * @param path: Path to the output file
- * @param data: Pointer to the sorted array of integers
- * @param count: Number of elements to write (excludes padding)
- * 
- * Purpose: Saves the sorted result to a file for verification
- */
-static void write_output(const char *path, const int *data, int count)
-{
-    FILE *fp = fopen(path, "w");
-    if (!fp)
+    double start = omp_get_wtime();
+    int status = bitonic_merge_sorted(ctx, sorted, sorted_n, delta, delta_n, merged);
+    double end = omp_get_wtime();
+    if (status == 0)
     {
-        perror("Failed to open output file");
-        return;
+        printf("Dataset size: %lld\n", sorted_n + delta_n);
+        printf("Keys: int32\n");
+        printf("Threads: %d\n", bitonic_context_team(ctx, sorted_n + delta_n));
+        printf("Merged into: %lld sorted values\n", sorted_n);
+        printf("New values: %lld\n", delta_n);
+        printf("Execution time (s): %.6f\n", end - start);
+        status = bitonic_write(ctx, bitonic_output_path("openmp", output_format), &bitonic_int_codec, merged,
+                               sorted_n + delta_n, output_format);
+        bitonic_trace_report("openmp", 1, NULL, NULL);
     }
-
-    for (int i = 0; i < count; ++i)
+    else
     {
-        // Write number, add space unless it's the last element
-        fprintf(fp, "%d%s", data[i], (i + 1 == count) ? "" : " ");
+        fprintf(stderr, "'%s' is not sorted ascending (or memory ran out); --merge-into needs a sorted file\n",
+                sorted_path);
     }
-    fprintf(fp, "\n");
-    fclose(fp);
-}
 
-/**
- * Function: bitonic_sort
- * ----------------------
- * Implements the parallel bitonic sort algorithm using OpenMP.
- * Bitonic sort works by repeatedly building and merging bitonic sequences.
- * 
- * Algorithm:
- * - Outer loop (k): Controls the size of bitonic sequences (2, 4, 8, ..., n)
- * - Middle loop (j): Controls the comparison distance within each sequence
- * - Inner loop (i): Performs parallel comparisons and swaps
- * 
- * - XOR operation (^) determines which elements to compare
- * - Bitwise AND (&) determines if sorting ascending or descending
- * - Elements are swapped if they're in wrong order relative to direction
- */
-static void bitonic_sort(int *data, int n)
-{
-    // k represents the size of bitonic sequences being built
-    for (int k = 2; k <= n; k <<= 1)
-    {
-        // j represents the comparison distance
-        for (int j = k >> 1; j > 0; j >>= 1)
-        {
-            // Parallelize the comparison loop - each thread handles different indices
-#pragma omp parallel for schedule(static)
-            for (int i = 0; i < n; ++i)
-            {
-                int ixj = i ^ j;  // XOR gives the partner index to compare with
-                if (ixj > i)      // Only process each pair once
-                {
-                    // Determine sort direction: ascending (1) or descending (0)
-                    int ascending = ((i & k) == 0);
-                    // Swap if elements are in wrong order for this direction
-                    if ((data[i] > data[ixj]) == ascending)
-                    {
-                        int tmp = data[i];
-                        data[i] = data[ixj];
-                        data[ixj] = tmp;
-                    }
-                }
-            }
-        }
-    }
+    free(merged);
+    free(sorted);
+    free(delta);
+    return (status == 0) ? 0 : 1;
 }
 
 /**
  * Function: main
  * --------------
- * Main entry point for the OpenMP parallel bitonic sort program.
+ * Main entry point for the OpenMP parallel bitonic sort program, a thin
+ * driver over libbitonic (lib/bitonic.h).
+ *
+ * Usage: bitonic_openmp <input_file> [--output=text|binary|none]
+ *                       [--key=int32|int64|uint64|float|double]
+ *                       [--payload=none|index32|index64]
+ *                       [--engine=flat|blocks|tasks] [--memory=SIZE] [--top-k=K]
+ *                       [--merge-into=SORTED_FILE]
  * 
  * Steps:
  * 1. Read input data from file
- * 2. Pad array to next power of 2 (required for bitonic sort)
- * 3. Perform parallel bitonic sort using OpenMP threads
- * 4. Measure and display execution time
- * 5. Write sorted output to file
+ * 2. Perform parallel bitonic sort using OpenMP threads (the network handles
+ *    any size, so no padding is added). Plain int32 keys use the SIMD engine;
+ *    other key types and key + index records use their specialization from
+ *    lib/bitonic_keys.c
+ * 3. Measure and display execution time
+ * 4. Write sorted output to file
  * Note: Number of threads used is controlled by OMP_NUM_THREADS environment variable
+ *
+ * --memory=SIZE (bytes, with an optional K, M or G suffix) sorts a binary
+ * int input of any size out of core within that buffer budget
+ * (bitonic_sort_file): sorted runs are spilled to disk and merged into the
+ * output, and the reported time includes all of that I/O.
+ *
+ * --top-k=K writes only the K smallest int values (bitonic_topk): one
+ * parallel pass keeps a k-sized bitonic buffer per thread instead of
+ * sorting the whole input.
+ *
+ * --merge-into=SORTED_FILE treats the input as new values for an already
+ * sorted int file (merge_into): only the new values are sorted, and one
+ * parallel merge adds them to the sorted ones, so an update costs the
+ * delta's sort plus a linear pass instead of a full re-sort.
  */
 int main(int argc, char **argv)
 {
-    if (argc < 2)
+    bitonic_output_format output_format = BITONIC_OUTPUT_TEXT;
+    bitonic_key_type key = BITONIC_KEY_INT32;
+    bitonic_payload_type payload = BITONIC_PAYLOAD_NONE;
+    const char *engine_name = NULL;  // NULL: BITONIC_BLOCK_SWAP default
+    bitonic_engine engine = BITONIC_ENGINE_FLAT;
+    size_t memory = 0;  // 0: in-memory sort
+    long long topk = 0; // 0: full sort
+    const char *merge_path = NULL;  // NULL: sort the whole input
+    int bad_option = 0;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--output=", 9) == 0)
+            bad_option |= bitonic_parse_output_format(argv[i] + 9, &output_format) != 0;
+        else if (strncmp(argv[i], "--key=", 6) == 0)
+            bad_option |= bitonic_key_parse(argv[i] + 6, &key) != 0;
+        else if (strncmp(argv[i], "--payload=", 10) == 0)
+            bad_option |= bitonic_payload_parse(argv[i] + 10, &payload) != 0;
+        else if (strncmp(argv[i], "--engine=", 9) == 0)
+            bad_option |= bitonic_engine_parse(engine_name = argv[i] + 9, &engine) != 0;
+        else if (strncmp(argv[i], "--memory=", 9) == 0)
+            bad_option |= parse_size(argv[i] + 9, &memory) != 0;
+        else if (strncmp(argv[i], "--top-k=", 8) == 0)
+        {
+            char *end;
+            topk = strtoll(argv[i] + 8, &end, 10);
+            bad_option |= (*end != '\0' || topk <= 0);
+        }
+        else if (strncmp(argv[i], "--merge-into=", 13) == 0)
+            bad_option |= *(merge_path = argv[i] + 13) == '\0';
+        else
+            bad_option = 1;  // Unknown option: print usage
+    }
+    if (argc < 2 || bad_option)
     {
-        fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+        fprintf(stderr,
+                "Usage: %s <input_file> [--output=text|binary|none] "
+                "[--key=int32|int64|uint64|float|double] [--payload=none|index32|index64] "
+                "[--engine=flat|blocks|tasks] [--memory=SIZE] [--top-k=K] [--merge-into=SORTED_FILE]\n",
+                argv[0]);
+        return 1;
+    }
+    if (payload != BITONIC_PAYLOAD_NONE && output_format == BITONIC_OUTPUT_BINARY)
+    {
+        fprintf(stderr, "Binary output holds keys only; use --output=text with --payload\n");
+        return 1;
+    }
+    if (memory > 0 && (key != BITONIC_KEY_INT32 || payload != BITONIC_PAYLOAD_NONE))
+    {
+        fprintf(stderr, "--memory sorts int32 keys without payload only\n");
+        return 1;
+    }
+    if (topk > 0 && (memory > 0 || key != BITONIC_KEY_INT32 || payload != BITONIC_PAYLOAD_NONE))
+    {
+        fprintf(stderr, "--top-k selects in-memory int32 keys without payload only\n");
+        return 1;
+    }
+    if (merge_path && (memory > 0 || topk > 0 || key != BITONIC_KEY_INT32 || payload != BITONIC_PAYLOAD_NONE))
+    {
+        fprintf(stderr, "--merge-into merges in-memory int32 keys without payload only\n");
         return 1;
     }
 
-    // Step 1: Read input data
-    int *values = NULL;
-    int count = read_input(argv[1], &values);
-    if (count <= 0)
+    // The context spawns the OMP_NUM_THREADS team once, up front
+    bitonic_context *ctx = bitonic_context_create(0);
+    if (!ctx)
     {
+        fprintf(stderr, "Memory allocation failed\n");
         return 1;
     }
+    if (engine_name)
+        bitonic_context_set_engine(ctx, engine);
 
-    // Step 2: Pad to next power of 2 if needed
-    int padded = next_power_of_two(count);
-    if (padded != count)
+    if (merge_path)
     {
-        int *tmp = realloc(values, padded * sizeof(int));
-        if (!tmp)
-        {
-            free(values);
-            fprintf(stderr, "Memory allocation failed\n");
-            return 1;
-        }
-        values = tmp;
-        // Fill padding with INT_MAX so they sort to the end
-        for (int i = count; i < padded; ++i)
+        int status = merge_into(ctx, argv[1], merge_path, output_format);
+        bitonic_context_destroy(ctx);
+        return status;
+    }
+
+    if (memory > 0)
+    {
+        // Out of core: read, sort, spill and merge in one timed call
+        bitonic_extsort_stats stats;
+        double start = omp_get_wtime();
+        long long sorted = bitonic_sort_file(ctx, argv[1], bitonic_output_path("openmp", output_format),
+                                             output_format, memory, &stats);
+        double end = omp_get_wtime();
+        if (sorted >= 0)
         {
-            values[i] = INT_MAX; // sentinel to keep padding at the end
+            printf("Dataset size: %lld\n", sorted);
+            printf("Keys: int32\n");
+            printf("Threads: %d\n", bitonic_context_threads(ctx));
+            printf("Engine: %s\n", bitonic_engine_name(bitonic_context_engine(ctx)));
+            printf("Runs: %d\n", stats.runs);
+            printf("Merge passes: %d\n", stats.passes);
+            printf("Execution time (s): %.6f\n", end - start);
         }
+        bitonic_trace_report("openmp", 1, NULL, NULL);
+        bitonic_context_destroy(ctx);
+        return (sorted >= 0) ? 0 : 1;
+    }
+
+    // Step 1: Read input data
+    const bitonic_key_ops *ops = bitonic_key_ops_for(key, payload);
+    int native = (key == BITONIC_KEY_INT32 && payload == BITONIC_PAYLOAD_NONE);
+    void *values = NULL;
+    long long count = bitonic_read(ctx, argv[1], ops->codec, &values);  // Text or binary, parsed in parallel
+    if (count <= 0)
+    {
+        bitonic_context_destroy(ctx);
+        return 1;
     }
+    ops->number(values, count);  // Payload = input position (no-op for plain keys)
 
-    // Step 3: Sort with timing
+    // Step 2: Sort with timing (any size: no padding to a power of 2); with
+    // --top-k only the k smallest values are selected, into 'top'
+    int *top = NULL;
+    long long written = count;
+    if (topk > 0)
+    {
+        written = (topk < count) ? topk : count;
+        top = malloc((size_t)written * sizeof(int));
+    }
     double start = omp_get_wtime();  // Start timing
-    bitonic_sort(values, padded);    // Perform parallel sort
+    int status;
+    if (topk > 0)
+        status = top ? (bitonic_topk(ctx, values, count, written, top) < 0) : -1;
+    else
+        status = bitonic_sort(ctx, values, count, key, payload);  // SIMD engine or type-specialized network
     double end = omp_get_wtime();    // End timing
+    if (status != 0)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        free(top);
+        free(values);
+        bitonic_context_destroy(ctx);
+        return 1;
+    }
 
-    // Step 4: Display results
-    int threads_used = omp_get_max_threads();
-    printf("Dataset size: %d\n", count);
+    // Step 3: Display results
+    int threads_used = bitonic_context_team(ctx, count);
+    printf("Dataset size: %lld\n", count);
+    printf("Keys: %s\n", ops->name);
     printf("Threads: %d\n", threads_used);
+    if (native)
+    {
+        printf("Engine: %s\n", bitonic_engine_name(bitonic_context_engine(ctx)));
+        printf("SIMD kernel: %s\n", bitonic_simd_isa());
+        printf("Cache tile: %d\n", bitonic_context_tile(ctx, count));  // 0 = unblocked
+    }
+    if (topk > 0)
+        printf("Top-k: %lld\n", written);
     printf("Execution time (s): %.6f\n", end - start);
 
-    // Step 5: Write sorted output (excluding padding)
-    write_output("OutputFiles/openmp_output.txt", values, count);
+    // Step 4: Write sorted output
+    status = bitonic_write(ctx, bitonic_output_path("openmp", output_format), ops->codec, top ? top : values,
+                           written, output_format);
+    bitonic_trace_report("openmp", 1, NULL, NULL);  // No-op unless BITONIC_TRACE is set
 
+    free(top);
     free(values);
-    return 0;
+    bitonic_context_destroy(ctx);
+    return (status == 0) ? 0 : 1;
 }
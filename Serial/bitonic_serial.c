@@ -1,84 +1,93 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include <limits.h>
 
-// Function to find next power of 2
-int next_pow2(int n) {
-    int p = 1;
-    while (p < n) p <<= 1;
-    return p;
-}
+#include "../lib/bitonic.h"
+#include "../lib/bitonic_simd.h"
+#include "../lib/bitonic_trace.h"
 
 // Serial Bitonic Sort
-void bitonicSort(int *arr, int n) {
-    for (int k = 2; k <= n; k <<= 1) {
-        for (int j = k >> 1; j > 0; j >>= 1) {
-            for (int i = 0; i < n; i++) {
-                int ij = i ^ j;
-                if (ij > i) {
-                    int ascending = ((i & k) == 0);
-                    if ((ascending && arr[i] > arr[ij]) ||
-                        (!ascending && arr[i] < arr[ij])) 
-                    {
-                        int temp = arr[i];
-                        arr[i] = arr[ij];
-                        arr[ij] = temp;
-                    }
-                }
-            }
-        }
-    }
-}
+// Thin driver over libbitonic (lib/bitonic.h) with a one-thread context: the
+// (k, j) network runs through the vectorized compare-exchange kernel, which
+// only visits the comparator pairs of each stage and skips those past n, so
+// any size works without padding.
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        printf("Usage: %s <input_file>\n", argv[0]);
+    // Optional --output=text|binary|none (default text),
+    // --key=int32|int64|uint64|float|double (default int32) and
+    // --payload=none|index32|index64 (default none)
+    bitonic_output_format format = BITONIC_OUTPUT_TEXT;
+    bitonic_key_type key = BITONIC_KEY_INT32;
+    bitonic_payload_type payload = BITONIC_PAYLOAD_NONE;
+    int bad_option = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (strncmp(argv[i], "--output=", 9) == 0)
+            bad_option |= bitonic_parse_output_format(argv[i] + 9, &format) != 0;
+        else if (strncmp(argv[i], "--key=", 6) == 0)
+            bad_option |= bitonic_key_parse(argv[i] + 6, &key) != 0;
+        else if (strncmp(argv[i], "--payload=", 10) == 0)
+            bad_option |= bitonic_payload_parse(argv[i] + 10, &payload) != 0;
+        else
+            bad_option = 1;
+    }
+    if (argc < 2 || bad_option) {
+        printf("Usage: %s <input_file> [--output=text|binary|none] "
+               "[--key=int32|int64|uint64|float|double] [--payload=none|index32|index64]\n", argv[0]);
         return 1;
     }
-
-    const char* input_path = argv[1];
-    FILE* fp = fopen(input_path, "r");
-    if (!fp) {
-        printf("Error opening input file!\n");
+    if (payload != BITONIC_PAYLOAD_NONE && format == BITONIC_OUTPUT_BINARY) {
+        printf("Binary output holds keys only; use --output=text with --payload\n");
         return 1;
     }
 
-    // Read input values
-    int cap = 1024, size = 0, val;
-    int *arr = malloc(cap * sizeof(int));
-    while (fscanf(fp, "%d", &val) == 1) {
-        if (size == cap) {
-            cap *= 2;
-            arr = realloc(arr, cap * sizeof(int));
-        }
-        arr[size++] = val;
+    bitonic_context *ctx = bitonic_context_create(1);
+    if (!ctx) {
+        printf("Memory allocation failed\n");
+        return 1;
     }
-    fclose(fp);
 
-    // Pad dataset
-    int padded = next_pow2(size);
-    arr = realloc(arr, padded * sizeof(int));
-    for (int i = size; i < padded; i++)
-        arr[i] = INT_MAX;
+    // Read input values (text or binary, see lib/bitonic_io.h). Plain int32
+    // keys take the int path; other types use their specialization from
+    // lib/bitonic_keys.c, with the input position as payload.
+    const bitonic_key_ops *ops = bitonic_key_ops_for(key, payload);
+    void *arr = NULL;
+    long long size = bitonic_read(ctx, argv[1], ops->codec, &arr);
+    if (size <= 0) {
+        printf("Error reading input file!\n");
+        bitonic_context_destroy(ctx);
+        return 1;
+    }
+    ops->number(arr, size);
 
     // Timing starts
     clock_t start = clock();
-    bitonicSort(arr, padded);
+    int status = bitonic_sort(ctx, arr, size, key, payload);
     clock_t end = clock();
+    if (status != 0) {
+        printf("Memory allocation failed\n");
+        free(arr);
+        bitonic_context_destroy(ctx);
+        return 1;
+    }
 
     double time_taken = (double)(end - start) / CLOCKS_PER_SEC;
 
-    system("mkdir -p OutputFiles");
-    FILE *out = fopen("OutputFiles/serial_output.txt", "w");
-    for (int i = 0; i < size; i++)
-        fprintf(out, "%d ", arr[i]);
-    fclose(out);
+    const char *out_path = bitonic_output_path("serial", format);
+    if (format != BITONIC_OUTPUT_NONE) {
+        system("mkdir -p OutputFiles");
+        status = bitonic_write(ctx, out_path, ops->codec, arr, size, format);
+    }
 
-    printf("Dataset size: %d (padded to %d)\n", size, padded);
+    printf("Dataset size: %lld\n", size);
+    printf("Keys: %s\n", ops->name);
+    printf("SIMD kernel: %s\n", bitonic_simd_isa());
     printf("Serial execution time: %.6f seconds\n", time_taken);
-    printf("Sorted output saved to OutputFiles/serial_output.txt\n");
+    if (format != BITONIC_OUTPUT_NONE && status == 0)
+        printf("Sorted output saved to %s\n", out_path);
+    bitonic_trace_report("serial", 1, NULL, NULL);
 
     free(arr);
-    return 0;
+    bitonic_context_destroy(ctx);
+    return (status == 0) ? 0 : 1;
 }
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds libbitonic (build/libbitonic.a and build/libbitonic.so) and, when
+# mpicc is available, its distributed part libbitonic_mpi. Applications
+# include lib/bitonic.h (and lib/bitonic_dist.h) and link, e.g.:
+#   gcc -fopenmp app.c -Ilib build/libbitonic.a
+#   mpicc -fopenmp app.c -Ilib build/libbitonic_mpi.a build/libbitonic.a
+CC=${CC:-cc}
+OMP_FLAGS=${OMP_FLAGS:--fopenmp}
+MPICC=${MPICC:-mpicc}
+OUT=${OUT:-build}
+CFLAGS="-O2 -std=c11 -fPIC"
+
+SRCS="lib/bitonic_simd.c lib/bitonic_cpu.c lib/bitonic_barrier.c lib/bitonic_omp.c lib/bitonic_local.c \
+    lib/bitonic_io.c lib/bitonic_keys.c lib/bitonic_numa.c lib/bitonic_arena.c lib/bitonic_context.c \
+    lib/bitonic_extsort.c lib/bitonic_trace.c lib/bitonic_adaptive.c"
+
+mkdir -p "$OUT/obj"
+
+echo "Building libbitonic..."
+objs=""
+for src in $SRCS; do
+    obj="$OUT/obj/$(basename "${src%.c}").o"
+    "$CC" $CFLAGS $OMP_FLAGS -c "$src" -o "$obj"
+    objs="$objs $obj"
+done
+rm -f "$OUT/libbitonic.a"
+ar rcs "$OUT/libbitonic.a" $objs
+"$CC" -shared $OMP_FLAGS $objs -o "$OUT/libbitonic.so"
+
+if command -v "$MPICC" > /dev/null 2>&1; then
+    echo "Building libbitonic_mpi..."
+    "$MPICC" $CFLAGS -fopenmp -c lib/bitonic_dist.c -o "$OUT/obj/bitonic_dist.o"
+    rm -f "$OUT/libbitonic_mpi.a"
+    ar rcs "$OUT/libbitonic_mpi.a" "$OUT/obj/bitonic_dist.o"
+    "$MPICC" -shared -fopenmp "$OUT/obj/bitonic_dist.o" -L"$OUT" -lbitonic -o "$OUT/libbitonic_mpi.so"
+fi
+
+echo "Libraries written to $OUT/"
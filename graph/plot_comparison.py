@@ -2,11 +2,105 @@
 """
 Bitonic Sort Performance Comparison
 Generates graphs comparing MPI, OpenMP, and CUDA implementations
+
+Usage:
+  python3 graph/plot_comparison.py                        # recorded sample runs below
+  python3 graph/plot_comparison.py OutputFiles/bench.csv  # bitonic_bench results (.csv or .json)
 """
 
+import csv
+import json
+import sys
+
 import matplotlib.pyplot as plt
 import numpy as np
 
+
+# ============================================================================
+# Benchmark harness results (Bench/bitonic_bench.c, run_bench.sh)
+# ============================================================================
+
+def load_bench(path):
+    """Rows of a bitonic_bench CSV or JSON file, with numeric fields converted."""
+    if path.endswith('.json'):
+        with open(path) as f:
+            rows = json.load(f)['results']
+    else:
+        with open(path, newline='') as f:
+            rows = list(csv.DictReader(f))
+    for row in rows:
+        for key in ('n', 'threads', 'warmup', 'repeat'):
+            row[key] = int(row[key])
+        for key in ('min_s', 'p10_s', 'median_s', 'p90_s', 'max_s', 'melem_per_s'):
+            row[key] = float(row[key])
+    return rows
+
+
+def plot_bench(rows, out_path='OutputFiles/bench_results.png'):
+    """Per distribution: median ns/element vs size for every engine and thread
+    count (shaded p10-p90), plus the median speedup over qsort."""
+    dists = list(dict.fromkeys(row['distribution'] for row in rows))
+    series = list(dict.fromkeys((row['engine'], row['threads']) for row in rows))
+    cols = 3
+    panels = len(dists) + 1
+    grid_rows = (panels + cols - 1) // cols
+    fig, axes = plt.subplots(grid_rows, cols, figsize=(6 * cols, 4.5 * grid_rows), squeeze=False)
+    axes = axes.flatten()
+
+    for ax, dist in zip(axes, dists):
+        for engine, threads in series:
+            points = sorted((r for r in rows if r['distribution'] == dist and r['engine'] == engine
+                             and r['threads'] == threads), key=lambda r: r['n'])
+            if not points:
+                continue
+            sizes = [r['n'] for r in points]
+            ax.plot(sizes, [r['median_s'] / r['n'] * 1e9 for r in points], 'o-', markersize=4,
+                    label=f'{engine} ({threads}t)')
+            ax.fill_between(sizes, [r['p10_s'] / r['n'] * 1e9 for r in points],
+                            [r['p90_s'] / r['n'] * 1e9 for r in points], alpha=0.2)
+        ax.set_xscale('log', base=2)
+        ax.set_yscale('log')
+        ax.set_xlabel('Elements', fontweight='bold')
+        ax.set_ylabel('Median time per element (ns)', fontweight='bold')
+        ax.set_title(f'{dist} input', fontweight='bold')
+        ax.grid(True, alpha=0.3)
+        ax.legend(fontsize=8)
+
+    # Speedup of every series over the qsort baseline, averaged over distributions
+    ax = axes[len(dists)]
+    baseline = {(r['distribution'], r['n']): r['median_s'] for r in rows if r['engine'] == 'qsort'}
+    for engine, threads in series:
+        if engine == 'qsort':
+            continue
+        by_size = {}
+        for r in rows:
+            key = (r['distribution'], r['n'])
+            if r['engine'] == engine and r['threads'] == threads and key in baseline:
+                by_size.setdefault(r['n'], []).append(baseline[key] / r['median_s'])
+        if by_size:
+            sizes = sorted(by_size)
+            ax.plot(sizes, [sum(by_size[n]) / len(by_size[n]) for n in sizes], 'o-', markersize=4,
+                    label=f'{engine} ({threads}t)')
+    ax.axhline(1.0, color='k', linestyle='--', alpha=0.5)
+    ax.set_xscale('log', base=2)
+    ax.set_xlabel('Elements', fontweight='bold')
+    ax.set_ylabel('Speedup over qsort (median)', fontweight='bold')
+    ax.set_title('Speedup vs qsort baseline', fontweight='bold')
+    ax.grid(True, alpha=0.3)
+    if baseline:
+        ax.legend(fontsize=8)
+
+    for ax in axes[panels:]:
+        ax.axis('off')
+    fig.tight_layout()
+    fig.savefig(out_path, dpi=200, bbox_inches='tight')
+    print(f"✓ Saved: {out_path} ({len(rows)} results)")
+
+
+if len(sys.argv) > 1:
+    plot_bench(load_bench(sys.argv[1]))
+    sys.exit(0)
+
 # ============================================================================
 # Data from execution results
 # ============================================================================
@@ -0,0 +1,250 @@
+#ifndef BITONIC_H
+#define BITONIC_H
+
+#include <stddef.h>
+
+#include "bitonic_arena.h"
+#include "bitonic_io.h"
+#include "bitonic_keys.h"
+#include "bitonic_local.h"
+
+/**
+ * libbitonic: the in-process sorting API behind the Serial, OpenMP and MPI
+ * programs (build with build_lib.sh; the distributed part is in
+ * bitonic_dist.h).
+ *
+ * Every call goes through a context that owns:
+ * - the team size: the OpenMP team is spawned when the context is created
+ *   and parked by the runtime between calls, so a service sorting many
+ *   arrays pays thread start-up once
+ * - a scratch arena (bitonic_arena.h) that every engine and exchange round
+ *   allocates from, so once it has grown to a workload's high-water mark
+ *   a sort performs no allocations and takes no page faults
+ *
+ * A context may be used by one thread at a time; use one context per
+ * calling thread. Every function returns 0 on success and -1 on error
+ * unless documented otherwise.
+ */
+
+#define BITONIC_VERSION_MAJOR 1
+#define BITONIC_VERSION_MINOR 0
+
+typedef struct bitonic_context bitonic_context;
+
+/**
+ * Enum: bitonic_engine
+ * --------------------
+ * Schedules of the int32 SIMD bitonic engine (lib/bitonic_omp.h):
+ * - BITONIC_ENGINE_FLAT: persistent team, one barrier per streamed stage
+ * - BITONIC_ENGINE_BLOCKS: one block per thread, compare-splits between
+ *   threads for the cross-block stages
+ * - BITONIC_ENGINE_TASKS: recursive OpenMP tasks with in-cache leaves
+ */
+typedef enum
+{
+    BITONIC_ENGINE_FLAT,
+    BITONIC_ENGINE_BLOCKS,
+    BITONIC_ENGINE_TASKS
+} bitonic_engine;
+
+/**
+ * Function: bitonic_engine_parse / bitonic_engine_name
+ * ----------------------------------------------------
+ * Maps "flat", "blocks" or "tasks" to an engine (-1 for an unknown name)
+ * and back.
+ */
+int bitonic_engine_parse(const char *name, bitonic_engine *engine);
+const char *bitonic_engine_name(bitonic_engine engine);
+
+/**
+ * Function: bitonic_context_create
+ * --------------------------------
+ * Creates a context whose calls run on 'threads' threads (0 = the
+ * OMP_NUM_THREADS default). Returns NULL if memory is exhausted.
+ */
+bitonic_context *bitonic_context_create(int threads);
+
+/**
+ * Function: bitonic_context_destroy
+ * ---------------------------------
+ * Releases the context and its scratch buffers (NULL is ignored).
+ */
+void bitonic_context_destroy(bitonic_context *ctx);
+
+/**
+ * Function: bitonic_context_threads
+ * ---------------------------------
+ * Team size of the context's calls.
+ */
+int bitonic_context_threads(const bitonic_context *ctx);
+
+/**
+ * Function: bitonic_context_set_engine / bitonic_context_engine
+ * -------------------------------------------------------------
+ * Selects the engine of the context's int32 sorts, and returns it. New
+ * contexts use BITONIC_ENGINE_BLOCKS when BITONIC_BLOCK_SWAP=1 is set and
+ * BITONIC_ENGINE_FLAT otherwise.
+ */
+void bitonic_context_set_engine(bitonic_context *ctx, bitonic_engine engine);
+bitonic_engine bitonic_context_engine(const bitonic_context *ctx);
+
+/**
+ * Function: bitonic_context_set_adaptive / bitonic_context_adaptive
+ * -----------------------------------------------------------------
+ * Turns the presortedness fast paths of the context's int32 sorts on (1) or
+ * off (0), and returns the setting. New contexts follow BITONIC_ADAPTIVE.
+ */
+void bitonic_context_set_adaptive(bitonic_context *ctx, int adaptive);
+int bitonic_context_adaptive(const bitonic_context *ctx);
+
+/**
+ * Function: bitonic_context_team
+ * ------------------------------
+ * Threads an int32 sort of n elements runs on: the team size, or 1 below the
+ * BITONIC_PARALLEL_MIN threshold.
+ */
+int bitonic_context_team(bitonic_context *ctx, long long n);
+
+/**
+ * Function: bitonic_context_tile
+ * ------------------------------
+ * Cache tile (elements) an int32 sort of n elements uses (0 = unblocked).
+ */
+int bitonic_context_tile(bitonic_context *ctx, long long n);
+
+/**
+ * Function: bitonic_context_first_touch
+ * -------------------------------------
+ * Faults in a freshly allocated array of n records of 'size' bytes with the
+ * team and static split a sort of n elements uses, so on NUMA hosts each
+ * thread's slice lands on its own node (see lib/bitonic_numa.h). Call it
+ * before filling the array; the contents are preserved.
+ */
+void bitonic_context_first_touch(bitonic_context *ctx, void *data, long long n, size_t size);
+
+/**
+ * Function: bitonic_context_alloc / bitonic_context_mark / bitonic_context_release
+ * --------------------------------------------------------------------------------
+ * Scratch from the context's arena: 'bytes' bytes aligned to 64, valid until
+ * bitonic_context_release is given a mark taken before the allocation.
+ * bitonic_context_alloc returns NULL if memory is exhausted.
+ */
+void *bitonic_context_alloc(bitonic_context *ctx, size_t bytes);
+size_t bitonic_context_mark(const bitonic_context *ctx);
+void bitonic_context_release(bitonic_context *ctx, size_t mark);
+
+/**
+ * Function: bitonic_context_stats
+ * -------------------------------
+ * Arena counters: bytes in use, peak and mapped, allocations served and
+ * regions mapped. A steady-state workload stops increasing 'maps'.
+ */
+void bitonic_context_stats(const bitonic_context *ctx, bitonic_arena_stats *stats);
+
+/**
+ * Function: bitonic_sort
+ * ----------------------
+ * Sorts data[0, n) ascending: int32 keys (BITONIC_KEY_INT32 without
+ * payload) with the SIMD/OpenMP bitonic engine in the context's schedule
+ * (bitonic_context_set_engine), every other record type with its
+ * specialization from bitonic_keys.h. int32 input is scanned first
+ * (lib/bitonic_adaptive.h): sorted, reversed, few-run and nearly sorted
+ * input skip the network (BITONIC_ADAPTIVE=0 turns this off). The blocks
+ * engine and the run merges take about n ints of scratch from the arena;
+ * returns -1 if they cannot be mapped.
+ */
+int bitonic_sort(bitonic_context *ctx, void *data, long long n, bitonic_key_type key, bitonic_payload_type payload);
+
+/**
+ * Function: bitonic_sort_segments
+ * -------------------------------
+ * Batched sort of many independent int32 arrays laid out back to back:
+ * sorts every segment data[offsets[s], offsets[s + 1]) for s in
+ * [0, segments) ascending on its own. Short segments (below
+ * BITONIC_PARALLEL_MIN elements, at most 2^20) are spread over the team,
+ * one per thread with no barrier per segment, grouped by padded power-of-2
+ * size so each group runs one in-cache SIMD network shape; longer ones are
+ * sorted one after another like bitonic_sort, with the adaptive scan and
+ * the context's engine, on the whole team each. offsets has segments + 1 non-decreasing entries starting at
+ * 0 or more. Returns -1 for invalid offsets or if scratch cannot be mapped.
+ */
+int bitonic_sort_segments(bitonic_context *ctx, int *data, const long long *offsets, int segments);
+
+/**
+ * Function: bitonic_topk
+ * ----------------------
+ * Partial sort: writes the k smallest values of data[0, n) to out in
+ * ascending order, leaving data untouched. Work stays close to one pass
+ * over the input for k much smaller than n (bitonic_omp_topk); k >= n
+ * copies and sorts everything. Returns the number of values written
+ * (min(k, n)), or -1 on error.
+ */
+long long bitonic_topk(bitonic_context *ctx, const int *data, long long n, long long k, int *out);
+
+/**
+ * Function: bitonic_merge_sorted
+ * ------------------------------
+ * Incremental update of a sorted int32 array: sorts the new values
+ * delta[0, delta_n) in place with bitonic_sort and merges them with the
+ * already sorted sorted[0, sorted_n) into out[0, sorted_n + delta_n) with
+ * a parallel merge-path merge. The existing values cost one scan (to check
+ * they are sorted) and one merge pass instead of a sort. Returns -1 if
+ * 'sorted' is not ascending or scratch cannot be mapped.
+ */
+int bitonic_merge_sorted(bitonic_context *ctx, const int *sorted, long long sorted_n, int *delta, long long delta_n,
+                         int *out);
+
+/**
+ * Function: bitonic_sort_local
+ * ----------------------------
+ * Sorts int data[0, n) with one of the local engines of bitonic_local.h,
+ * taking their scratch space from the context.
+ */
+int bitonic_sort_local(bitonic_context *ctx, int *data, long long n, local_sort_engine engine);
+
+/**
+ * Function: bitonic_read / bitonic_write
+ * --------------------------------------
+ * bitonic_read_records / bitonic_write_records on the context's team.
+ * bitonic_read returns the number of records read, or -1.
+ */
+long long bitonic_read(bitonic_context *ctx, const char *path, const bitonic_record_codec *codec, void **out_data);
+int bitonic_write(bitonic_context *ctx, const char *path, const bitonic_record_codec *codec, const void *data,
+                  long long count, bitonic_output_format format);
+
+/**
+ * Structure: bitonic_extsort_stats
+ * --------------------------------
+ * What bitonic_sort_file did: values sorted, sorted runs spilled and merge
+ * passes over them (0 when the input fit in one run).
+ */
+typedef struct
+{
+    unsigned long long count;
+    int runs;
+    int passes;
+} bitonic_extsort_stats;
+
+/**
+ * Function: bitonic_sort_file
+ * ---------------------------
+ * External-memory sort of a binary int input (see bitonic_io.h) that may be
+ * far larger than RAM, using about 'memory' bytes of buffers:
+ * 1. Run formation: chunks of memory / 16 values (memory / 40 for 64-bit
+ *    binary input, narrowed to int on read) are read, sorted with
+ *    bitonic_sort on the context's team (its scratch is inside the budget) and
+ *    spilled as sorted runs to an unlinked file in BITONIC_TMPDIR (else
+ *    TMPDIR, else /tmp). The read of the next chunk and the write of the
+ *    previous run overlap each sort
+ * 2. Merge: a loser tree merges the runs, each read through two
+ *    alternating blocks so the disk streams while the tree runs; outputs
+ *    are written the same way. Passes merge at most memory / 2 MB - 1 runs
+ *    (at least 2), so every read stays a large sequential block; budgets
+ *    below 18 MB that need more than one pass print a warning
+ * The result is written to out_path in 'format' (text or binary). Returns
+ * the number of values sorted, or -1 on error (a message is printed).
+ */
+long long bitonic_sort_file(bitonic_context *ctx, const char *in_path, const char *out_path,
+                            bitonic_output_format format, size_t memory, bitonic_extsort_stats *stats);
+
+#endif
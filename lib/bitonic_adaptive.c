@@ -0,0 +1,282 @@
+#include "bitonic_adaptive.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bitonic_simd.h"
+
+/* Pairs compared between checks of the early exit */
+#define SCAN_BLOCK 1024
+
+int bitonic_adaptive_enabled(void)
+{
+    const char *env = getenv("BITONIC_ADAPTIVE");
+    return !env || atoi(env) != 0;
+}
+
+/* Static slice [*lo, *hi) of part 'part' of 'parts' over [0, total) */
+static void slice_of(long long total, int part, int parts, long long *lo, long long *hi)
+{
+    *lo = total * part / parts;
+    *hi = total * (part + 1) / parts;
+}
+
+/**
+ * Function: bitonic_adaptive_measure
+ * ----------------------------------
+ * Every thread counts the descents and ascents of its slice of the n - 1
+ * neighbour pairs one block at a time, branch-free, and notes where the
+ * descents are while there are few enough for the RUNS plan. A thread that
+ * has seen more descents than the SPARSE plan allows and at least one
+ * ascent proves the plan is FULL, so it raises a flag that stops every
+ * thread at its next block.
+ */
+void bitonic_adaptive_measure(const int *data, long long n, int threads, bitonic_adaptive_scan *scan)
+{
+    const int cap = BITONIC_ADAPTIVE_MAX_RUNS - 1;  // Descents the RUNS plan can hold
+    long long limit = n / BITONIC_ADAPTIVE_SPARSE_RATIO;
+    long long descents = 0, ascents = 0;
+    int found = 0;
+    int stop = 0;
+
+    scan->bounds[0] = 0;
+#pragma omp parallel for schedule(static) num_threads(threads) reduction(+ : descents, ascents)
+    for (int part = 0; part < threads; ++part)
+    {
+        long long lo, hi;
+        slice_of(n - 1, part, threads, &lo, &hi);
+        long long mine[BITONIC_ADAPTIVE_MAX_RUNS];
+        int count = 0;
+        for (long long b = lo; b < hi; b += SCAN_BLOCK)
+        {
+            int halt;
+#pragma omp atomic read
+            halt = stop;
+            if (halt)
+                break;
+
+            long long e = (hi - b < SCAN_BLOCK) ? hi : b + SCAN_BLOCK;
+            int d = 0, u = 0;
+            for (long long i = b; i < e; ++i)
+            {
+                d += data[i] > data[i + 1];
+                u += data[i] < data[i + 1];
+            }
+            if (d > 0 && count + d <= cap)
+            {
+                for (long long i = b; i < e; ++i)
+                {
+                    if (data[i] > data[i + 1])
+                        mine[count++] = i + 1;  // Start of the next run
+                }
+            }
+            else if (d > 0)
+            {
+                count = cap + 1;
+            }
+            descents += d;
+            ascents += u;
+
+            if (descents > limit && ascents > 0)
+            {
+#pragma omp atomic write
+                stop = 1;
+            }
+        }
+
+#pragma omp critical(bitonic_adaptive_runs)
+        {
+            if (found + count <= cap)
+                memcpy(scan->bounds + 1 + found, mine, (size_t)count * sizeof(long long));
+            found = (found + count <= cap) ? found + count : cap + 1;
+        }
+    }
+
+    scan->descents = descents;
+    scan->ascents = ascents;
+    scan->runs = 0;
+    if (stop)
+        scan->plan = BITONIC_ADAPTIVE_FULL;
+    else if (descents == 0)
+        scan->plan = BITONIC_ADAPTIVE_SORTED;
+    else if (ascents == 0)
+        scan->plan = BITONIC_ADAPTIVE_REVERSED;
+    else if (found <= cap)
+    {
+        // Slices report in any order: sort the few run starts
+        for (int i = 2; i <= found; ++i)
+        {
+            long long v = scan->bounds[i];
+            int j = i;
+            for (; j > 1 && scan->bounds[j - 1] > v; --j)
+                scan->bounds[j] = scan->bounds[j - 1];
+            scan->bounds[j] = v;
+        }
+        scan->runs = found + 1;
+        scan->bounds[scan->runs] = n;
+        scan->plan = BITONIC_ADAPTIVE_RUNS;
+    }
+    else if (descents <= limit)
+        scan->plan = BITONIC_ADAPTIVE_SPARSE;
+    else
+        scan->plan = BITONIC_ADAPTIVE_FULL;
+}
+
+void bitonic_adaptive_reverse(int *data, long long n, int threads)
+{
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (long long i = 0; i < n / 2; ++i)
+    {
+        int t = data[i];
+        data[i] = data[n - 1 - i];
+        data[n - 1 - i] = t;
+    }
+}
+
+/**
+ * Function: bitonic_adaptive_sparse
+ * ---------------------------------
+ * Per slice, in one pass: values are kept in place on a non-descending
+ * stack; a value below the top of the stack goes to the side buffer
+ * (scratch at the slice's offset) together with the popped top, so every
+ * descent moves out at most a pair of values. The side values are sorted
+ * with the SIMD network and merged back from the end of the slice, where
+ * the kept values left room for them.
+ *
+ * Many short runs also pass the scan's descent limit but empty the stack
+ * over and over; once a slice's side values pass an eighth of it, the
+ * slice stops and puts them back in the gap behind the stack, so the
+ * input stays a permutation for the engine.
+ */
+int bitonic_adaptive_sparse(int *data, long long n, int threads, int *scratch, long long *bounds)
+{
+    int failed = 0;
+
+#pragma omp parallel for schedule(static) num_threads(threads) reduction(| : failed)
+    for (int part = 0; part < threads; ++part)
+    {
+        long long lo, hi;
+        slice_of(n, part, threads, &lo, &hi);
+        bounds[part] = lo;
+
+        long long limit = lo + (hi - lo) / 8;
+        long long kept = lo, side = lo;  // Stack data[lo, kept), side values scratch[lo, side)
+        long long i = lo;
+        for (; i < hi && side <= limit; ++i)
+        {
+            int v = data[i];
+            if (kept == lo || data[kept - 1] <= v)
+            {
+                data[kept++] = v;
+            }
+            else
+            {
+                scratch[side++] = data[--kept];
+                scratch[side++] = v;
+            }
+        }
+
+        long long moved = side - lo;
+        if (i < hi)
+        {
+            memcpy(data + kept, scratch + lo, (size_t)moved * sizeof(int));  // Fills [kept, i) exactly
+            failed = 1;
+            continue;
+        }
+        bitonic_simd_sort(scratch + lo, moved);
+        long long a = kept - 1, b = side - 1, out = hi - 1;
+        while (b >= lo)
+            data[out--] = (a >= lo && data[a] > scratch[b]) ? data[a--] : scratch[b--];
+    }
+    bounds[threads] = n;
+    return failed ? -1 : 0;
+}
+
+long long bitonic_co_rank(long long m, const int *a, long long na, const int *b, long long nb)
+{
+    long long lo = (m > nb) ? m - nb : 0;
+    long long hi = (m < na) ? m : na;
+    while (lo < hi)
+    {
+        long long i = lo + (hi - lo) / 2;
+        if (a[i] <= b[m - i - 1])
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+/* Merges a[0, na) and b[0, nb) into out, ties from a first */
+static void merge_into(int *out, const int *a, long long na, const int *b, long long nb)
+{
+    long long i = 0, t = 0, m = 0;
+    while (i < na && t < nb)
+        out[m++] = (b[t] < a[i]) ? b[t++] : a[i++];
+    while (i < na)
+        out[m++] = a[i++];
+    while (t < nb)
+        out[m++] = b[t++];
+}
+
+void bitonic_merge_range(const int *a, long long na, const int *b, long long nb, long long m0, long long m1, int *out)
+{
+    long long i0 = bitonic_co_rank(m0, a, na, b, nb);
+    long long i1 = bitonic_co_rank(m1, a, na, b, nb);
+    merge_into(out, a + i0, i1 - i0, b + (m0 - i0), (m1 - i1) - (m0 - i0));
+}
+
+/* Segment tid of team of the merge of a[0, na) and b[0, nb) into out, split by merge path */
+static void merge_segment(const int *a, long long na, const int *b, long long nb, int *out, int tid, int team)
+{
+    long long m0 = (na + nb) * tid / team;
+    long long m1 = (na + nb) * (tid + 1) / team;
+    bitonic_merge_range(a, na, b, nb, m0, m1, out + m0);
+}
+
+int *bitonic_merge_runs(int *src, int *dst, long long *bounds, int runs, int threads)
+{
+    while (runs > 1)
+    {
+        int pairs = (runs + 1) / 2;
+#pragma omp parallel num_threads(threads)
+        {
+#ifdef _OPENMP
+            int tid = omp_get_thread_num();
+            int team = omp_get_num_threads();
+#else
+            int tid = 0, team = 1;
+#endif
+            for (int p = 0; p < pairs; ++p)
+            {
+                long long lo = bounds[2 * p];
+                long long mid = bounds[(2 * p + 1 < runs) ? 2 * p + 1 : runs];
+                long long hi = bounds[(2 * p + 2 < runs) ? 2 * p + 2 : runs];
+                merge_segment(src + lo, mid - lo, src + mid, hi - mid, dst + lo, tid, team);
+            }
+        }
+        for (int p = 0; p <= pairs; ++p)
+            bounds[p] = bounds[(2 * p < runs) ? 2 * p : runs];
+        runs = pairs;
+        int *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    return src;
+}
+
+void bitonic_merge_pair(const int *a, long long na, const int *b, long long nb, int *out, int threads)
+{
+#pragma omp parallel num_threads(threads)
+    {
+#ifdef _OPENMP
+        merge_segment(a, na, b, nb, out, omp_get_thread_num(), omp_get_num_threads());
+#else
+        merge_segment(a, na, b, nb, out, 0, 1);
+#endif
+    }
+}
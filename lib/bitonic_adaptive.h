@@ -0,0 +1,119 @@
+#ifndef BITONIC_ADAPTIVE_H
+#define BITONIC_ADAPTIVE_H
+
+/**
+ * Presortedness fast paths for int32 sorts (used by bitonic_sort).
+ *
+ * One parallel pass counts descents (data[i] > data[i + 1]) and ascents and
+ * picks a plan:
+ * - SORTED: no descent, nothing to do
+ * - REVERSED: no ascent (non-increasing input), reversed in place
+ * - RUNS: at most BITONIC_ADAPTIVE_MAX_RUNS non-descending runs, merged by a
+ *   merge-path tree in log2(runs) passes
+ * - SPARSE: at most n / BITONIC_ADAPTIVE_SPARSE_RATIO descents (a few
+ *   misplaced values in sorted data): every thread pulls the values that
+ *   break order out of its slice, sorts them with the SIMD network and
+ *   merges them back, then the slices are merged by the same tree
+ * - FULL: anything else goes to the bitonic engine
+ * The scan stops as soon as the input is clearly unsorted, so random input
+ * pays for a few percent of one pass.
+ */
+
+/* Most runs merged directly by the RUNS plan */
+#define BITONIC_ADAPTIVE_MAX_RUNS 64
+/* SPARSE plan: at most n / BITONIC_ADAPTIVE_SPARSE_RATIO descents */
+#define BITONIC_ADAPTIVE_SPARSE_RATIO 64
+
+typedef enum
+{
+    BITONIC_ADAPTIVE_FULL,
+    BITONIC_ADAPTIVE_SORTED,
+    BITONIC_ADAPTIVE_REVERSED,
+    BITONIC_ADAPTIVE_RUNS,
+    BITONIC_ADAPTIVE_SPARSE
+} bitonic_adaptive_plan;
+
+/**
+ * Structure: bitonic_adaptive_scan
+ * --------------------------------
+ * Result of bitonic_adaptive_measure. The counts are exact unless the plan
+ * is FULL (the scan stopped early).
+ */
+typedef struct
+{
+    bitonic_adaptive_plan plan;
+    long long descents;                               // Positions with data[i] > data[i + 1]
+    long long ascents;                                // Positions with data[i] < data[i + 1]
+    int runs;                                         // Non-descending runs (RUNS plan)
+    long long bounds[BITONIC_ADAPTIVE_MAX_RUNS + 1];  // Run starts, bounds[runs] = n (RUNS plan)
+} bitonic_adaptive_scan;
+
+/**
+ * Function: bitonic_adaptive_enabled
+ * ----------------------------------
+ * Returns 0 if BITONIC_ADAPTIVE=0 turns the fast paths off, 1 otherwise.
+ */
+int bitonic_adaptive_enabled(void);
+
+/**
+ * Function: bitonic_adaptive_measure
+ * ----------------------------------
+ * Scans data[0, n) with 'threads' threads and chooses a plan.
+ */
+void bitonic_adaptive_measure(const int *data, long long n, int threads, bitonic_adaptive_scan *scan);
+
+/**
+ * Function: bitonic_adaptive_reverse
+ * ----------------------------------
+ * Reverses data[0, n) in place (REVERSED plan).
+ */
+void bitonic_adaptive_reverse(int *data, long long n, int threads);
+
+/**
+ * Function: bitonic_adaptive_sparse
+ * ---------------------------------
+ * SPARSE plan, first part: leaves each of the 'threads' equal slices of
+ * data sorted and their starts in bounds[0, threads] (bounds[threads] = n),
+ * ready for bitonic_merge_runs. 'scratch' holds n ints. Returns -1 if the
+ * disorder was not sparse after all; data then holds the same values,
+ * still to be sorted.
+ */
+int bitonic_adaptive_sparse(int *data, long long n, int threads, int *scratch, long long *bounds);
+
+/**
+ * Function: bitonic_co_rank
+ * -------------------------
+ * Merge-path search: how many of the first m elements of merge(a, b) come
+ * from a, with ties taken from a first. Reads a[0, min(m, na)) and
+ * b[max(m - na, 0), min(m, nb)) only.
+ */
+long long bitonic_co_rank(long long m, const int *a, long long na, const int *b, long long nb);
+
+/**
+ * Function: bitonic_merge_range
+ * -----------------------------
+ * Writes elements [m0, m1) of merge(a[0, na), b[0, nb)) (ties from a first)
+ * to out[0, m1 - m0), one thread. Disjoint ranges split a merge over a team
+ * with no synchronization.
+ */
+void bitonic_merge_range(const int *a, long long na, const int *b, long long nb, long long m0, long long m1, int *out);
+
+/**
+ * Function: bitonic_merge_runs
+ * ----------------------------
+ * Balanced merge tree over the 'runs' sorted runs of src delimited by
+ * bounds[0, runs] (overwritten): each pass merges neighbouring pairs into
+ * the other buffer, every pair split into equal merge-path segments over
+ * the team. Returns the buffer holding the result (src or dst).
+ */
+int *bitonic_merge_runs(int *src, int *dst, long long *bounds, int runs, int threads);
+
+/**
+ * Function: bitonic_merge_pair
+ * ----------------------------
+ * Merges the sorted arrays a[0, na) and b[0, nb) into out[0, na + nb) (ties
+ * from a first), split into equal merge-path segments over 'threads'.
+ */
+void bitonic_merge_pair(const int *a, long long na, const int *b, long long nb, int *out, int threads);
+
+#endif
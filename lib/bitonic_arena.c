@@ -0,0 +1,263 @@
+#define _GNU_SOURCE  // MAP_ANONYMOUS, MAP_HUGETLB, MADV_HUGEPAGE
+#include "bitonic_arena.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "bitonic_numa.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Transparent / reserved huge page size on x86-64 and most arm64 kernels */
+#define HUGE_PAGE ((size_t)2 << 20)
+/* mbind() policy (linux/mempolicy.h) */
+#define ARENA_MPOL_INTERLEAVE 3
+
+struct bitonic_arena_overflow
+{
+    char *base;
+    size_t mapped;
+    size_t offset;  // Logical offset of the allocation it serves
+    bitonic_arena_overflow *next;
+};
+
+typedef enum
+{
+    HUGE_OFF,
+    HUGE_THP,
+    HUGE_EXPLICIT
+} huge_policy;
+
+static huge_policy huge_pages(void)
+{
+    const char *env = getenv("BITONIC_HUGEPAGES");
+    if (env && strcmp(env, "off") == 0)
+        return HUGE_OFF;
+    if (env && strcmp(env, "explicit") == 0)
+        return HUGE_EXPLICIT;
+    return HUGE_THP;
+}
+
+static size_t page_bytes(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+}
+
+/* Rounds up to a multiple of 'unit', a power of 2 */
+static size_t round_up(size_t bytes, size_t unit)
+{
+    return (bytes + unit - 1) & ~(unit - 1);
+}
+
+/**
+ * Function: interleave
+ * --------------------
+ * Spreads the pages of a fresh region round-robin over the online NUMA
+ * nodes (BITONIC_NUMA=interleave). A no-op on single-node hosts and where
+ * mbind() is unavailable.
+ */
+static void interleave(char *base, size_t bytes)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    char line[512];
+    FILE *f = fopen("/sys/devices/system/node/online", "r");
+    if (!f)
+        return;
+    int read = (fgets(line, sizeof(line), f) != NULL);
+    fclose(f);
+    int nodes[64];
+    int count = read ? bitonic_parse_cpulist(line, nodes, 64) : 0;
+
+    unsigned long mask = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (nodes[i] < (int)(8 * sizeof(mask)))
+            mask |= 1UL << nodes[i];
+    }
+
+    if (mask & (mask - 1))
+        syscall(SYS_mbind, base, bytes, ARENA_MPOL_INTERLEAVE, &mask, 8 * sizeof(mask) + 1, 0);
+#else
+    (void)base;
+    (void)bytes;
+#endif
+}
+
+/**
+ * Function: region_map
+ * --------------------
+ * Maps a region of at least 'bytes' bytes (see bitonic_arena.h for the huge
+ * page and NUMA policies) and stores its mapped length in *mapped.
+ */
+static char *region_map(size_t bytes, int threads, size_t *mapped)
+{
+    huge_policy huge = huge_pages();
+    int large = (huge != HUGE_OFF && bytes >= HUGE_PAGE);
+    size_t length = round_up(bytes, large ? HUGE_PAGE : page_bytes());
+    char *base = NULL;
+
+#ifdef MAP_HUGETLB
+    if (large && huge == HUGE_EXPLICIT)
+    {
+        void *p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+            base = p;
+    }
+#endif
+    if (!base)
+    {
+        // Over-map by one huge page and trim, so the region starts on a huge page boundary
+        size_t slack = large ? HUGE_PAGE : 0;
+        void *p = mmap(NULL, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return NULL;
+        char *raw = p;
+        base = large ? (char *)round_up((uintptr_t)raw, HUGE_PAGE) : raw;
+        size_t head = (size_t)(base - raw);
+        if (head > 0)
+            munmap(raw, head);
+        if (slack - head > 0)
+            munmap(base + length, slack - head);
+#ifdef MADV_HUGEPAGE
+        if (large)
+            madvise(base, length, MADV_HUGEPAGE);
+#endif
+    }
+
+    const char *numa = getenv("BITONIC_NUMA");
+    if (numa && strcmp(numa, "interleave") == 0)
+        interleave(base, length);
+    // Fault the pages in now, each on the node of the thread whose slice it
+    // holds (see bitonic_numa.h), instead of inside a sort
+    bitonic_first_touch(base, length, threads);
+
+    *mapped = length;
+    return base;
+}
+
+void bitonic_arena_init(bitonic_arena *arena, int threads)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->threads = (threads > 0) ? threads : 1;
+}
+
+void bitonic_arena_destroy(bitonic_arena *arena)
+{
+    while (arena->overflow)
+    {
+        bitonic_arena_overflow *region = arena->overflow;
+        arena->overflow = region->next;
+        munmap(region->base, region->mapped);
+        free(region);
+    }
+    if (arena->base)
+        munmap(arena->base, arena->mapped);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void *bitonic_arena_alloc(bitonic_arena *arena, size_t bytes)
+{
+    if (bytes == 0)
+        bytes = 1;
+    size_t offset = round_up(arena->used, BITONIC_ARENA_ALIGN);
+    size_t end = offset + bytes;
+    char *ptr;
+
+    if (end <= arena->capacity)
+    {
+        ptr = arena->base + offset;
+    }
+    else
+    {
+        // Past the main region: serve this call from its own region until
+        // the arena empties and the main region is regrown
+        bitonic_arena_overflow *region = malloc(sizeof(*region));
+        if (!region)
+            return NULL;
+        region->base = region_map(bytes, arena->threads, &region->mapped);
+        if (!region->base)
+        {
+            free(region);
+            return NULL;
+        }
+        region->offset = offset;
+        region->next = arena->overflow;
+        arena->overflow = region;
+        arena->stats.maps++;
+        arena->stats.reserved += region->mapped;
+        ptr = region->base;
+    }
+
+    arena->used = end;
+    arena->stats.allocs++;
+    arena->stats.in_use = end;
+    if (end > arena->stats.peak)
+        arena->stats.peak = end;
+    return ptr;
+}
+
+size_t bitonic_arena_mark(const bitonic_arena *arena)
+{
+    return arena->used;
+}
+
+void bitonic_arena_release(bitonic_arena *arena, size_t mark)
+{
+    // A lone overflow region that spans the high-water mark becomes the main one
+    bitonic_arena_overflow *lone = arena->overflow;
+    if (mark == 0 && lone && !lone->next && lone->offset == 0 && lone->mapped >= arena->stats.peak)
+    {
+        if (arena->base)
+        {
+            munmap(arena->base, arena->mapped);
+            arena->stats.reserved -= arena->mapped;
+        }
+        arena->base = lone->base;
+        arena->mapped = arena->capacity = lone->mapped;
+        arena->overflow = NULL;
+        free(lone);
+    }
+
+    while (arena->overflow && arena->overflow->offset >= mark)
+    {
+        bitonic_arena_overflow *region = arena->overflow;
+        arena->overflow = region->next;
+        arena->stats.reserved -= region->mapped;
+        munmap(region->base, region->mapped);
+        free(region);
+    }
+    arena->used = mark;
+    arena->stats.in_use = mark;
+
+    // Empty again: make the main region big enough for the whole high-water mark
+    if (mark == 0 && arena->stats.peak > arena->capacity)
+    {
+        if (arena->base)
+        {
+            munmap(arena->base, arena->mapped);
+            arena->stats.reserved -= arena->mapped;
+        }
+        arena->base = region_map(arena->stats.peak, arena->threads, &arena->mapped);
+        if (!arena->base)
+        {
+            arena->mapped = 0;
+        }
+        else
+        {
+            arena->stats.maps++;
+            arena->stats.reserved += arena->mapped;
+        }
+        arena->capacity = arena->mapped;
+    }
+}
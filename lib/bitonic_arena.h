@@ -0,0 +1,83 @@
+#ifndef BITONIC_ARENA_H
+#define BITONIC_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * Bump allocator for the scratch space of one sort context.
+ *
+ * Allocations are carved out of one mapped region, 64-byte aligned, and
+ * given back in LIFO order with bitonic_arena_release(mark). When a call
+ * needs more than the region holds, the excess is served from overflow
+ * regions; once the arena is released back to empty, the region is
+ * replaced by one of the high-water size. After the first call of a
+ * workload, calls of the same or smaller size therefore map nothing:
+ * allocation is a pointer bump and the pages are already resident.
+ *
+ * Regions are anonymous mmap()s:
+ * - BITONIC_HUGEPAGES=thp (default) aligns regions of 2 MB or more to 2 MB
+ *   and advises transparent huge pages; "explicit" tries MAP_HUGETLB
+ *   (reserved huge pages) first; "off" uses base pages
+ * - BITONIC_NUMA=local (default) first-touches each new region with the
+ *   arena's team in the static schedule the engines use, so pages land on
+ *   the nodes of the threads that work on them; "interleave" spreads them
+ *   round-robin over the online nodes instead
+ */
+
+#define BITONIC_ARENA_ALIGN 64
+
+/**
+ * Structure: bitonic_arena_stats
+ * ------------------------------
+ * Usage counters of an arena (see bitonic_context_stats).
+ */
+typedef struct
+{
+    size_t in_use;          // Bytes handed out and not yet released
+    size_t peak;            // Largest in_use so far (the high-water mark)
+    size_t reserved;        // Bytes currently mapped
+    unsigned long allocs;   // Allocations served
+    unsigned long maps;     // Regions mapped (0 growth in steady state)
+} bitonic_arena_stats;
+
+typedef struct bitonic_arena_overflow bitonic_arena_overflow;
+
+typedef struct
+{
+    char *base;                        // Main region
+    size_t capacity;                   // Usable bytes of the main region
+    size_t mapped;                     // Mapped bytes of the main region
+    size_t used;                       // Logical bytes in use (main + overflow)
+    bitonic_arena_overflow *overflow;  // Regions past the main one, newest first
+    int threads;                       // Team that first-touches new regions
+    bitonic_arena_stats stats;
+} bitonic_arena;
+
+/**
+ * Function: bitonic_arena_init / bitonic_arena_destroy
+ * ----------------------------------------------------
+ * Prepares an empty arena whose new regions are first-touched by 'threads'
+ * threads, and unmaps every region of an arena.
+ */
+void bitonic_arena_init(bitonic_arena *arena, int threads);
+void bitonic_arena_destroy(bitonic_arena *arena);
+
+/**
+ * Function: bitonic_arena_alloc
+ * -----------------------------
+ * Returns 'bytes' bytes aligned to BITONIC_ARENA_ALIGN, valid until the
+ * arena is released to a mark taken before the call. NULL if mapping fails.
+ */
+void *bitonic_arena_alloc(bitonic_arena *arena, size_t bytes);
+
+/**
+ * Function: bitonic_arena_mark / bitonic_arena_release
+ * ----------------------------------------------------
+ * bitonic_arena_release(arena, mark) frees every allocation made since
+ * bitonic_arena_mark returned 'mark'. Releasing to an empty arena also
+ * coalesces overflow into one high-water sized region.
+ */
+size_t bitonic_arena_mark(const bitonic_arena *arena);
+void bitonic_arena_release(bitonic_arena *arena, size_t mark);
+
+#endif
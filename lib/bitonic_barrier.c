@@ -0,0 +1,51 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitonic_barrier.h"
+
+#include <sched.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define cpu_relax() _mm_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+/* Pause-spins before a waiter starts yielding its core */
+#define BITONIC_SPIN_LIMIT 4096
+
+void bitonic_barrier_init(bitonic_barrier *barrier, int count)
+{
+    atomic_init(&barrier->remaining, count);
+    atomic_init(&barrier->sense, 0);
+    barrier->count = count;
+}
+
+void bitonic_barrier_wait(bitonic_barrier *barrier, int *local_sense)
+{
+    int sense = !*local_sense;
+    *local_sense = sense;
+
+    if (atomic_fetch_sub_explicit(&barrier->remaining, 1, memory_order_acq_rel) == 1)
+    {
+        // Last to arrive: re-arm the counter, then release the waiters
+        atomic_store_explicit(&barrier->remaining, barrier->count, memory_order_relaxed);
+        atomic_store_explicit(&barrier->sense, sense, memory_order_release);
+        return;
+    }
+
+    int spins = 0;
+    while (atomic_load_explicit(&barrier->sense, memory_order_acquire) != sense)
+    {
+        if (spins < BITONIC_SPIN_LIMIT)
+        {
+            ++spins;
+            cpu_relax();
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
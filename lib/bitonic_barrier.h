@@ -0,0 +1,40 @@
+#ifndef BITONIC_BARRIER_H
+#define BITONIC_BARRIER_H
+
+#include <stdatomic.h>
+
+/**
+ * Sense-reversing spin barrier for a fixed team of threads.
+ *
+ * Much cheaper than ending an OpenMP parallel region: a stage boundary costs
+ * one atomic decrement per thread plus a spin on a shared flag. Waiters spin
+ * with a CPU pause hint and fall back to sched_yield() after a while, so an
+ * oversubscribed team (more threads than cores) still makes progress.
+ *
+ * The counter and the flag live on separate cache lines to keep arriving
+ * threads from invalidating the line the waiters are spinning on.
+ */
+typedef struct
+{
+    _Alignas(64) atomic_int remaining;
+    _Alignas(64) atomic_int sense;
+    int count;
+} bitonic_barrier;
+
+/**
+ * Function: bitonic_barrier_init
+ * ------------------------------
+ * Prepares the barrier for 'count' threads. Each thread keeps its own
+ * local sense flag, initialized to 0, and passes it to every wait.
+ */
+void bitonic_barrier_init(bitonic_barrier *barrier, int count);
+
+/**
+ * Function: bitonic_barrier_wait
+ * ------------------------------
+ * Blocks until all 'count' threads have arrived. Writes made by any thread
+ * before the wait are visible to every thread after it.
+ */
+void bitonic_barrier_wait(bitonic_barrier *barrier, int *local_sense);
+
+#endif
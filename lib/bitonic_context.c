@@ -0,0 +1,421 @@
+#include "bitonic.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bitonic_adaptive.h"
+#include "bitonic_cpu.h"
+#include "bitonic_numa.h"
+#include "bitonic_omp.h"
+#include "bitonic_trace.h"
+
+struct bitonic_context
+{
+    int threads;           // Team size of every call
+    int tile;              // Cache tile of int32 sorts (0 = unblocked)
+    bitonic_engine engine; // Schedule of int32 sorts
+    int adaptive;          // Presortedness fast paths of int32 sorts (BITONIC_ADAPTIVE)
+    bitonic_arena arena;   // Scratch of every call
+    int caller_threads;    // Caller's team size, restored by context_leave
+};
+
+/**
+ * Function: context_enter / context_leave
+ * ---------------------------------------
+ * Every engine sizes its team with omp_get_max_threads(), so a call runs on
+ * the context's team by setting the calling thread's nthreads ICV for the
+ * duration of the call and restoring the caller's value afterwards.
+ */
+static void context_enter(bitonic_context *ctx)
+{
+#ifdef _OPENMP
+    ctx->caller_threads = omp_get_max_threads();
+    omp_set_num_threads(ctx->threads);
+#else
+    (void)ctx;
+#endif
+}
+
+static void context_leave(bitonic_context *ctx)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(ctx->caller_threads);
+#else
+    (void)ctx;
+#endif
+}
+
+static const char *const engine_names[] = {"flat", "blocks", "tasks"};
+
+int bitonic_engine_parse(const char *name, bitonic_engine *engine)
+{
+    for (int e = BITONIC_ENGINE_FLAT; e <= BITONIC_ENGINE_TASKS; ++e)
+    {
+        if (strcmp(name, engine_names[e]) == 0)
+        {
+            *engine = (bitonic_engine)e;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *bitonic_engine_name(bitonic_engine engine)
+{
+    return (engine >= BITONIC_ENGINE_FLAT && engine <= BITONIC_ENGINE_TASKS) ? engine_names[engine] : "unknown";
+}
+
+bitonic_context *bitonic_context_create(int threads)
+{
+    bitonic_context *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx)
+        return NULL;
+
+#ifdef _OPENMP
+    ctx->threads = (threads > 0) ? threads : omp_get_max_threads();
+    // Spawn (and, under BITONIC_PIN, pin) the team now; the runtime keeps it
+    // parked for the next call
+#pragma omp parallel num_threads(ctx->threads) proc_bind(close)
+    bitonic_pin_thread(omp_get_thread_num());
+#else
+    (void)threads;
+    ctx->threads = 1;
+#endif
+    bitonic_trace_init(ctx->threads);
+    ctx->tile = bitonic_tile_elems(sizeof(int));
+    ctx->engine = bitonic_omp_block_swap() ? BITONIC_ENGINE_BLOCKS : BITONIC_ENGINE_FLAT;
+    ctx->adaptive = bitonic_adaptive_enabled();
+    bitonic_arena_init(&ctx->arena, ctx->threads);
+    return ctx;
+}
+
+void bitonic_context_destroy(bitonic_context *ctx)
+{
+    if (!ctx)
+        return;
+    bitonic_arena_destroy(&ctx->arena);
+    free(ctx);
+}
+
+int bitonic_context_threads(const bitonic_context *ctx)
+{
+    return ctx->threads;
+}
+
+void bitonic_context_set_engine(bitonic_context *ctx, bitonic_engine engine)
+{
+    ctx->engine = engine;
+}
+
+bitonic_engine bitonic_context_engine(const bitonic_context *ctx)
+{
+    return ctx->engine;
+}
+
+void bitonic_context_set_adaptive(bitonic_context *ctx, int adaptive)
+{
+    ctx->adaptive = (adaptive != 0);
+}
+
+int bitonic_context_adaptive(const bitonic_context *ctx)
+{
+    return ctx->adaptive;
+}
+
+int bitonic_context_team(bitonic_context *ctx, long long n)
+{
+    context_enter(ctx);
+    int team = bitonic_omp_threads(n);
+    context_leave(ctx);
+    return team;
+}
+
+int bitonic_context_tile(bitonic_context *ctx, long long n)
+{
+    context_enter(ctx);
+    int tile = bitonic_omp_tile(ctx->tile, n);
+    context_leave(ctx);
+    return tile;
+}
+
+void bitonic_context_first_touch(bitonic_context *ctx, void *data, long long n, size_t size)
+{
+    int team = bitonic_context_team(ctx, n);
+    if (team > 1)
+        bitonic_first_touch(data, (size_t)n * size, team);
+}
+
+void *bitonic_context_alloc(bitonic_context *ctx, size_t bytes)
+{
+    return bitonic_arena_alloc(&ctx->arena, bytes);
+}
+
+size_t bitonic_context_mark(const bitonic_context *ctx)
+{
+    return bitonic_arena_mark(&ctx->arena);
+}
+
+void bitonic_context_release(bitonic_context *ctx, size_t mark)
+{
+    bitonic_arena_release(&ctx->arena, mark);
+}
+
+void bitonic_context_stats(const bitonic_context *ctx, bitonic_arena_stats *stats)
+{
+    *stats = ctx->arena.stats;
+}
+
+/**
+ * Function: adaptive_sort
+ * -----------------------
+ * Presortedness fast paths of int32 sorts (lib/bitonic_adaptive.h): sorted
+ * input costs the scan, reversed input one more pass, and a few runs or a
+ * few misplaced values a handful of merge passes. Returns 1 if the input
+ * was sorted here, 0 if it needs the engine, -1 if scratch is exhausted.
+ */
+static int adaptive_sort(bitonic_context *ctx, int *data, long long n)
+{
+    int threads = bitonic_omp_threads(n);
+    bitonic_adaptive_scan scan;
+    bitonic_adaptive_measure(data, n, threads, &scan);
+    if (scan.plan == BITONIC_ADAPTIVE_FULL)
+        return 0;
+    if (scan.plan == BITONIC_ADAPTIVE_SORTED)
+        return 1;
+    if (scan.plan == BITONIC_ADAPTIVE_REVERSED)
+    {
+        bitonic_adaptive_reverse(data, n, threads);
+        return 1;
+    }
+
+    size_t mark = bitonic_arena_mark(&ctx->arena);
+    int *scratch = bitonic_arena_alloc(&ctx->arena, (size_t)n * sizeof(int));
+    long long *bounds = bitonic_arena_alloc(&ctx->arena, (size_t)(threads + 1) * sizeof(long long));
+    if (!scratch || !bounds)
+    {
+        bitonic_arena_release(&ctx->arena, mark);
+        return -1;
+    }
+    int *sorted = NULL;
+    if (scan.plan == BITONIC_ADAPTIVE_RUNS)
+        sorted = bitonic_merge_runs(data, scratch, scan.bounds, scan.runs, threads);
+    else if (bitonic_adaptive_sparse(data, n, threads, scratch, bounds) == 0)
+        sorted = bitonic_merge_runs(data, scratch, bounds, threads, threads);
+    if (sorted && sorted != data)
+        memcpy(data, sorted, (size_t)n * sizeof(int));
+    bitonic_arena_release(&ctx->arena, mark);
+    return sorted ? 1 : 0;
+}
+
+/**
+ * Function: sort_int32
+ * --------------------
+ * int32 sort of the context: the adaptive fast paths, then the engine of
+ * bitonic_context_set_engine. Runs inside context_enter. Returns -1 if
+ * scratch cannot be mapped.
+ */
+static int sort_int32(bitonic_context *ctx, int *data, long long n)
+{
+    int status = 0;
+    int done = ctx->adaptive ? adaptive_sort(ctx, data, n) : 0;
+    if (done != 0)
+    {
+        status = (done < 0) ? -1 : 0;
+    }
+    else if (ctx->engine == BITONIC_ENGINE_BLOCKS && bitonic_omp_threads(n) > 1)
+    {
+        size_t mark = bitonic_arena_mark(&ctx->arena);
+        int *scratch = bitonic_arena_alloc(&ctx->arena, bitonic_omp_blocks_scratch(n) * sizeof(int));
+        if (scratch)
+            bitonic_omp_sort_blocks(data, n, ctx->tile, scratch);
+        else
+            status = -1;
+        bitonic_arena_release(&ctx->arena, mark);
+    }
+    else if (ctx->engine == BITONIC_ENGINE_TASKS)
+    {
+        bitonic_omp_sort_tasks(data, n, ctx->tile);
+    }
+    else
+    {
+        bitonic_omp_sort(data, n, ctx->tile);
+    }
+    return status;
+}
+
+int bitonic_sort(bitonic_context *ctx, void *data, long long n, bitonic_key_type key, bitonic_payload_type payload)
+{
+    if (n < 0 || (n > 0 && !data))
+        return -1;
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+    context_enter(ctx);
+    int status = 0;
+    if (key == BITONIC_KEY_INT32 && payload == BITONIC_PAYLOAD_NONE)
+        status = sort_int32(ctx, data, n);
+    else
+        bitonic_key_ops_for(key, payload)->sort(data, n);
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    return status;
+}
+
+int bitonic_sort_segments(bitonic_context *ctx, int *data, const long long *offsets, int segments)
+{
+    if (segments < 0 || (segments > 0 && (!offsets || offsets[0] < 0)))
+        return -1;
+    for (int s = 0; s < segments; ++s)
+    {
+        if (offsets[s + 1] < offsets[s])
+            return -1;
+    }
+    if (segments == 0 || offsets[segments] == offsets[0])
+        return 0;
+    if (!data)
+        return -1;
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+    context_enter(ctx);
+    size_t mark = bitonic_arena_mark(&ctx->arena);
+    int *scratch = bitonic_arena_alloc(&ctx->arena,
+                                       bitonic_omp_segments_scratch(segments, ctx->threads) * sizeof(int));
+    int status = scratch ? 0 : -1;
+    if (scratch)
+        bitonic_omp_sort_segments(data, offsets, segments, scratch);
+    bitonic_arena_release(&ctx->arena, mark);
+
+    // Long segments get the whole team each, through the context's engine
+    int limit = bitonic_omp_segment_limit();
+    for (int s = 0; s < segments && status == 0; ++s)
+    {
+        long long len = offsets[s + 1] - offsets[s];
+        if (len >= limit && len > 1)
+            status = sort_int32(ctx, data + offsets[s], len);
+    }
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    return status;
+}
+
+long long bitonic_topk(bitonic_context *ctx, const int *data, long long n, long long k, int *out)
+{
+    if (n < 0 || k < 0 || (n > 0 && k > 0 && (!data || !out)))
+        return -1;
+    if (k == 0 || n == 0)
+        return 0;
+    if (k >= n)
+    {
+        memcpy(out, data, (size_t)n * sizeof(int));
+        return (bitonic_sort(ctx, out, n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE) == 0) ? n : -1;
+    }
+
+    size_t mark = bitonic_arena_mark(&ctx->arena);
+    int status = 0;
+    if (k > n / 4)
+    {
+        // Too large a share to gain from truncation: sort a copy
+        int *copy = bitonic_arena_alloc(&ctx->arena, (size_t)n * sizeof(int));
+        if (copy)
+        {
+            memcpy(copy, data, (size_t)n * sizeof(int));
+            status = bitonic_sort(ctx, copy, n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE);
+            memcpy(out, copy, (size_t)k * sizeof(int));
+        }
+        else
+        {
+            status = -1;
+        }
+    }
+    else
+    {
+        bitonic_trace_mark trace;
+        bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+        context_enter(ctx);
+        size_t width = (size_t)bitonic_omp_topk_width(k);
+        int *scratch = bitonic_arena_alloc(&ctx->arena, (size_t)bitonic_omp_threads(n) * 2 * width * sizeof(int));
+        if (scratch)
+            bitonic_omp_topk(data, n, k, out, scratch);
+        else
+            status = -1;
+        context_leave(ctx);
+        bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    }
+    bitonic_arena_release(&ctx->arena, mark);
+    return (status == 0) ? k : -1;
+}
+
+int bitonic_merge_sorted(bitonic_context *ctx, const int *sorted, long long sorted_n, int *delta, long long delta_n,
+                         int *out)
+{
+    if (sorted_n < 0 || delta_n < 0 || (sorted_n > 0 && !sorted) || (delta_n > 0 && !delta) ||
+        (sorted_n + delta_n > 0 && !out))
+        return -1;
+
+    // The existing values are trusted only after one scan: a descent means they were never sorted
+    if (sorted_n > 1)
+    {
+        bitonic_adaptive_scan scan;
+        context_enter(ctx);
+        bitonic_adaptive_measure(sorted, sorted_n, bitonic_omp_threads(sorted_n), &scan);
+        context_leave(ctx);
+        if (scan.plan != BITONIC_ADAPTIVE_SORTED)
+            return -1;
+    }
+    if (bitonic_sort(ctx, delta, delta_n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE) != 0)
+        return -1;
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_MERGE, &trace);
+    context_enter(ctx);
+    bitonic_merge_pair(sorted, sorted_n, delta, delta_n, out, bitonic_omp_threads(sorted_n + delta_n));
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_MERGE, &trace);
+    return 0;
+}
+
+int bitonic_sort_local(bitonic_context *ctx, int *data, long long n, local_sort_engine engine)
+{
+    if (n < 0 || (n > 0 && !data))
+        return -1;
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+    context_enter(ctx);
+    size_t mark = bitonic_arena_mark(&ctx->arena);
+    size_t scratch_ints = local_sort_scratch_size(n, engine);
+    int *scratch = scratch_ints ? bitonic_arena_alloc(&ctx->arena, scratch_ints * sizeof(int)) : NULL;
+    int status = (scratch_ints && !scratch) ? -1 : local_sort_scratch(data, n, engine, scratch);
+    bitonic_arena_release(&ctx->arena, mark);
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    return status;
+}
+
+long long bitonic_read(bitonic_context *ctx, const char *path, const bitonic_record_codec *codec, void **out_data)
+{
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_READ, &trace);
+    context_enter(ctx);
+    long long count = bitonic_read_records(path, codec, out_data);
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_READ, &trace);
+    return count;
+}
+
+int bitonic_write(bitonic_context *ctx, const char *path, const bitonic_record_codec *codec, const void *data,
+                  long long count, bitonic_output_format format)
+{
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_WRITE, &trace);
+    context_enter(ctx);
+    int status = bitonic_write_records(path, codec, data, count, format);
+    context_leave(ctx);
+    bitonic_trace_end(BITONIC_PHASE_WRITE, &trace);
+    return status;
+}
@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include "bitonic_cpu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#define BITONIC_MIN_TILE 1024
+#define BITONIC_DEFAULT_L2 (256L * 1024)
+
+/**
+ * Function: sysfs_cache_bytes
+ * ---------------------------
+ * Scans /sys/devices/system/cpu/cpu0/cache/index* for a data or unified
+ * cache at the requested level. Sizes are reported like "48K" or "2048K".
+ */
+static long sysfs_cache_bytes(int level)
+{
+    char path[128];
+    char buf[64];
+
+    for (int idx = 0; idx < 8; ++idx)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        FILE *fp = fopen(path, "r");
+        if (!fp)
+            break;
+        int found_level = 0;
+        if (fscanf(fp, "%d", &found_level) != 1)
+            found_level = 0;
+        fclose(fp);
+        if (found_level != level)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        fp = fopen(path, "r");
+        if (!fp)
+            continue;
+        int usable = fgets(buf, sizeof(buf), fp) && strncmp(buf, "Instruction", 11) != 0;
+        fclose(fp);
+        if (!usable)
+            continue;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        fp = fopen(path, "r");
+        if (!fp)
+            continue;
+        long size = 0;
+        char unit = 0;
+        int scanned = fscanf(fp, "%ld%c", &size, &unit);
+        fclose(fp);
+        if (scanned < 1)
+            continue;
+        if (unit == 'K')
+            size *= 1024;
+        else if (unit == 'M')
+            size *= 1024 * 1024;
+        return size;
+    }
+    return 0;
+}
+
+long bitonic_cache_bytes(int level)
+{
+    long size = 0;
+
+#if defined(__APPLE__)
+    const char *name = (level == 1) ? "hw.l1dcachesize" : (level == 2) ? "hw.l2cachesize" : "hw.l3cachesize";
+    long long value = 0;
+    size_t len = sizeof(value);
+    if (sysctlbyname(name, &value, &len, NULL, 0) == 0)
+        size = (long)value;
+#else
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    if (level == 1)
+        size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    else if (level == 2)
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    else if (level == 3)
+        size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if (size <= 0)
+        size = sysfs_cache_bytes(level);
+#endif
+
+    return size > 0 ? size : 0;
+}
+
+int bitonic_tile_elems(size_t elem_size)
+{
+    const char *env = getenv("BITONIC_TILE");
+    long budget;
+    long tile = 1;
+
+    if (env)
+    {
+        long requested = atol(env);
+        if (requested <= 0)
+            return 0;
+        while (tile * 2 <= requested)
+            tile <<= 1;
+        return (int)tile;
+    }
+
+    // Half of L2 leaves room for the other half of a stage's stream and prefetch
+    budget = bitonic_cache_bytes(2);
+    if (budget <= 0)
+        budget = BITONIC_DEFAULT_L2;
+    budget /= 2;
+
+    while ((tile * 2) * (long)elem_size <= budget)
+        tile <<= 1;
+    if (tile < BITONIC_MIN_TILE)
+        tile = BITONIC_MIN_TILE;
+    return (int)tile;
+}
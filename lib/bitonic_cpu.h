@@ -0,0 +1,31 @@
+#ifndef BITONIC_CPU_H
+#define BITONIC_CPU_H
+
+#include <stddef.h>
+
+/**
+ * Host introspection used to tune the sorters to the machine they run on.
+ */
+
+/**
+ * Function: bitonic_cache_bytes
+ * -----------------------------
+ * Returns the size in bytes of the level-'level' data (or unified) cache of
+ * the first CPU, or 0 if it cannot be determined.
+ */
+long bitonic_cache_bytes(int level);
+
+/**
+ * Function: bitonic_tile_elems
+ * ----------------------------
+ * Returns the tile size (in elements of elem_size bytes) for the cache-blocked
+ * bitonic schedule: the largest power of 2 whose footprint fits in half of
+ * the per-core L2 cache, never below 1024 elements.
+ *
+ * BITONIC_TILE=<elements> in the environment overrides the detected value
+ * (rounded down to a power of 2); BITONIC_TILE=0 returns 0, which selects the
+ * unblocked schedule.
+ */
+int bitonic_tile_elems(size_t elem_size);
+
+#endif
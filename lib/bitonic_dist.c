@@ -0,0 +1,1750 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitonic_dist.h"
+
+#include <limits.h>
+#include <omp.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitonic_adaptive.h"
+#include "bitonic_omp.h"
+#include "bitonic_simd.h"
+#include "bitonic_trace.h"
+
+/**
+ * Function: bitonic_dist_chunk
+ * --------------------------
+ * Elements per rank for 'count' values over world_size ranks: ceil(count / P).
+ * Every rank sorts and exchanges a block of this length; only the last
+ * non-empty rank(s) hold fewer real values and pad their block locally, so
+ * at most world_size - 1 padding elements exist in total.
+ */
+long long bitonic_dist_chunk(long long count, int world_size)
+{
+    return (count + world_size - 1) / world_size;
+}
+
+/**
+ * Function: bitonic_dist_layout
+ * ---------------------------
+ * Counts and displacements for bitonic_dist_scatterv / bitonic_dist_gatherv:
+ * rank r owns the global positions [r * chunk, (r + 1) * chunk) clipped to
+ * 'count', so the real values are contiguous and the padding never leaves
+ * its rank.
+ */
+void bitonic_dist_layout(long long count, long long chunk, int world_size, long long *counts, long long *displs)
+{
+    for (int r = 0; r < world_size; ++r)
+    {
+        long long lo = r * chunk;
+        long long hi = lo + chunk;
+        if (lo > count)
+            lo = count;
+        if (hi > count)
+            hi = count;
+        counts[r] = hi - lo;
+        displs[r] = lo;
+    }
+}
+
+/* Largest count or displacement handed to one MPI collective; past it the
+   layouts go through transfer_pieces. tests/large_count.sh lowers this and
+   the piece sizes below with -D to run the large-count paths on small data */
+#ifndef DIST_INT_LIMIT
+#define DIST_INT_LIMIT INT_MAX
+#endif
+
+/* Largest message, in bytes, of the point-to-point large-count transfers */
+#ifndef DIST_PIECE_BYTES
+#define DIST_PIECE_BYTES (1 << 30)
+#endif
+
+/* Elements of 'type' per message piece */
+static long long piece_elements(MPI_Datatype type, MPI_Aint *extent)
+{
+    MPI_Aint lb;
+    MPI_Type_get_extent(type, &lb, extent);
+    return (*extent < DIST_PIECE_BYTES) ? DIST_PIECE_BYTES / *extent : 1;
+}
+
+/**
+ * Function: transfer_pieces
+ * -------------------------
+ * Point-to-point form of the v-collectives for counts past INT_MAX: sends
+ * send_counts[r] elements of 'type' from send + send_displs[r] to every
+ * rank r and receives recv_counts[r] into recv + recv_displs[r]. Messages
+ * go in rounds of at most one DIST_PIECE_BYTES piece per peer and
+ * direction; both sides cut the same pieces from the same counts, and a
+ * rank leaves once its own pieces are done. The own block is copied.
+ */
+static void transfer_pieces(MPI_Comm comm, MPI_Datatype type, const void *send, const long long *send_counts,
+                            const long long *send_displs, void *recv, const long long *recv_counts,
+                            const long long *recv_displs)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    MPI_Aint extent;
+    long long piece = piece_elements(type, &extent);
+    if (send_counts[rank] > 0)
+        memcpy((char *)recv + (size_t)recv_displs[rank] * extent,
+               (const char *)send + (size_t)send_displs[rank] * extent, (size_t)send_counts[rank] * extent);
+
+    MPI_Request *reqs = malloc(2 * (size_t)size * sizeof(MPI_Request));
+    if (!reqs)
+    {
+        fprintf(stderr, "Rank %d failed to allocate transfer requests\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    for (long long done = 0;; done += piece)
+    {
+        int posted = 0;
+        for (int r = 0; r < size; ++r)
+        {
+            if (r == rank)
+                continue;
+            if (recv_counts[r] > done)
+            {
+                long long len = (recv_counts[r] - done < piece) ? recv_counts[r] - done : piece;
+                MPI_Irecv((char *)recv + (size_t)(recv_displs[r] + done) * extent, (int)len, type, r, 2, comm,
+                          &reqs[posted++]);
+            }
+            if (send_counts[r] > done)
+            {
+                long long len = (send_counts[r] - done < piece) ? send_counts[r] - done : piece;
+                MPI_Isend((const char *)send + (size_t)(send_displs[r] + done) * extent, (int)len, type, r, 2,
+                          comm, &reqs[posted++]);
+            }
+        }
+        if (posted == 0)
+            break;
+        MPI_Waitall(posted, reqs, MPI_STATUSES_IGNORE);
+    }
+    free(reqs);
+}
+
+/* 1 if every count and displacement, and so every block end, fits an int */
+static int fits_int(const long long *counts, const long long *displs, int n)
+{
+    for (int r = 0; r < n; ++r)
+    {
+        if (counts[r] + displs[r] > DIST_INT_LIMIT)
+            return 0;
+    }
+    return 1;
+}
+
+/* int copies of 'n' counts and displacements for the MPI v-collectives */
+static int *int_layout(const long long *counts, const long long *displs, int n)
+{
+    int *out = malloc(2 * (size_t)n * sizeof(int));
+    for (int r = 0; out && r < n; ++r)
+    {
+        out[r] = (int)counts[r];
+        out[n + r] = (int)displs[r];
+    }
+    return out;
+}
+
+/**
+ * Function: root_transfer
+ * -----------------------
+ * Shared body of bitonic_dist_scatterv and bitonic_dist_gatherv: one
+ * MPI_Scatterv / MPI_Gatherv while the layout fits an int, otherwise
+ * transfer_pieces between the root and every rank.
+ */
+static void root_transfer(MPI_Comm comm, int gather, void *all, const long long *counts, const long long *displs,
+                          void *local, MPI_Datatype type, int root)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    if (fits_int(counts, displs, size))
+    {
+        int *layout = int_layout(counts, displs, size);
+        if (!layout)
+        {
+            fprintf(stderr, "Rank %d failed to allocate transfer counts\n", rank);
+            MPI_Abort(comm, 1);
+        }
+        if (gather)
+            MPI_Gatherv(local, layout[rank], type, all, layout, layout + size, type, root, comm);
+        else
+            MPI_Scatterv(all, layout, layout + size, type, local, layout[rank], type, root, comm);
+        free(layout);
+        return;
+    }
+
+    // Only the root talks to the others: zero counts everywhere else
+    long long *zero = calloc(2 * (size_t)size, sizeof(long long));
+    if (!zero)
+    {
+        fprintf(stderr, "Rank %d failed to allocate transfer counts\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    long long *own = zero + size;
+    own[root] = counts[rank];
+    const long long *root_counts = (rank == root) ? counts : zero;
+    const long long *root_displs = (rank == root) ? displs : zero;
+    if (gather)
+        transfer_pieces(comm, type, local, own, zero, all, root_counts, root_displs);
+    else
+        transfer_pieces(comm, type, all, root_counts, root_displs, local, own, zero);
+    free(zero);
+}
+
+void bitonic_dist_scatterv(MPI_Comm comm, const void *all, const long long *counts, const long long *displs,
+                           void *local, MPI_Datatype type, int root)
+{
+    root_transfer(comm, 0, (void *)all, counts, displs, local, type, root);
+}
+
+void bitonic_dist_gatherv(MPI_Comm comm, const void *local, void *all, const long long *counts,
+                          const long long *displs, MPI_Datatype type, int root)
+{
+    root_transfer(comm, 1, all, counts, displs, (void *)local, type, root);
+}
+
+/**
+ * Function: int_compare
+ * ---------------------
+ * Comparison function for qsort to sort integers in ascending order.
+ * 
+ 
+ * 
+ * Purpose: Used by qsort() to compare two integers (--local-sort=qsort baseline)
+ */
+static int int_compare(const void *a, const void *b)
+{
+    int lhs = *(const int *)a;
+    int rhs = *(const int *)b;
+    if (lhs < rhs)
+        return -1;
+    if (lhs > rhs)
+        return 1;
+    return 0;
+}
+
+/**
+ * Function: compare_and_swap
+ * --------------------------
+ * Bitonic comparator: compares two elements and swaps them if they're in wrong order.
+ * This is the fundamental operation in bitonic sort.
+
+ * 
+ * Purpose: Ensures elements are ordered correctly based on sort direction
+ * - If direction is ascending (1): ensures a <= b
+ * - If direction is descending (0): ensures a >= b
+ */
+static void compare_and_swap(int *a, int *b, int direction)
+{
+    if ((direction == 1 && *a > *b) || (direction == 0 && *a < *b))
+    {
+        int tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+}
+
+/**
+ * Function: bitonic_merge
+ * -----------------------
+ * Recursively merges two bitonic sequences into one sorted sequence.
+ * A bitonic sequence is one that first increases then decreases (or vice versa).
+ *
+ * 
+ * Algorithm (any size, not only powers of 2):
+ * 1. Let mid be the largest power of 2 below size and compare and swap
+ *    elements that are 'mid' apart (the first size - mid of them)
+ * 2. Recursively merge [start, start + mid) and the remaining size - mid
+ * 
+ * Purpose: Merges two adjacent bitonic sequences into one sorted sequence
+ */
+static void bitonic_merge(int *data, long long start, long long size, int direction)
+{
+    if (size > 1)
+    {
+        long long mid = 1;
+        while (mid < size - mid)
+        {
+            mid <<= 1;  // Largest power of 2 below size
+        }
+        // Compare elements in first part with corresponding elements in second part
+        for (long long i = start; i < start + size - mid; ++i)
+        {
+            compare_and_swap(&data[i], &data[i + mid], direction);
+        }
+        // Recursively merge both parts
+        bitonic_merge(data, start, mid, direction);
+        bitonic_merge(data, start + mid, size - mid, direction);
+    }
+}
+
+/**
+ * Function: bitonic_sort_recursive
+ * --------------------------------
+ * Recursively builds and sorts a bitonic sequence using divide-and-conquer.
+ * This is the classic recursive bitonic sort algorithm.
+ * 
+ * Algorithm:
+ * 1. Divide array into two halves
+ * 2. Sort first half in ascending order (creates ascending bitonic sequence)
+ * 3. Sort second half in descending order (creates descending bitonic sequence)
+ * 4. Merge both halves to get final sorted sequence
+ * 
+ * Purpose: Each MPI process uses this to sort its local data before distributed merge
+ */
+static void bitonic_sort_recursive(int *data, long long start, long long size, int direction)
+{
+    if (size > 1)
+    {
+        long long mid = size / 2;
+        // Sort first half in the opposite direction
+        bitonic_sort_recursive(data, start, mid, !direction);
+        // Sort second half in the desired direction
+        bitonic_sort_recursive(data, start + mid, size - mid, direction);
+        // Merge entire sequence in desired direction
+        bitonic_merge(data, start, size, direction);
+    }
+}
+
+/**
+ * Function: bitonic_dist_engine_valid
+ * ---------------------------------
+ * Returns 1 if bitonic_dist_local_sort accepts 'engine_name'.
+ */
+int bitonic_dist_engine_valid(const char *engine_name)
+{
+    local_sort_engine engine;
+    bitonic_engine schedule;
+    return strcmp(engine_name, "recursive") == 0 || strcmp(engine_name, "qsort") == 0 ||
+           strcmp(engine_name, "openmp") == 0 || bitonic_engine_parse(engine_name, &schedule) == 0 ||
+           local_sort_parse(engine_name, &engine) == 0;
+}
+
+/**
+ * Function: bitonic_dist_local_sort
+ * ---------------------------------
+ * Runs the selected local-sort engine on this rank's block.
+ * "recursive" is the classic bitonic_sort_recursive above, "qsort" the C
+ * library baseline and "openmp" the OpenMP bitonic engine (lib/bitonic_omp.c,
+ * also used by the OpenMP program) in the context's schedule; "flat",
+ * "blocks" and "tasks" pick that schedule for this call. Every other name is
+ * an engine from lib/bitonic_local.c (radix, hybrid, bitonic, insertion).
+ * All but the first two run on the context's team and take their scratch
+ * from it.
+ */
+int bitonic_dist_local_sort(bitonic_context *ctx, int *data, long long local_n, const char *engine_name)
+{
+    local_sort_engine engine;
+    bitonic_engine schedule;
+    bitonic_trace_mark trace;
+
+    // The library engines trace their own sort phase
+    if (strcmp(engine_name, "recursive") == 0)
+    {
+        bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+        bitonic_sort_recursive(data, 0, local_n, 1);
+        bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    }
+    else if (strcmp(engine_name, "qsort") == 0)
+    {
+        bitonic_trace_begin(BITONIC_PHASE_SORT, &trace);
+        qsort(data, local_n, sizeof(int), int_compare);
+        bitonic_trace_end(BITONIC_PHASE_SORT, &trace);
+    }
+    else if (strcmp(engine_name, "openmp") == 0)
+    {
+        return bitonic_sort(ctx, data, local_n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE);
+    }
+    else if (bitonic_engine_parse(engine_name, &schedule) == 0)
+    {
+        bitonic_engine saved = bitonic_context_engine(ctx);
+        bitonic_context_set_engine(ctx, schedule);
+        int status = bitonic_sort(ctx, data, local_n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE);
+        bitonic_context_set_engine(ctx, saved);
+        return status;
+    }
+    else if (local_sort_parse(engine_name, &engine) == 0)
+    {
+        return bitonic_sort_local(ctx, data, local_n, engine);
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* Elements per message in the pipelined compare-split */
+#ifndef EXCHANGE_CHUNK
+#define EXCHANGE_CHUNK 65536
+#endif
+
+/**
+ * Structure: exchange_buffers
+ * ---------------------------
+ * Scratch space for merge_exchange, taken from the context's arena once per
+ * exchange and reused by every round of the network: one local_n output
+ * array (swapped with the local array after each round) and two ping-pong
+ * receive chunks. The hybrid (threaded) exchange instead receives the whole
+ * partner block, so it gets a local_n receive array and one request per
+ * chunk.
+ */
+typedef struct
+{
+    int *scratch;            // Output of the current round
+    int *recv[2];            // Ping-pong receive buffers of 'chunk' elements
+    int *recv_all;           // Whole partner block (hybrid mode only)
+    MPI_Request *send_reqs;  // One request per outgoing chunk
+    MPI_Request *recv_reqs;  // One request per incoming chunk (hybrid mode only)
+    int chunk;               // Elements per message
+    int chunks;              // Messages per round: ceil(local_n / chunk)
+    int threads;             // Threads per rank for the hybrid exchange (1 = pipelined)
+    MPI_Comm comm;           // Communicator of the exchange network
+} exchange_buffers;
+
+static void exchange_buffers_init(exchange_buffers *buf, bitonic_context *ctx, MPI_Comm comm, long long local_n,
+                                  int threads)
+{
+    buf->comm = comm;
+    buf->chunk = (int)((local_n < EXCHANGE_CHUNK) ? local_n : EXCHANGE_CHUNK);
+    buf->chunks = (int)((local_n + buf->chunk - 1) / buf->chunk);
+    buf->threads = threads;
+    buf->scratch = bitonic_context_alloc(ctx, (size_t)local_n * sizeof(int));
+    buf->send_reqs = bitonic_context_alloc(ctx, buf->chunks * sizeof(MPI_Request));
+    if (threads > 1)
+    {
+        buf->recv[0] = buf->recv[1] = NULL;
+        buf->recv_all = bitonic_context_alloc(ctx, (size_t)local_n * sizeof(int));
+        buf->recv_reqs = bitonic_context_alloc(ctx, buf->chunks * sizeof(MPI_Request));
+    }
+    else
+    {
+        buf->recv[0] = bitonic_context_alloc(ctx, (size_t)buf->chunk * sizeof(int));
+        buf->recv[1] = bitonic_context_alloc(ctx, (size_t)buf->chunk * sizeof(int));
+        buf->recv_all = NULL;
+        buf->recv_reqs = NULL;
+    }
+    if (!buf->scratch || !buf->send_reqs ||
+        (threads > 1 ? (!buf->recv_all || !buf->recv_reqs) : (!buf->recv[0] || !buf->recv[1])))
+    {
+        fprintf(stderr, "Memory allocation failed during merge\n");
+        MPI_Abort(comm, 1);
+    }
+}
+
+/**
+ * Structure: chunk_stream
+ * -----------------------
+ * Receiving side of the pipeline: chunk c lands in recv[c % 2] while the
+ * merge consumes chunk c - 1 from the other buffer.
+ */
+typedef struct
+{
+    exchange_buffers *buf;
+    MPI_Request reqs[2];
+    int partner;
+    long long local_n;
+    int posted;   // Chunks with a posted MPI_Irecv
+    int current;  // Chunk being consumed
+} chunk_stream;
+
+static int chunk_length(const exchange_buffers *buf, long long local_n, int c)
+{
+    long long remaining = local_n - (long long)c * buf->chunk;
+    return (remaining < buf->chunk) ? (int)remaining : buf->chunk;
+}
+
+static void stream_post(chunk_stream *st)
+{
+    int c = st->posted++;
+    MPI_Irecv(st->buf->recv[c % 2], chunk_length(st->buf, st->local_n, c), MPI_INT,
+              st->partner, 0, st->buf->comm, &st->reqs[c % 2]);
+}
+
+/* Waits for chunk st->current and returns its length */
+static int stream_wait(chunk_stream *st)
+{
+    MPI_Wait(&st->reqs[st->current % 2], MPI_STATUS_IGNORE);
+    return chunk_length(st->buf, st->local_n, st->current);
+}
+
+/* Releases the consumed chunk's buffer for chunk current + 2, then waits for the next one */
+static int stream_advance(chunk_stream *st)
+{
+    if (st->posted < st->buf->chunks)
+        stream_post(st);
+    st->current++;
+    return stream_wait(st);
+}
+
+/**
+ * Function: blocks_in_order
+ * -------------------------
+ * Swaps one boundary value with the partner: the low side's maximum against
+ * the high side's minimum. Returns 1 if the two blocks are already in order
+ * and the compare-split can be skipped.
+ */
+static int blocks_in_order(MPI_Comm comm, const int *mine, long long local_n, int partner, int keep_low)
+{
+    int edge = keep_low ? mine[local_n - 1] : mine[0];
+    int partner_edge;
+    MPI_Sendrecv(&edge, 1, MPI_INT, partner, 1,
+                 &partner_edge, 1, MPI_INT, partner, 1,
+                 comm, MPI_STATUS_IGNORE);
+    int low_max = keep_low ? edge : partner_edge;
+    int high_min = keep_low ? partner_edge : edge;
+    return low_max <= high_min;
+}
+
+/**
+ * Function: post_sends
+ * --------------------
+ * Posts every outgoing chunk with MPI_Isend in the order the partner merges
+ * them: back to front from the low side (the partner keeps the high half),
+ * front to back from the high side. 'mine' must not be written until
+ * buf->send_reqs complete.
+ */
+static void post_sends(const int *mine, long long local_n, int partner, int keep_low,
+                       exchange_buffers *buf)
+{
+    for (int c = 0; c < buf->chunks; ++c)
+    {
+        int len = chunk_length(buf, local_n, c);
+        long long begin = keep_low ? local_n - (long long)c * buf->chunk - len : (long long)c * buf->chunk;
+        MPI_Isend(mine + begin, len, MPI_INT, partner, 0, buf->comm, &buf->send_reqs[c]);
+    }
+}
+
+/**
+ * Function: merge_exchange
+ * ------------------------
+ * Performs a pipelined compare-split operation between two MPI processes.
+ * This is the distributed version of compare_and_swap for inter-process communication.
+ * 
+ * @param local: In/out pointer to the local array of this process (sorted
+ *               ascending); swapped with buf->scratch when data moves
+ * @param local_n: Number of elements in local array
+ * @param partner: Rank of the partner process to exchange with
+ * @param keep_low: 1 = keep the smaller half, 0 = keep the larger half
+ * @param buf: Preallocated buffers shared by all rounds
+ * 
+ * Algorithm:
+ * 1. Swap one boundary value; if the two blocks are already in order there
+ *    is nothing to exchange
+ * 2. Send all local chunks with MPI_Isend in the order the partner merges
+ *    them (back to front for the low side, front to back for the high side)
+ * 3. Receive the partner's chunks into two ping-pong buffers with MPI_Irecv
+ *    and merge each one as soon as it lands, overlapping transfer and merge
+ * 4. Produce only the local_n elements this rank keeps: the low side merges
+ *    from the front, the high side from the back
+ * 
+ * Purpose: Enables distributed bitonic sort by allowing processes to exchange
+ *          and redistribute data to maintain global sort order
+ */
+static void merge_exchange(int **local, long long local_n, int partner, int keep_low,
+                           exchange_buffers *buf)
+{
+    int *mine = *local;
+    int *out = buf->scratch;
+
+    // Step 1: Nothing to do if the blocks are already in order
+    if (blocks_in_order(buf->comm, mine, local_n, partner, keep_low))
+        return;
+
+    chunk_stream st = {buf, {MPI_REQUEST_NULL, MPI_REQUEST_NULL}, partner, local_n, 0, 0};
+    stream_post(&st);
+    if (buf->chunks > 1)
+        stream_post(&st);
+
+    // Step 2: Post every outgoing chunk; 'mine' is not written until the swap
+    post_sends(mine, local_n, partner, keep_low, buf);
+
+    // Steps 3-4: Merge chunk by chunk as they arrive
+    int len = stream_wait(&st);
+    int *theirs = buf->recv[0];
+    if (keep_low)
+    {
+        // Smallest local_n: partner chunks arrive front to back
+        long long i = 0;
+        int t = 0;
+        for (long long m = 0; m < local_n; ++m)
+        {
+            if (t == len && st.current + 1 < buf->chunks)
+            {
+                len = stream_advance(&st);
+                theirs = buf->recv[st.current % 2];
+                t = 0;
+            }
+            if (t < len && (i == local_n || theirs[t] < mine[i]))
+                out[m] = theirs[t++];
+            else
+                out[m] = mine[i++];
+        }
+    }
+    else
+    {
+        // Largest local_n: partner chunks arrive back to front
+        long long i = local_n - 1;
+        int t = len - 1;
+        for (long long m = local_n - 1; m >= 0; --m)
+        {
+            if (t < 0 && st.current + 1 < buf->chunks)
+            {
+                len = stream_advance(&st);
+                theirs = buf->recv[st.current % 2];
+                t = len - 1;
+            }
+            if (t >= 0 && (i < 0 || theirs[t] > mine[i]))
+                out[m] = theirs[t--];
+            else
+                out[m] = mine[i--];
+        }
+    }
+
+    // Drain chunks the merge did not need (the partner sent them anyway)
+    while (st.current + 1 < buf->chunks)
+        stream_advance(&st);
+    MPI_Waitall(buf->chunks, buf->send_reqs, MPI_STATUSES_IGNORE);
+
+    // The merged half becomes the local array; the old one is next round's scratch
+    buf->scratch = mine;
+    *local = out;
+}
+
+/* Spins until the communication thread has published 'needed' elements */
+static void wait_for_elements(atomic_llong *arrived, long long needed)
+{
+    while (atomic_load_explicit(arrived, memory_order_acquire) < needed)
+        sched_yield();
+}
+
+/**
+ * Function: merge_exchange_hybrid
+ * -------------------------------
+ * Threaded compare-split for the hybrid MPI + OpenMP mode. Same contract as
+ * merge_exchange, but inside one OpenMP region:
+ * - Thread 0 (the master thread, so MPI_THREAD_FUNNELED is enough) is the
+ *   communication thread: it posts the sends and chunked receives, and
+ *   publishes how many partner elements have landed after each chunk
+ * - The other threads split the kept half into equal merge-path segments
+ *   and each merges its segment as soon as the partner data it needs has
+ *   arrived, in arrival order (front first for the low side, back first for
+ *   the high side), so merging overlaps the transfer
+ */
+static void merge_exchange_hybrid(int **local, long long local_n, int partner, int keep_low,
+                                  exchange_buffers *buf)
+{
+    int *mine = *local;
+    int *out = buf->scratch;
+    int *theirs = buf->recv_all;
+    long long n = local_n;
+    atomic_llong arrived;
+
+    if (blocks_in_order(buf->comm, mine, local_n, partner, keep_low))
+        return;
+
+    atomic_init(&arrived, 0);
+
+#pragma omp parallel num_threads(buf->threads)
+    {
+        int tid = omp_get_thread_num();
+        int team = omp_get_num_threads();
+
+        if (tid == 0)
+        {
+            post_sends(mine, local_n, partner, keep_low, buf);
+            for (int c = 0; c < buf->chunks; ++c)
+            {
+                int len = chunk_length(buf, local_n, c);
+                long long begin = keep_low ? (long long)c * buf->chunk : local_n - (long long)c * buf->chunk - len;
+                MPI_Irecv(theirs + begin, len, MPI_INT, partner, 0, buf->comm, &buf->recv_reqs[c]);
+            }
+            for (int c = 0; c < buf->chunks; ++c)
+            {
+                MPI_Wait(&buf->recv_reqs[c], MPI_STATUS_IGNORE);
+                atomic_fetch_add_explicit(&arrived, chunk_length(buf, local_n, c), memory_order_release);
+            }
+            MPI_Waitall(buf->chunks, buf->send_reqs, MPI_STATUSES_IGNORE);
+        }
+
+        // Merge workers; a team of one thread merges after communicating
+        int workers = (team > 1) ? team - 1 : 1;
+        int w = (team > 1) ? tid - 1 : 0;
+        if (team == 1 || tid > 0)
+        {
+            if (keep_low)
+            {
+                // Output = first n of merge(mine, theirs); segment w of [0, n)
+                long long m0 = n * w / workers;
+                long long m1 = n * (w + 1) / workers;
+                wait_for_elements(&arrived, m1);
+                bitonic_merge_range(mine, n, theirs, n, m0, m1, out + m0);
+            }
+            else
+            {
+                // Output = last n of merge(mine, theirs); segment w counted from the back
+                long long m1 = 2 * n - n * w / workers;
+                long long m0 = 2 * n - n * (w + 1) / workers;
+                wait_for_elements(&arrived, 2 * n - m0);
+                bitonic_merge_range(mine, n, theirs, n, m0, m1, out + (m0 - n));
+            }
+        }
+    }
+
+    buf->scratch = mine;
+    *local = out;
+}
+
+/**
+ * Function: bitonic_dist_exchange
+ * -------------------------------
+ * Distributed bitonic merge across ranks (world_size must be a power of 2).
+ * Each rank is one "element" of a bitonic network whose comparators are
+ * compare-split rounds with hypercube partners rank ^ j, so log(P)*(log(P)+1)/2
+ * pairwise rounds replace the gather + serial merge on rank 0.
+ * 
+ * On entry every rank holds a locally sorted block; on return the blocks are
+ * globally ordered by rank (rank r holds the r-th smallest local_n values).
+ * Rounds alternate between 'local' and an arena buffer; if the result ends
+ * in the arena buffer it is copied back once.
+ * With threads > 1 every round uses the threaded hybrid exchange.
+ */
+void bitonic_dist_exchange(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n, int threads)
+{
+    int rank, world_size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &world_size);
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_EXCHANGE, &trace);
+    size_t mark = bitonic_context_mark(ctx);
+    exchange_buffers buf;
+    exchange_buffers_init(&buf, ctx, comm, local_n, threads);
+    int *data = local;
+    int round = 0;
+
+    // k is the size (in ranks) of the bitonic sequences being merged
+    for (int k = 2; k <= world_size; k <<= 1)
+    {
+        // j is the hypercube dimension exchanged in this round
+        for (int j = k >> 1; j > 0; j >>= 1, ++round)
+        {
+            int partner = rank ^ j;
+            int ascending = ((rank & k) == 0);
+            int keep_low = ((rank < partner) == ascending);
+            int *before = data;
+            double start = bitonic_trace_on ? MPI_Wtime() : 0.0;
+            if (threads > 1)
+                merge_exchange_hybrid(&data, local_n, partner, keep_low, &buf);
+            else
+                merge_exchange(&data, local_n, partner, keep_low, &buf);
+            if (bitonic_trace_on)
+            {
+                // The boundary swap always runs; the block moves unless it was skipped
+                size_t bytes = sizeof(int) + ((data != before) ? (size_t)local_n * sizeof(int) : 0);
+                bitonic_trace_round(round, partner, bytes, bytes, MPI_Wtime() - start);
+            }
+        }
+    }
+
+    if (data != local)
+        memcpy(local, data, (size_t)local_n * sizeof(int));
+    bitonic_context_release(ctx, mark);
+    bitonic_trace_end(BITONIC_PHASE_EXCHANGE, &trace);
+}
+
+/**
+ * Function: bitonic_dist_merge_rank0
+ * ---------------------------------
+ * Serial bottom-up merge of the sorted chunks of chunk_n elements (the last
+ * one may be shorter) that make up all_data[0, count) (rank 0 only). Used by the --rank0-merge mode and as the fallback
+ * when world_size is not a power of 2.
+ */
+int bitonic_dist_merge_rank0(bitonic_context *ctx, int *all_data, long long count, long long chunk_n)
+{
+    // Temporary buffer for merge operations, from the context's arena
+    size_t mark = bitonic_context_mark(ctx);
+    int *temp_buf = bitonic_context_alloc(ctx, (size_t)count * sizeof(int));
+    if (!temp_buf)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_MERGE, &trace);
+
+    // Iteratively merge sorted chunks (merge sort approach)
+    // Start with chunks of size chunk_n, double merge_width each iteration
+    int *current = all_data;
+    int *next = temp_buf;
+
+    for (long long merge_width = chunk_n; merge_width < count; merge_width *= 2)
+    {
+        long long res_idx = 0;
+        // Merge pairs of sorted subarrays
+        for (long long base = 0; base < count; base += 2 * merge_width)
+        {
+            long long left_end = base + merge_width;
+            long long right_end = (base + 2 * merge_width < count) ? base + 2 * merge_width : count;
+            if (left_end > count)
+                left_end = count;
+
+            // Merge two sorted subarrays: [base, left_end) and [left_end, right_end)
+            long long l = base, r = left_end;
+            while (l < left_end && r < right_end)
+            {
+                if (current[l] <= current[r])
+                {
+                    next[res_idx++] = current[l++];
+                }
+                else
+                {
+                    next[res_idx++] = current[r++];
+                }
+            }
+            // Copy remaining elements
+            while (l < left_end)
+                next[res_idx++] = current[l++];
+            while (r < right_end)
+                next[res_idx++] = current[r++];
+        }
+
+        // Swap buffers (avoid copying entire array)
+        int *swap = current;
+        current = next;
+        next = swap;
+    }
+
+    // Copy result back to all_data if needed
+    if (current != all_data)
+    {
+        memcpy(all_data, current, count * sizeof(int));
+    }
+
+    bitonic_trace_end(BITONIC_PHASE_MERGE, &trace);
+    bitonic_context_release(ctx, mark);
+    return 0;
+}
+
+/**
+ * Function: bitonic_dist_topk
+ * ---------------------------
+ * Binomial-tree reduction of the per-rank top-k lists: each rank first
+ * selects its own k smallest values (bitonic_topk), then in round s a rank
+ * whose bit s is set sends its list to rank - 2^s and drops out, and the
+ * receiver keeps the k smallest of both lists with one truncated bitonic
+ * merge. Every message carries at most k values, so the volume is
+ * O(k log P) on the critical path instead of the full array.
+ */
+long long bitonic_dist_topk(bitonic_context *ctx, MPI_Comm comm, const int *local, long long local_n, long long k,
+                            int *out)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (k <= 0)
+        return 0;
+
+    // The own list and an incoming one, each padded to a power of 2
+    long long width = bitonic_omp_topk_width(k);
+    size_t mark = bitonic_context_mark(ctx);
+    int *pair = bitonic_context_alloc(ctx, 2 * (size_t)width * sizeof(int));
+    if (!pair)
+    {
+        fprintf(stderr, "Rank %d failed to allocate top-k buffers\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    long long mine = bitonic_topk(ctx, local, local_n, k, pair);
+    if (mine < 0)
+    {
+        fprintf(stderr, "Rank %d failed to select its top-k\n", rank);
+        MPI_Abort(comm, 1);
+    }
+
+    // Lists go in pieces of at most DIST_PIECE_BYTES; one shorter than a full
+    // piece (possibly empty) ends a list, so short lists stay one message
+    MPI_Aint extent;
+    long long piece = piece_elements(MPI_INT, &extent);
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_EXCHANGE, &trace);
+    for (int step = 1, round = 0; step < size; step <<= 1, ++round)
+    {
+        double start = bitonic_trace_on ? MPI_Wtime() : 0.0;
+        if (rank & step)
+        {
+            for (long long done = 0;; done += piece)
+            {
+                int len = (int)((mine - done < piece) ? mine - done : piece);
+                MPI_Send(pair + done, len, MPI_INT, rank - step, 0, comm);
+                if (len < piece)
+                    break;
+            }
+            if (bitonic_trace_on)
+                bitonic_trace_round(round, rank - step, (size_t)mine * sizeof(int), 0, MPI_Wtime() - start);
+            break;
+        }
+        if (rank + step >= size)
+            continue;
+
+        long long got = 0;
+        for (;;)
+        {
+            MPI_Status status;
+            int len;
+            MPI_Recv(pair + width + got, (int)((k - got < piece) ? k - got : piece), MPI_INT, rank + step, 0, comm,
+                     &status);
+            MPI_Get_count(&status, MPI_INT, &len);
+            got += len;
+            if (len < piece)
+                break;
+        }
+        for (long long i = mine; i < width; ++i)
+            pair[i] = INT_MAX;
+        for (long long i = width + got; i < 2 * width; ++i)
+            pair[i] = INT_MAX;
+        bitonic_simd_merge_low(pair, width);
+        mine = (mine + got < k) ? mine + got : k;
+        if (bitonic_trace_on)
+            bitonic_trace_round(round, rank + step, 0, (size_t)got * sizeof(int), MPI_Wtime() - start);
+    }
+    bitonic_trace_end(BITONIC_PHASE_EXCHANGE, &trace);
+
+    if (rank == 0)
+        memcpy(out, pair, (size_t)mine * sizeof(int));
+    bitonic_context_release(ctx, mark);
+    return (rank == 0) ? mine : 0;
+}
+
+/*
+ * Sample sort
+ *
+ * A single-round alternative to the exchange network for any process count
+ * and uneven blocks: sort locally, pick P - 1 splitters from regular
+ * samples, redistribute with one MPI_Alltoallv and merge the P received runs.
+ */
+
+/**
+ * Structure: sample_key
+ * ---------------------
+ * A value tagged with its global position in the locally sorted blocks
+ * (rank offset + index). Splitters compare (value, position), so a run of
+ * equal values is cut between ranks like any other run instead of landing
+ * on one rank.
+ */
+typedef struct
+{
+    long long value;
+    long long position;
+} sample_key;
+
+static int sample_compare(const void *a, const void *b)
+{
+    const sample_key *x = a;
+    const sample_key *y = b;
+    if (x->value != y->value)
+        return (x->value < y->value) ? -1 : 1;
+    return (x->position > y->position) - (x->position < y->position);
+}
+
+/* Binary search: first index of sorted data[0, n) whose value is >= v (> v if 'upper') */
+static long long bound_of(const int *data, long long n, long long v, int upper)
+{
+    long long lo = 0, hi = n;
+    while (lo < hi)
+    {
+        long long mid = lo + (hi - lo) / 2;
+        if (data[mid] < v || (upper && data[mid] == v))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Function: bitonic_dist_sample_sort
+ * ----------------------------------
+ * Regular-sampling sample sort (PSRS):
+ * 1. Every rank sorts its block with the named engine and takes P - 1
+ *    evenly spaced samples, tagged with their global positions
+ * 2. MPI_Allgatherv shares the samples; every rank sorts them and picks the
+ *    same P - 1 splitters at regular ranks
+ * 3. Binary searches cut the sorted block at the splitters, and one
+ *    MPI_Alltoall of counts plus one MPI_Alltoallv move every value to its
+ *    destination rank (transfer_pieces instead once a count or
+ *    displacement on any rank passes INT_MAX)
+ * 4. The P received sorted runs are merged by a parallel merge tree
+ * Regular sampling bounds every rank's share by about 2n / P, also for
+ * duplicate-heavy input thanks to the (value, position) splitters.
+ */
+int bitonic_dist_sample_sort(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n, const char *engine_name,
+                             int **out, long long *out_n)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    // Step 1: local sort; every rank must agree before the collectives
+    int ok = (local_n < 2 || bitonic_dist_local_sort(ctx, local, local_n, engine_name) == 0);
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    if (!all_ok)
+        return -1;
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_EXCHANGE, &trace);
+    double start = bitonic_trace_on ? MPI_Wtime() : 0.0;
+
+    long long offset = 0, mine_n = local_n;
+    MPI_Exscan(&mine_n, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0)
+        offset = 0;  // MPI_Exscan leaves rank 0's result undefined
+
+    size_t mark = bitonic_context_mark(ctx);
+    int taken = (int)((local_n < size - 1) ? local_n : size - 1);
+    int *ints = bitonic_context_alloc(ctx, (size_t)2 * size * sizeof(int));
+    long long *longs = bitonic_context_alloc(ctx, (size_t)4 * size * sizeof(long long));
+    sample_key *own = bitonic_context_alloc(ctx, (size_t)(taken > 0 ? taken : 1) * sizeof(sample_key));
+    if (!ints || !longs || !own)
+    {
+        fprintf(stderr, "Rank %d failed to allocate sample sort buffers\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    int *sample_counts = ints, *sample_displs = ints + size;
+    long long *send_counts = longs, *send_displs = longs + size;
+    long long *recv_counts = longs + 2 * size, *recv_displs = longs + 3 * size;
+
+    // Step 2: regular samples of every block, gathered everywhere
+    for (int s = 0; s < taken; ++s)
+    {
+        long long i = local_n * (s + 1) / (taken + 1);
+        own[s].value = local[i];
+        own[s].position = offset + i;
+    }
+    MPI_Datatype sample_type;
+    MPI_Type_contiguous(2, MPI_LONG_LONG, &sample_type);
+    MPI_Type_commit(&sample_type);
+    MPI_Allgather(&taken, 1, MPI_INT, sample_counts, 1, MPI_INT, comm);
+    int total = 0;
+    for (int r = 0; r < size; ++r)
+    {
+        sample_displs[r] = total;
+        total += sample_counts[r];
+    }
+    sample_key *samples = bitonic_context_alloc(ctx, (size_t)(total > 0 ? total : 1) * sizeof(sample_key));
+    if (!samples)
+    {
+        fprintf(stderr, "Rank %d failed to allocate sample sort buffers\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    MPI_Allgatherv(own, taken, sample_type, samples, sample_counts, sample_displs, sample_type, comm);
+    MPI_Type_free(&sample_type);
+    qsort(samples, total, sizeof(sample_key), sample_compare);
+
+    // Step 3: cut the block before each splitter and redistribute
+    send_displs[0] = 0;
+    for (int r = 1; r < size; ++r)
+    {
+        long long cut = local_n;
+        if (total > 0)
+        {
+            const sample_key *split = &samples[(long long)total * r / size];
+            long long lo = bound_of(local, local_n, split->value, 0);
+            long long hi = bound_of(local, local_n, split->value, 1);
+            long long before = split->position - offset;  // Equal values ahead of the splitter stay left
+            cut = lo + ((before < lo) ? 0 : (before > hi) ? hi - lo : before - lo);
+        }
+        send_displs[r] = (cut > send_displs[r - 1]) ? cut : send_displs[r - 1];
+        send_counts[r - 1] = send_displs[r] - send_displs[r - 1];
+    }
+    send_counts[size - 1] = local_n - send_displs[size - 1];
+    MPI_Alltoall(send_counts, 1, MPI_LONG_LONG, recv_counts, 1, MPI_LONG_LONG, comm);
+    long long received = 0;
+    for (int r = 0; r < size; ++r)
+    {
+        recv_displs[r] = received;
+        received += recv_counts[r];
+    }
+
+    // The runs land where the merge tree's passes end in the result buffer
+    int passes = 0;
+    for (int runs = size; runs > 1; runs = (runs + 1) / 2)
+        ++passes;
+    int *result = malloc((size_t)(received > 0 ? received : 1) * sizeof(int));
+    int *scratch = bitonic_context_alloc(ctx, (size_t)(received > 0 ? received : 1) * sizeof(int));
+    long long *bounds = bitonic_context_alloc(ctx, (size_t)(size + 1) * sizeof(long long));
+    if (!result || !scratch || !bounds)
+    {
+        fprintf(stderr, "Rank %d failed to allocate sample sort buffers\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    int *runs_in = (passes % 2 == 0) ? result : scratch;
+    int large = !fits_int(send_counts, send_displs, size) || received > DIST_INT_LIMIT, any_large = 0;
+    MPI_Allreduce(&large, &any_large, 1, MPI_INT, MPI_LOR, comm);
+    if (any_large)
+    {
+        transfer_pieces(comm, MPI_INT, local, send_counts, send_displs, runs_in, recv_counts, recv_displs);
+    }
+    else
+    {
+        int *send_layout = int_layout(send_counts, send_displs, size);
+        int *recv_layout = int_layout(recv_counts, recv_displs, size);
+        if (!send_layout || !recv_layout)
+        {
+            fprintf(stderr, "Rank %d failed to allocate sample sort buffers\n", rank);
+            MPI_Abort(comm, 1);
+        }
+        MPI_Alltoallv(local, send_layout, send_layout + size, MPI_INT, runs_in, recv_layout, recv_layout + size,
+                      MPI_INT, comm);
+        free(send_layout);
+        free(recv_layout);
+    }
+    if (bitonic_trace_on)
+        bitonic_trace_round(0, -1, (size_t)(local_n - send_counts[rank]) * sizeof(int),
+                            (size_t)(received - recv_counts[rank]) * sizeof(int), MPI_Wtime() - start);
+    bitonic_trace_end(BITONIC_PHASE_EXCHANGE, &trace);
+
+    // Step 4: merge the P runs
+    bitonic_trace_begin(BITONIC_PHASE_MERGE, &trace);
+    memcpy(bounds, recv_displs, (size_t)size * sizeof(long long));
+    bounds[size] = received;
+    int *merged = bitonic_merge_runs(runs_in, (runs_in == result) ? scratch : result, bounds, size,
+                                     bitonic_context_team(ctx, received));
+    if (merged != result)
+        memcpy(result, merged, (size_t)received * sizeof(int));  // Not reached: runs_in fixes the parity
+    bitonic_trace_end(BITONIC_PHASE_MERGE, &trace);
+
+    bitonic_context_release(ctx, mark);
+    *out = result;
+    *out_n = received;
+    return 0;
+}
+
+/**
+ * Function: bitonic_dist_verify
+ * -----------------------------
+ * Checks a distributed result without gathering it: each block must be
+ * sorted, and each rank's first value must not be smaller than the largest
+ * last value of the ranks before it (an MPI_Exscan, so empty blocks of the
+ * sample sort are skipped). Returns 1 on every rank if the global order
+ * holds.
+ */
+int bitonic_dist_verify(MPI_Comm comm, const int *local, long long local_n)
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    int ok = 1;
+    for (long long i = 1; i < local_n; ++i)
+    {
+        if (local[i - 1] > local[i])
+        {
+            ok = 0;
+            break;
+        }
+    }
+
+    // Largest last value of the non-empty blocks before this one
+    int prev_last = INT_MIN;
+    int my_last = (local_n > 0) ? local[local_n - 1] : INT_MIN;
+    MPI_Exscan(&my_last, &prev_last, 1, MPI_INT, MPI_MAX, comm);
+    if (rank > 0 && local_n > 0 && prev_last > local[0])
+        ok = 0;
+
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    return all_ok;
+}
+
+/* Largest byte count passed to one collective MPI-IO text write */
+#define MPIIO_TEXT_PIECE (1 << 30)
+/* Most values passed to one collective MPI-IO binary read or write */
+#ifndef MPIIO_VALUE_PIECE
+#define MPIIO_VALUE_PIECE (1 << 28)
+#endif
+
+/**
+ * Function: value_rounds
+ * ----------------------
+ * Collective: rounds of at most MPIIO_VALUE_PIECE values needed by the rank
+ * with the most values, so every rank joins every *_at_all call (with a
+ * zero count once its own values are done) and counts past INT_MAX never
+ * reach MPI.
+ */
+static long long value_rounds(MPI_Comm comm, long long have)
+{
+    long long pieces = (have + MPIIO_VALUE_PIECE - 1) / MPIIO_VALUE_PIECE;
+    long long rounds = 0;
+    MPI_Allreduce(&pieces, &rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    return rounds;
+}
+
+/* Values of round r out of 'have', starting at *start */
+static int value_piece(long long have, long long r, long long *start)
+{
+    *start = (r * MPIIO_VALUE_PIECE < have) ? r * MPIIO_VALUE_PIECE : have;
+    return (int)((have - *start < MPIIO_VALUE_PIECE) ? have - *start : MPIIO_VALUE_PIECE);
+}
+
+/**
+ * Function: read_partition
+ * ------------------------
+ * Collective MPI-IO read of a binary input file. Rank 0 reads the header and
+ * broadcasts it; every rank then reads only its own byte range
+ * [r * chunk, (r + 1) * chunk) of the payload with MPI_File_read_at_all and
+ * pads the part past the end of the data with INT_MAX, so no rank ever holds
+ * more than one chunk.
+ *
+ * @param local:   Receives the newly allocated chunk (the caller frees it)
+ * @param local_n: Receives the chunk length
+ * @param count:   Receives the number of values in the file
+ * @return: 0 on success, -1 on error (reported by rank 0)
+ */
+static int read_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int **local, long long *local_n,
+                          long long *count)
+{
+    int rank, world_size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &world_size);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Failed to open input file '%s'\n", path);
+        }
+        return -1;
+    }
+
+    unsigned char header[BITONIC_IO_HEADER_BYTES] = {0};
+    MPI_Offset file_size = 0;
+    MPI_File_get_size(fh, &file_size);
+    if (rank == 0 && file_size >= BITONIC_IO_HEADER_BYTES)
+    {
+        MPI_File_read_at(fh, 0, header, BITONIC_IO_HEADER_BYTES, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    MPI_Bcast(header, BITONIC_IO_HEADER_BYTES, MPI_BYTE, 0, comm);
+
+    int elem;
+    uint64_t total;
+    const char *error = NULL;
+    if (bitonic_decode_header(header, &elem, &total) != 0)
+        error = "--mpi-io needs a binary input file (see docs/RUN.md)";
+    else if (total == 0)
+        error = "Binary input holds no values";
+    else if ((uint64_t)(file_size - BITONIC_IO_HEADER_BYTES) / elem < total)
+        error = "Binary input is truncated";
+    if (error)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "%s\n", error);
+        }
+        MPI_File_close(&fh);
+        return -1;
+    }
+
+    // Same partition as the scatter path (see bitonic_dist_chunk)
+    long long n = (long long)total;
+    long long chunk = bitonic_dist_chunk(n, world_size);
+    long long lo = rank * chunk;
+    long long have = (lo >= n) ? 0 : (n - lo < chunk) ? n - lo : chunk;
+
+    size_t mark = bitonic_context_mark(ctx);
+    int *data = malloc((size_t)chunk * sizeof(int));
+    // int64 payloads are narrowed from a staging buffer in the arena
+    unsigned char *raw = (elem == 4) ? (unsigned char *)data : bitonic_context_alloc(ctx, (size_t)have * elem);
+    if (!data || !raw)
+    {
+        fprintf(stderr, "Rank %d failed to allocate local buffer\n", rank);
+        MPI_Abort(comm, 1);
+    }
+    bitonic_context_first_touch(ctx, data, chunk, sizeof(int));
+
+    MPI_Offset offset = BITONIC_IO_HEADER_BYTES + (MPI_Offset)lo * elem;
+    long long rounds = value_rounds(comm, have);
+    for (long long r = 0; r < rounds; ++r)
+    {
+        long long start;
+        int len = value_piece(have, r, &start);
+        MPI_File_read_at_all(fh, offset + (MPI_Offset)start * elem, raw + (size_t)start * elem, len,
+                             (elem == 4) ? MPI_INT32_T : MPI_INT64_T, MPI_STATUS_IGNORE);
+    }
+    MPI_File_close(&fh);
+
+    int ok = (bitonic_decode_values(raw, elem, have, data) == 0);
+    bitonic_context_release(ctx, mark);
+    for (long long i = have; i < chunk; ++i)
+    {
+        data[i] = INT_MAX;  // Padding sorts to the end
+    }
+
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    if (!all_ok)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Binary input has values outside the int range\n");
+        }
+        free(data);
+        return -1;
+    }
+
+    *local = data;
+    *local_n = chunk;
+    *count = n;
+    return 0;
+}
+
+/**
+ * Function: write_partition
+ * -------------------------
+ * Collective MPI-IO write of the distributed result. This rank writes the
+ * 'have' values of data to global positions [lo, lo + have), so binary
+ * output goes straight to its offset in the file. Text output is formatted
+ * locally and placed at the exclusive prefix sum (MPI_Exscan) of the
+ * formatted lengths.
+ *
+ * @return: 0 on success, -1 on error (reported by rank 0)
+ */
+static int write_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int *data, long long lo,
+                           long long have, long long count, bitonic_output_format format)
+{
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Failed to open output file '%s'\n", path);
+        }
+        return -1;
+    }
+
+    int ok = 1;
+    if (format == BITONIC_OUTPUT_BINARY)
+    {
+        MPI_File_set_size(fh, BITONIC_IO_HEADER_BYTES + (MPI_Offset)count * 4);
+        if (rank == 0)
+        {
+            unsigned char header[BITONIC_IO_HEADER_BYTES];
+            bitonic_encode_header(header, 4, (uint64_t)count);
+            MPI_File_write_at(fh, 0, header, BITONIC_IO_HEADER_BYTES, MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        for (long long i = 0; i < have; ++i)
+        {
+            data[i] = (int)__builtin_bswap32((uint32_t)data[i]);  // File payload is little-endian
+        }
+#endif
+        MPI_Offset offset = BITONIC_IO_HEADER_BYTES + (MPI_Offset)lo * 4;
+        long long rounds = value_rounds(comm, have);
+        for (long long r = 0; r < rounds; ++r)
+        {
+            long long start;
+            int len = value_piece(have, r, &start);
+            if (MPI_File_write_at_all(fh, offset + (MPI_Offset)start * 4, data + start, len, MPI_INT,
+                                      MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            {
+                ok = 0;
+            }
+        }
+    }
+    else
+    {
+        size_t mark = bitonic_context_mark(ctx);
+        char *text = bitonic_context_alloc(ctx, (size_t)have * BITONIC_IO_MAX_TEXT_WIDTH + 1);
+        if (!text)
+        {
+            fprintf(stderr, "Rank %d failed to allocate output buffer\n", rank);
+            MPI_Abort(comm, 1);
+        }
+        long long length = (long long)bitonic_format_text(text, data, have, lo + have == count);
+
+        long long offset = 0;
+        long long total = 0;
+        MPI_Exscan(&length, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+        if (rank == 0)
+        {
+            offset = 0;  // MPI_Exscan leaves rank 0's result undefined
+        }
+        MPI_Allreduce(&length, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+        MPI_File_set_size(fh, (MPI_Offset)total);
+
+        // Collective writes take an int count: split into equal-count rounds
+        long long pieces = (length + MPIIO_TEXT_PIECE - 1) / MPIIO_TEXT_PIECE;
+        long long rounds = 0;
+        MPI_Allreduce(&pieces, &rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+        for (long long r = 0; r < rounds; ++r)
+        {
+            long long start = (r * MPIIO_TEXT_PIECE < length) ? r * MPIIO_TEXT_PIECE : length;
+            int len = (int)((length - start < MPIIO_TEXT_PIECE) ? length - start : MPIIO_TEXT_PIECE);
+            if (MPI_File_write_at_all(fh, (MPI_Offset)(offset + start), text + start, len, MPI_CHAR,
+                                      MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            {
+                ok = 0;
+            }
+        }
+        bitonic_context_release(ctx, mark);
+    }
+
+    MPI_File_close(&fh);
+
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    if (!all_ok && rank == 0)
+    {
+        fprintf(stderr, "Failed to write output file '%s'\n", path);
+    }
+    return all_ok ? 0 : -1;
+}
+
+int bitonic_dist_read_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int **local,
+                                long long *local_n, long long *count)
+{
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_READ, &trace);
+    int status = read_partition(ctx, comm, path, local, local_n, count);
+    bitonic_trace_end(BITONIC_PHASE_READ, &trace);
+    return status;
+}
+
+int bitonic_dist_write_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int *data, long long local_n,
+                                 long long count, bitonic_output_format format)
+{
+    bitonic_trace_mark trace;
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    // Rank r holds [r * local_n, (r + 1) * local_n); padding past 'count' is not written
+    long long lo = rank * local_n;
+    long long have = (lo >= count) ? 0 : (count - lo < local_n) ? count - lo : local_n;
+    bitonic_trace_begin(BITONIC_PHASE_WRITE, &trace);
+    int status = write_partition(ctx, comm, path, data, lo, have, count, format);
+    bitonic_trace_end(BITONIC_PHASE_WRITE, &trace);
+    return status;
+}
+
+int bitonic_dist_write_blocks(bitonic_context *ctx, MPI_Comm comm, const char *path, int *data, long long local_n,
+                              bitonic_output_format format)
+{
+    bitonic_trace_mark trace;
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    // Blocks of any length follow each other in rank order
+    long long lo = 0, mine = local_n, total = 0;
+    MPI_Exscan(&mine, &lo, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0)
+        lo = 0;  // MPI_Exscan leaves rank 0's result undefined
+    MPI_Allreduce(&mine, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    bitonic_trace_begin(BITONIC_PHASE_WRITE, &trace);
+    int status = write_partition(ctx, comm, path, data, lo, local_n, total, format);
+    bitonic_trace_end(BITONIC_PHASE_WRITE, &trace);
+    return status;
+}
+
+/*
+ * Typed records
+ *
+ * Key types other than int and key + index records run through the
+ * type-specialized operations of lib/bitonic_keys.c. Records travel as one
+ * MPI derived datatype, and every compare-split round swaps the whole block
+ * (MPI_Sendrecv calls of at most DIST_PIECE_BYTES) followed by a typed
+ * split.
+ */
+
+/**
+ * Function: key_datatype
+ * ----------------------
+ * MPI datatype of a single key.
+ */
+static MPI_Datatype key_datatype(bitonic_key_type key)
+{
+    switch (key)
+    {
+    case BITONIC_KEY_INT64:
+        return MPI_INT64_T;
+    case BITONIC_KEY_UINT64:
+        return MPI_UINT64_T;
+    case BITONIC_KEY_FLOAT:
+        return MPI_FLOAT;
+    case BITONIC_KEY_DOUBLE:
+        return MPI_DOUBLE;
+    case BITONIC_KEY_INT32:
+    default:
+        return MPI_INT32_T;
+    }
+}
+
+/**
+ * Function: bitonic_dist_record_type
+ * ---------------------------------
+ * Committed MPI datatype of one record: a copy of the key type, or a struct
+ * of key and payload resized to the C record size so arrays of records
+ * (including their padding) can be sent with a plain count.
+ */
+MPI_Datatype bitonic_dist_record_type(const bitonic_key_ops *ops)
+{
+    MPI_Datatype key = key_datatype(ops->key);
+    if (ops->payload == BITONIC_PAYLOAD_NONE)
+    {
+        MPI_Datatype copy;
+        MPI_Type_dup(key, &copy);
+        return copy;
+    }
+
+    int lengths[2] = {1, 1};
+    MPI_Aint offsets[2] = {0, (MPI_Aint)ops->payload_offset};
+    MPI_Datatype types[2] = {key, ops->payload == BITONIC_PAYLOAD_U32 ? MPI_UINT32_T : MPI_UINT64_T};
+    MPI_Datatype packed, record;
+
+    MPI_Type_create_struct(2, lengths, offsets, types, &packed);
+    MPI_Type_create_resized(packed, 0, (MPI_Aint)ops->size, &record);
+    MPI_Type_commit(&record);
+    MPI_Type_free(&packed);
+    return record;
+}
+
+/**
+ * Function: bitonic_dist_exchange_records
+ * ---------------------------------------
+ * bitonic_dist_exchange for typed records. Partners first swap one
+ * boundary record and skip the round when their blocks are already in
+ * order; otherwise they swap whole blocks and each keeps its half. The
+ * receive and split buffers come from the context's arena.
+ */
+void bitonic_dist_exchange_records(bitonic_context *ctx, MPI_Comm comm, char *local, long long local_n,
+                                   const bitonic_key_ops *ops, MPI_Datatype type)
+{
+    int rank, world_size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &world_size);
+
+    size_t bytes = (size_t)local_n * ops->size;
+    MPI_Aint extent;
+    long long piece = piece_elements(type, &extent);
+    size_t mark = bitonic_context_mark(ctx);
+    char *theirs = bitonic_context_alloc(ctx, bytes);
+    char *merged = bitonic_context_alloc(ctx, bytes);
+    char *edge = bitonic_context_alloc(ctx, ops->size);
+    char *data = local;
+    if (!theirs || !merged || !edge)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(comm, 1);
+    }
+
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_EXCHANGE, &trace);
+    int round = 0;
+    for (int k = 2; k <= world_size; k <<= 1)
+    {
+        for (int j = k >> 1; j > 0; j >>= 1, ++round)
+        {
+            int partner = rank ^ j;
+            int ascending = ((rank & k) == 0);
+            int keep_low = ((rank < partner) == ascending);
+            double start = bitonic_trace_on ? MPI_Wtime() : 0.0;
+
+            const char *mine_edge = data + (keep_low ? (size_t)(local_n - 1) * ops->size : 0);
+            MPI_Sendrecv(mine_edge, 1, type, partner, 1, edge, 1, type, partner, 1,
+                         comm, MPI_STATUS_IGNORE);
+            if (keep_low ? ops->in_order(mine_edge, edge) : ops->in_order(edge, mine_edge))
+            {
+                if (bitonic_trace_on)
+                    bitonic_trace_round(round, partner, ops->size, ops->size, MPI_Wtime() - start);
+                continue;
+            }
+
+            for (long long done = 0; done < local_n; done += piece)
+            {
+                int len = (int)((local_n - done < piece) ? local_n - done : piece);
+                MPI_Sendrecv(data + (size_t)done * extent, len, type, partner, 0, theirs + (size_t)done * extent,
+                             len, type, partner, 0, comm, MPI_STATUS_IGNORE);
+            }
+            ops->split(data, theirs, local_n, merged, keep_low);
+            if (bitonic_trace_on)
+                bitonic_trace_round(round, partner, ops->size + bytes, ops->size + bytes, MPI_Wtime() - start);
+
+            char *swap = data;
+            data = merged;
+            merged = swap;
+        }
+    }
+
+    if (data != local)
+        memcpy(local, data, bytes);
+    bitonic_context_release(ctx, mark);
+    bitonic_trace_end(BITONIC_PHASE_EXCHANGE, &trace);
+}
+
+/**
+ * Function: bitonic_dist_merge_records_rank0
+ * -------------------------------------------
+ * bitonic_dist_merge_rank0 for typed records.
+ */
+int bitonic_dist_merge_records_rank0(bitonic_context *ctx, char *all_data, long long count, long long chunk_n,
+                                     const bitonic_key_ops *ops)
+{
+    size_t mark = bitonic_context_mark(ctx);
+    char *temp_buf = bitonic_context_alloc(ctx, (size_t)count * ops->size);
+    if (!temp_buf)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+    bitonic_trace_mark trace;
+    bitonic_trace_begin(BITONIC_PHASE_MERGE, &trace);
+
+    char *current = all_data;
+    char *next = temp_buf;
+    for (long long merge_width = chunk_n; merge_width < count; merge_width *= 2)
+    {
+        for (long long base = 0; base < count; base += 2 * merge_width)
+        {
+            long long left_end = (base + merge_width < count) ? base + merge_width : count;
+            long long right_end = (base + 2 * merge_width < count) ? base + 2 * merge_width : count;
+            ops->merge(current + (size_t)base * ops->size, left_end - base,
+                       current + (size_t)left_end * ops->size, right_end - left_end,
+                       next + (size_t)base * ops->size);
+        }
+        char *swap = current;
+        current = next;
+        next = swap;
+    }
+
+    if (current != all_data)
+        memcpy(all_data, current, (size_t)count * ops->size);
+    bitonic_trace_end(BITONIC_PHASE_MERGE, &trace);
+    bitonic_context_release(ctx, mark);
+    return 0;
+}
+
+/**
+ * Function: bitonic_dist_verify_records
+ * -------------------------------------
+ * bitonic_dist_verify for typed records.
+ */
+int bitonic_dist_verify_records(MPI_Comm comm, const char *local, long long local_n, const bitonic_key_ops *ops,
+                                MPI_Datatype type)
+{
+    int rank, world_size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &world_size);
+
+    int ok = 1;
+    for (long long i = 1; i < local_n && ok; ++i)
+        ok = ops->in_order(local + (size_t)(i - 1) * ops->size, local + (size_t)i * ops->size);
+
+    char *prev_last = malloc(ops->size);
+    if (!prev_last)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(comm, 1);
+    }
+    int up = (rank + 1 < world_size) ? rank + 1 : MPI_PROC_NULL;
+    int down = (rank > 0) ? rank - 1 : MPI_PROC_NULL;
+    MPI_Sendrecv(local + (size_t)(local_n - 1) * ops->size, 1, type, up, 1,
+                 prev_last, 1, type, down, 1, comm, MPI_STATUS_IGNORE);
+    if (rank > 0 && !ops->in_order(prev_last, local))
+        ok = 0;
+    free(prev_last);
+
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    return all_ok;
+}
+
+
+int bitonic_dist_sort(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n, const char *engine_name,
+                      int exchange_threads)
+{
+    int world_size;
+    MPI_Comm_size(comm, &world_size);
+    if ((world_size & (world_size - 1)) != 0)
+        return -1;
+
+    // Every rank must agree before entering the collective rounds
+    int ok = (bitonic_dist_local_sort(ctx, local, local_n, engine_name) == 0);
+    int all_ok = 0;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, comm);
+    if (!all_ok)
+        return -1;
+
+    bitonic_dist_exchange(ctx, comm, local, local_n, exchange_threads);
+    return 0;
+}
+
+/**
+ * Function: bitonic_dist_trace_report
+ * -----------------------------------
+ * Gathers every rank's phase times and bytes sent to rank 0, which writes
+ * the trace report with them (per-rank columns and max / mean imbalance)
+ * next to its own stage, thread and round detail. Whether any rank traces
+ * is agreed first, so the call is safe when only some ranks set
+ * BITONIC_TRACE (the others contribute zeros).
+ */
+int bitonic_dist_trace_report(MPI_Comm comm, const char *program)
+{
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int on = bitonic_trace_on, any = 0;
+    MPI_Allreduce(&on, &any, 1, MPI_INT, MPI_LOR, comm);
+    if (!any)
+        return -1;
+
+    double mine[BITONIC_PHASES + 1] = {0.0};
+    if (on)
+    {
+        bitonic_trace_phase_seconds(mine);
+        mine[BITONIC_PHASES] = bitonic_trace_bytes_sent();
+    }
+    double *all = NULL;
+    if (rank == 0 && !(all = malloc((size_t)size * (BITONIC_PHASES + 1) * sizeof(double))))
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        MPI_Abort(comm, 1);
+    }
+    MPI_Gather(mine, BITONIC_PHASES + 1, MPI_DOUBLE, all, BITONIC_PHASES + 1, MPI_DOUBLE, 0, comm);
+
+    int status = 0;
+    if (rank == 0)
+    {
+        // Split the rows into the phase matrix and the bytes column
+        double *bytes = malloc((size_t)size * sizeof(double));
+        double *seconds = malloc((size_t)size * BITONIC_PHASES * sizeof(double));
+        if (bytes && seconds)
+        {
+            for (int r = 0; r < size; ++r)
+            {
+                memcpy(seconds + (size_t)r * BITONIC_PHASES, all + (size_t)r * (BITONIC_PHASES + 1),
+                       BITONIC_PHASES * sizeof(double));
+                bytes[r] = all[(size_t)r * (BITONIC_PHASES + 1) + BITONIC_PHASES];
+            }
+            status = bitonic_trace_report(program, size, seconds, bytes);
+        }
+        else
+        {
+            status = -1;
+        }
+        free(bytes);
+        free(seconds);
+        free(all);
+    }
+    return status;
+}
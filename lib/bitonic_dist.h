@@ -0,0 +1,171 @@
+#ifndef BITONIC_DIST_H
+#define BITONIC_DIST_H
+
+#include <mpi.h>
+
+#include "bitonic.h"
+
+/**
+ * Distributed part of libbitonic (libbitonic_mpi): the compare-split
+ * bitonic network across the ranks of a communicator and its helpers, used
+ * by the MPI program and linkable by any MPI application.
+ *
+ * Data is partitioned in equal blocks of bitonic_dist_chunk(count, P)
+ * elements per rank; the last rank(s) pad their block with values that
+ * order last (INT_MAX for int). Collective functions must be called by
+ * every rank of 'comm'. Their scratch space comes from the context's arena,
+ * so repeated sorts of the same size allocate nothing. Allocation failures
+ * inside the collective rounds abort 'comm', as a rank cannot leave a round
+ * its partner has entered.
+ */
+
+/**
+ * Function: bitonic_dist_chunk
+ * ----------------------------
+ * Elements per rank for 'count' values over world_size ranks: ceil(count / P).
+ */
+long long bitonic_dist_chunk(long long count, int world_size);
+
+/**
+ * Function: bitonic_dist_layout
+ * -----------------------------
+ * bitonic_dist_scatterv / bitonic_dist_gatherv counts and displacements of
+ * the real values of each rank's chunk.
+ */
+void bitonic_dist_layout(long long count, long long chunk, int world_size, long long *counts, long long *displs);
+
+/**
+ * Function: bitonic_dist_scatterv / bitonic_dist_gatherv
+ * ------------------------------------------------------
+ * MPI_Scatterv / MPI_Gatherv with 64-bit counts and displacements (in
+ * elements of 'type'), significant on every rank. Layouts that fit an int
+ * use the collectives; larger ones fall back to point-to-point messages of
+ * at most 1 GiB between the root and each rank.
+ */
+void bitonic_dist_scatterv(MPI_Comm comm, const void *all, const long long *counts, const long long *displs,
+                           void *local, MPI_Datatype type, int root);
+void bitonic_dist_gatherv(MPI_Comm comm, const void *local, void *all, const long long *counts,
+                          const long long *displs, MPI_Datatype type, int root);
+
+/**
+ * Function: bitonic_dist_engine_valid
+ * -----------------------------------
+ * Returns 1 if 'engine_name' is a local-sort engine: radix, hybrid, bitonic,
+ * insertion, openmp, flat, blocks, tasks, recursive or qsort.
+ */
+int bitonic_dist_engine_valid(const char *engine_name);
+
+/**
+ * Function: bitonic_dist_local_sort
+ * ---------------------------------
+ * Sorts this rank's block with the named engine on the context's team.
+ * Returns -1 for an unknown engine or if scratch memory is exhausted.
+ */
+int bitonic_dist_local_sort(bitonic_context *ctx, int *data, long long local_n, const char *engine_name);
+
+/**
+ * Function: bitonic_dist_exchange
+ * -------------------------------
+ * Orders locally sorted blocks across the ranks of 'comm' (a power-of-2
+ * size) with log(P)(log(P)+1)/2 compare-split rounds; on return rank r
+ * holds the r-th smallest local_n values, in place in 'local'. threads > 1
+ * selects the threaded (hybrid MPI + OpenMP) exchange, 1 the pipelined
+ * single-thread one.
+ */
+void bitonic_dist_exchange(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n, int threads);
+
+/**
+ * Function: bitonic_dist_sort
+ * ---------------------------
+ * bitonic_dist_local_sort followed by bitonic_dist_exchange: sorts the
+ * distributed array whose rank-r block is 'local'. Returns -1 (on every
+ * rank) if the communicator size is not a power of 2 or a local sort
+ * failed.
+ */
+int bitonic_dist_sort(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n, const char *engine_name,
+                      int exchange_threads);
+
+/**
+ * Function: bitonic_dist_merge_rank0
+ * ----------------------------------
+ * Merges the sorted chunk_n-element chunks of all_data[0, count) in place
+ * (the gather + serial merge algorithm). Returns -1 if memory is exhausted.
+ */
+int bitonic_dist_merge_rank0(bitonic_context *ctx, int *all_data, long long count, long long chunk_n);
+
+/**
+ * Function: bitonic_dist_topk
+ * ---------------------------
+ * Collectively selects the k smallest values of the distributed array whose
+ * rank-r block is local[0, local_n): each rank reduces its block to k
+ * values and a binomial tree merges the lists towards rank 0, exchanging
+ * only k values per rank (in messages of at most 1 GiB, so k may pass
+ * INT_MAX). Rank 0 receives them ascending in out[0, k) and gets their
+ * number (min(k, total)); the other ranks get 0.
+ */
+long long bitonic_dist_topk(bitonic_context *ctx, MPI_Comm comm, const int *local, long long local_n, long long k,
+                            int *out);
+
+/**
+ * Function: bitonic_dist_sample_sort
+ * ----------------------------------
+ * Collectively sorts the distributed array whose rank-r block is
+ * local[0, local_n) (any process count, any block lengths, no padding):
+ * local sort with the named engine (in place), P - 1 splitters from regular
+ * samples, one MPI_Alltoallv (point-to-point pieces once counts pass
+ * INT_MAX) and a parallel merge of the received runs. On
+ * return *out (malloc'ed, the caller frees it) holds this rank's *out_n
+ * values, in global order by rank; *out_n varies by rank (at most about
+ * twice the mean). Returns -1 on every rank if a local sort failed.
+ */
+int bitonic_dist_sample_sort(bitonic_context *ctx, MPI_Comm comm, int *local, long long local_n,
+                             const char *engine_name, int **out, long long *out_n);
+
+/**
+ * Function: bitonic_dist_verify
+ * -----------------------------
+ * Collectively checks that the blocks are sorted and ordered by rank (empty
+ * blocks allowed). Returns 1 on every rank if they are.
+ */
+int bitonic_dist_verify(MPI_Comm comm, const int *local, long long local_n);
+
+/**
+ * Function: bitonic_dist_read_partition / bitonic_dist_write_partition
+ * --------------------------------------------------------------------
+ * Collective MPI-IO read of this rank's chunk of a binary input file into a
+ * malloc'ed block, and write of the distributed result at its global
+ * offsets (text or binary). Both return 0 on success, -1 on error (reported
+ * by rank 0). bitonic_dist_write_blocks writes blocks of varying length (the
+ * sample sort's), placed by the prefix sum of the lengths. Binary transfers
+ * run in collective rounds of at most 2^28 values.
+ */
+int bitonic_dist_read_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int **local,
+                                long long *local_n, long long *count);
+int bitonic_dist_write_partition(bitonic_context *ctx, MPI_Comm comm, const char *path, int *data,
+                                 long long local_n, long long count, bitonic_output_format format);
+int bitonic_dist_write_blocks(bitonic_context *ctx, MPI_Comm comm, const char *path, int *data, long long local_n,
+                              bitonic_output_format format);
+
+/**
+ * Function: bitonic_dist_trace_report
+ * -----------------------------------
+ * Collective: writes the BITONIC_TRACE report (lib/bitonic_trace.h) on rank
+ * 0 with every rank's phase times and bytes sent and their imbalance.
+ * Returns 0 on rank 0 after writing, -1 when tracing is off everywhere.
+ */
+int bitonic_dist_trace_report(MPI_Comm comm, const char *program);
+
+/**
+ * Typed records: the same operations for any bitonic_key_ops record type.
+ * bitonic_dist_record_type returns a committed datatype the caller frees
+ * with MPI_Type_free.
+ */
+MPI_Datatype bitonic_dist_record_type(const bitonic_key_ops *ops);
+void bitonic_dist_exchange_records(bitonic_context *ctx, MPI_Comm comm, char *local, long long local_n,
+                                   const bitonic_key_ops *ops, MPI_Datatype type);
+int bitonic_dist_merge_records_rank0(bitonic_context *ctx, char *all_data, long long count, long long chunk_n,
+                                     const bitonic_key_ops *ops);
+int bitonic_dist_verify_records(MPI_Comm comm, const char *local, long long local_n, const bitonic_key_ops *ops,
+                                MPI_Datatype type);
+
+#endif
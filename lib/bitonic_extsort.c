@@ -0,0 +1,807 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitonic.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Smallest memory budget accepted (smaller values are raised to it) */
+#define EXTSORT_MIN_MEMORY ((size_t)4096)
+/* Merge reads below this block size lose sequential disk bandwidth, so the
+   fan-in of a pass is capped to keep blocks at least this large */
+#define EXTSORT_MIN_BLOCK ((size_t)1 << 20)
+/* Budgets that merge fewer runs than this per pass add passes over the whole
+   spill file, so bitonic_sort_file warns about them */
+#define EXTSORT_WARN_FAN_IN 8
+/* Key of an exhausted run in the loser tree; orders after every int */
+#define EXTSORT_DONE INT64_MAX
+
+/**
+ * Structure: io_job / io_queue
+ * ----------------------------
+ * Asynchronous pread/pwrite: jobs are served in FIFO order by the queue's
+ * own thread while the caller sorts or merges. A job lives in the caller's
+ * buffer bookkeeping, so submitting allocates nothing.
+ */
+typedef struct io_job
+{
+    int fd;
+    int write;            // 1 = pwrite, 0 = pread
+    void *buf;
+    size_t bytes;
+    off_t offset;
+    int pending;          // Submitted and not yet waited for
+    int done;             // Set by the I/O thread
+    int failed;           // Short read or I/O error
+    struct io_job *next;
+} io_job;
+
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    io_job *head;
+    io_job *tail;
+    int stop;
+} io_queue;
+
+static int transfer_all(const io_job *job)
+{
+    char *buf = job->buf;
+    size_t left = job->bytes;
+    off_t offset = job->offset;
+    while (left > 0)
+    {
+        ssize_t moved = job->write ? pwrite(job->fd, buf, left, offset) : pread(job->fd, buf, left, offset);
+        if (moved <= 0)
+            return -1;
+        buf += moved;
+        left -= (size_t)moved;
+        offset += moved;
+    }
+    return 0;
+}
+
+static void *io_thread(void *arg)
+{
+    io_queue *q = arg;
+    pthread_mutex_lock(&q->lock);
+    for (;;)
+    {
+        while (!q->head && !q->stop)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (!q->head)
+            break;
+        io_job *job = q->head;
+        q->head = job->next;
+        if (!q->head)
+            q->tail = NULL;
+        pthread_mutex_unlock(&q->lock);
+
+        int failed = transfer_all(job);
+
+        pthread_mutex_lock(&q->lock);
+        job->failed = failed;
+        job->done = 1;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+static int io_start(io_queue *q)
+{
+    memset(q, 0, sizeof(*q));
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    if (pthread_create(&q->thread, NULL, io_thread, q) != 0)
+    {
+        pthread_mutex_destroy(&q->lock);
+        pthread_cond_destroy(&q->cond);
+        return -1;
+    }
+    return 0;
+}
+
+/* Finishes the queued jobs, then joins the I/O thread */
+static void io_stop(io_queue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->cond);
+}
+
+static void io_submit(io_queue *q, io_job *job, int fd, int write, void *buf, size_t bytes, off_t offset)
+{
+    job->fd = fd;
+    job->write = write;
+    job->buf = buf;
+    job->bytes = bytes;
+    job->offset = offset;
+    job->pending = 1;
+    job->done = 0;
+    job->failed = 0;
+    job->next = NULL;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->tail)
+        q->tail->next = job;
+    else
+        q->head = job;
+    q->tail = job;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Waits for a submitted job (no-op for one never submitted); 0 or -1 */
+static int io_wait(io_queue *q, io_job *job)
+{
+    if (!job->pending)
+        return 0;
+    pthread_mutex_lock(&q->lock);
+    while (!job->done)
+        pthread_cond_wait(&q->cond, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+    job->pending = 0;
+    return job->failed ? -1 : 0;
+}
+
+/**
+ * Structure: run_reader
+ * ---------------------
+ * Double-buffered reader of one sorted run: while the merge consumes one
+ * block, the next one is already being read into the other buffer.
+ */
+typedef struct
+{
+    int *buf[2];
+    io_job jobs[2];
+    const int *cur;
+    const int *end;
+    int which;            // Buffer being consumed
+    int fd;
+    off_t next;           // File offset of the next unread block
+    long long left;       // Values of the run not yet requested
+    size_t block;         // Values per block
+} run_reader;
+
+static void reader_request(run_reader *r, io_queue *q, int b)
+{
+    if (r->left == 0)
+        return;
+    size_t count = ((long long)r->block < r->left) ? r->block : (size_t)r->left;
+    io_submit(q, &r->jobs[b], r->fd, 0, r->buf[b], count * sizeof(int), r->next);
+    r->next += (off_t)(count * sizeof(int));
+    r->left -= (long long)count;
+}
+
+/**
+ * Function: reader_advance
+ * ------------------------
+ * Refills a reader whose current block is used up: re-requests into the
+ * finished buffer, then switches to the other one once its read lands.
+ * Returns 1 if values are available, 0 at the end of the run, -1 on error.
+ */
+static int reader_advance(run_reader *r, io_queue *q)
+{
+    int spent = r->which;
+    reader_request(r, q, spent);
+    r->which ^= 1;
+    io_job *job = &r->jobs[r->which];
+    if (!job->pending)
+    {
+        // Nothing was requested: the run has ended
+        r->cur = r->end = NULL;
+        return 0;
+    }
+    if (io_wait(q, job) != 0)
+        return -1;
+    r->cur = r->buf[r->which];
+    r->end = r->cur + job->bytes / sizeof(int);
+    return 1;
+}
+
+/**
+ * Structure: run_sink
+ * -------------------
+ * Double-buffered writer of merged values: one buffer fills while the other
+ * is written. Spill runs are stored as native ints; the final output is
+ * little-endian binary or text, as bitonic_write_records writes it.
+ */
+typedef struct
+{
+    int *stage[2];
+    char *bytes[2];       // Encoded or formatted copy (final output only)
+    io_job jobs[2];
+    int which;
+    size_t fill;
+    size_t capacity;      // Values per buffer
+    int fd;
+    off_t offset;
+    bitonic_output_format format;
+    int spill;            // 1 = native ints into a run file
+    unsigned long long remaining;  // Values still to be written (text: last one ends in '\n')
+} run_sink;
+
+static int sink_flush(run_sink *s, io_queue *q)
+{
+    if (s->fill == 0)
+        return 0;
+    int *values = s->stage[s->which];
+    long long count = (long long)s->fill;
+    s->remaining -= s->fill;
+
+    if (s->format != BITONIC_OUTPUT_NONE)
+    {
+        const void *out = values;
+        size_t bytes = s->fill * sizeof(int);
+        if (!s->spill && s->format == BITONIC_OUTPUT_TEXT)
+        {
+            bytes = bitonic_format_text(s->bytes[s->which], values, count, s->remaining == 0);
+            out = s->bytes[s->which];
+        }
+        else if (!s->spill)
+        {
+            out = bitonic_int_codec.encode(values, count, (unsigned char *)s->bytes[s->which]);
+        }
+        io_submit(q, &s->jobs[s->which], s->fd, 1, (void *)out, bytes, s->offset);
+        s->offset += (off_t)bytes;
+    }
+
+    // Switch buffers; the other one may still be on its way to disk
+    s->which ^= 1;
+    s->fill = 0;
+    return io_wait(q, &s->jobs[s->which]);
+}
+
+/**
+ * Function: loser_tree_build / loser_tree_replay
+ * ----------------------------------------------
+ * Tournament tree over 'leaves' (a power of 2) run heads: node[0] holds
+ * the index of the smallest key, node[1 .. leaves) the loser of each match.
+ * After the winner's key changes, replaying its path costs log2(leaves)
+ * comparisons. Ties go to the lower run index, so the merge is stable.
+ */
+static int beats(const int64_t *key, int a, int b)
+{
+    return key[a] < key[b] || (key[a] == key[b] && a < b);
+}
+
+static void loser_tree_build(int *node, const int64_t *key, int leaves, int *winners)
+{
+    for (int i = 0; i < leaves; ++i)
+        winners[leaves + i] = i;
+    for (int n = leaves - 1; n >= 1; --n)
+    {
+        int a = winners[2 * n];
+        int b = winners[2 * n + 1];
+        winners[n] = beats(key, a, b) ? a : b;
+        node[n] = beats(key, a, b) ? b : a;
+    }
+    node[0] = winners[1];
+}
+
+static void loser_tree_replay(int *node, const int64_t *key, int leaves, int leaf)
+{
+    int winner = leaf;
+    for (int n = (leaves + leaf) >> 1; n >= 1; n >>= 1)
+    {
+        if (beats(key, node[n], winner))
+        {
+            int swap = node[n];
+            node[n] = winner;
+            winner = swap;
+        }
+    }
+    node[0] = winner;
+}
+
+/**
+ * Structure: extsort_job
+ * ----------------------
+ * State shared by the phases of one bitonic_sort_file call.
+ */
+typedef struct
+{
+    bitonic_context *ctx;
+    io_queue reads;
+    io_queue writes;
+    size_t memory;
+    unsigned long long count;
+} extsort_job;
+
+/**
+ * Function: merge_runs
+ * --------------------
+ * k-way merges runs[0, k) (offset / length pairs in 'fd') into 'sink'
+ * through a loser tree, with a double-buffered reader per run. The memory
+ * budget is split evenly over the 2k read buffers and the sink.
+ */
+static int merge_runs(extsort_job *job, int fd, const off_t *offsets, const long long *lengths, int k,
+                      run_sink *sink)
+{
+    int leaves = 1;
+    while (leaves < k)
+        leaves <<= 1;
+
+    size_t block = job->memory / (2 * (size_t)(k + 1) * sizeof(int));
+    if (block < 16)
+        block = 16;
+
+    run_reader *readers = calloc((size_t)k, sizeof(*readers));
+    int64_t *key = malloc((size_t)leaves * sizeof(*key));
+    int *node = malloc((size_t)leaves * sizeof(*node));
+    int *winners = malloc(2 * (size_t)leaves * sizeof(*winners));
+    int *buffers = malloc(2 * (size_t)k * block * sizeof(int));
+    int status = 0;
+
+    if (!readers || !key || !node || !winners || !buffers)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        status = -1;
+    }
+
+    // Prime every run: two blocks in flight, wait for the first
+    for (int r = 0; status == 0 && r < k; ++r)
+    {
+        run_reader *rd = &readers[r];
+        rd->buf[0] = buffers + (2 * (size_t)r) * block;
+        rd->buf[1] = rd->buf[0] + block;
+        rd->fd = fd;
+        rd->next = offsets[r];
+        rd->left = lengths[r];
+        rd->block = block;
+        reader_request(rd, &job->reads, 0);
+        reader_request(rd, &job->reads, 1);
+    }
+    for (int r = 0; status == 0 && r < leaves; ++r)
+    {
+        key[r] = EXTSORT_DONE;
+        if (r < k)
+        {
+            // 'which' starts at 1, so the first advance moves to buffer 0
+            run_reader *rd = &readers[r];
+            rd->which = 1;
+            io_job *first = &rd->jobs[0];
+            if (first->pending)
+            {
+                if (io_wait(&job->reads, first) != 0)
+                {
+                    status = -1;
+                    break;
+                }
+                rd->which = 0;
+                rd->cur = rd->buf[0];
+                rd->end = rd->cur + first->bytes / sizeof(int);
+                key[r] = *rd->cur++;
+            }
+        }
+    }
+
+    if (status == 0)
+    {
+        loser_tree_build(node, key, leaves, winners);
+        for (;;)
+        {
+            int w = node[0];
+            if (key[w] == EXTSORT_DONE)
+                break;
+
+            sink->stage[sink->which][sink->fill++] = (int)key[w];
+            if (sink->fill == sink->capacity && sink_flush(sink, &job->writes) != 0)
+            {
+                status = -1;
+                break;
+            }
+
+            run_reader *rd = &readers[w];
+            if (rd->cur == rd->end)
+            {
+                int more = reader_advance(rd, &job->reads);
+                if (more < 0)
+                {
+                    status = -1;
+                    break;
+                }
+                key[w] = more ? *rd->cur++ : EXTSORT_DONE;
+            }
+            else
+            {
+                key[w] = *rd->cur++;
+            }
+            loser_tree_replay(node, key, leaves, w);
+        }
+    }
+    if (status == 0 && sink_flush(sink, &job->writes) != 0)
+        status = -1;
+
+    // Drain reads still in flight before their buffers are freed
+    for (int r = 0; readers && r < k; ++r)
+    {
+        if (io_wait(&job->reads, &readers[r].jobs[0]) != 0 || io_wait(&job->reads, &readers[r].jobs[1]) != 0)
+            status = -1;
+    }
+
+    free(readers);
+    free(key);
+    free(node);
+    free(winners);
+    free(buffers);
+    return status;
+}
+
+/**
+ * Function: sink_open
+ * -------------------
+ * Allocates a sink of about 'bytes' bytes for 'count' values written to
+ * fd at 'offset'. Text output keeps formatted copies next to the values.
+ */
+static int sink_open(run_sink *sink, size_t bytes, int fd, off_t offset, bitonic_output_format format, int spill,
+                     unsigned long long count)
+{
+    memset(sink, 0, sizeof(*sink));
+    size_t width = spill ? 0 : (format == BITONIC_OUTPUT_TEXT) ? BITONIC_IO_MAX_TEXT_WIDTH : sizeof(int);
+    sink->capacity = bytes / (2 * (sizeof(int) + width));
+    if (sink->capacity < 16)
+        sink->capacity = 16;
+    sink->fd = fd;
+    sink->offset = offset;
+    sink->format = format;
+    sink->spill = spill;
+    sink->remaining = count;
+
+    for (int b = 0; b < 2; ++b)
+    {
+        sink->stage[b] = malloc(sink->capacity * sizeof(int));
+        if (width)
+            sink->bytes[b] = malloc(sink->capacity * width);
+        if (!sink->stage[b] || (width && !sink->bytes[b]))
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int sink_close(run_sink *sink, io_queue *q)
+{
+    int status = 0;
+    for (int b = 0; b < 2; ++b)
+    {
+        if (io_wait(q, &sink->jobs[b]) != 0)
+            status = -1;
+        free(sink->stage[b]);
+        free(sink->bytes[b]);
+    }
+    return status;
+}
+
+/* Opens an anonymous spill file in BITONIC_TMPDIR, TMPDIR or /tmp */
+static int spill_file(void)
+{
+    const char *dir = getenv("BITONIC_TMPDIR");
+    if (!dir || !*dir)
+        dir = getenv("TMPDIR");
+    if (!dir || !*dir)
+        dir = "/tmp";
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/bitonic_runs_XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        perror("Failed to create spill file");
+        return -1;
+    }
+    unlink(path);
+    return fd;
+}
+
+/**
+ * Function: form_runs
+ * -------------------
+ * Phase 1: cuts the input payload into chunks of 'chunk' values, sorts each
+ * with bitonic_sort on the context's team and spills it to 'spill' as a run.
+ * Three buffers rotate through reading, sorting and writing, so the read of
+ * chunk i + 1 and the write of run i - 1 overlap the sort of chunk i.
+ */
+static int form_runs(extsort_job *job, int in_fd, int elem, size_t chunk, int spill, int runs)
+{
+    unsigned char *raw[3] = {NULL, NULL, NULL};
+    int *values[3] = {NULL, NULL, NULL};
+    io_job reads[3], writes[3];
+    int status = 0;
+
+    memset(reads, 0, sizeof(reads));
+    memset(writes, 0, sizeof(writes));
+    for (int b = 0; b < 3; ++b)
+    {
+        raw[b] = malloc(chunk * (size_t)elem);
+        // int32 payloads are decoded in place; int64 ones are narrowed into their own array
+        values[b] = (elem == 4) ? (int *)raw[b] : malloc(chunk * sizeof(int));
+        if (!raw[b] || !values[b])
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            status = -1;
+        }
+    }
+
+    if (status == 0 && runs > 0)
+    {
+        size_t first = (job->count < chunk) ? (size_t)job->count : chunk;
+        io_submit(&job->reads, &reads[0], in_fd, 0, raw[0], first * elem, BITONIC_IO_HEADER_BYTES);
+    }
+
+    for (int i = 0; status == 0 && i < runs; ++i)
+    {
+        int b = i % 3;
+        unsigned long long lo = (unsigned long long)i * chunk;
+        long long n = (long long)((job->count - lo < chunk) ? job->count - lo : chunk);
+
+        if (io_wait(&job->reads, &reads[b]) != 0)
+        {
+            fprintf(stderr, "Failed to read input file\n");
+            status = -1;
+            break;
+        }
+
+        // Prefetch the next chunk once its buffer's run has been written
+        if (i + 1 < runs)
+        {
+            int nb = (i + 1) % 3;
+            unsigned long long next_lo = lo + chunk;
+            size_t next_n = (job->count - next_lo < chunk) ? (size_t)(job->count - next_lo) : chunk;
+            if (io_wait(&job->writes, &writes[nb]) != 0)
+            {
+                status = -1;
+                break;
+            }
+            io_submit(&job->reads, &reads[nb], in_fd, 0, raw[nb], next_n * elem,
+                      BITONIC_IO_HEADER_BYTES + (off_t)next_lo * elem);
+        }
+
+        if (bitonic_decode_values(raw[b], elem, n, values[b]) != 0)
+        {
+            fprintf(stderr, "Binary input values do not fit the key type\n");
+            status = -1;
+            break;
+        }
+        if (bitonic_sort(job->ctx, values[b], n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE) != 0)
+        {
+            fprintf(stderr, "Memory allocation failed\n");
+            status = -1;
+            break;
+        }
+        io_submit(&job->writes, &writes[b], spill, 1, values[b], (size_t)n * sizeof(int),
+                  (off_t)lo * (off_t)sizeof(int));
+    }
+
+    for (int b = 0; b < 3; ++b)
+    {
+        if (io_wait(&job->reads, &reads[b]) != 0 || io_wait(&job->writes, &writes[b]) != 0)
+            status = -1;
+        if (values[b] != (int *)raw[b])
+            free(values[b]);
+        free(raw[b]);
+    }
+    return status;
+}
+
+/**
+ * Function: merge_passes
+ * ----------------------
+ * Phase 2: merges the runs of 'spill' in groups of at most 'fan_in' into a
+ * second spill file until one group is left, then merges that group into
+ * the output. Returns the number of passes, or -1 on error.
+ */
+static int merge_passes(extsort_job *job, int spill, off_t *offsets, long long *lengths, int runs, int fan_in,
+                        int out_fd, off_t out_offset, bitonic_output_format format)
+{
+    int passes = 0;
+    int other = -1;    // Output of the current pass
+    int created = -1;  // Second spill file, opened by the first intermediate pass
+
+    while (runs > fan_in)
+    {
+        if (other < 0)
+        {
+            if ((created = spill_file()) < 0)
+                return -1;
+            other = created;
+        }
+
+        int groups = 0;
+        off_t offset = 0;
+        for (int g = 0; g < runs; g += fan_in, ++groups)
+        {
+            int k = (runs - g < fan_in) ? runs - g : fan_in;
+            long long total = 0;
+            for (int r = g; r < g + k; ++r)
+                total += lengths[r];
+
+            run_sink sink;
+            int status = sink_open(&sink, job->memory / (size_t)(k + 1), other, offset, BITONIC_OUTPUT_BINARY, 1,
+                                   (unsigned long long)total);
+            if (status == 0)
+                status = merge_runs(job, spill, offsets + g, lengths + g, k, &sink);
+            if (sink_close(&sink, &job->writes) != 0)
+                status = -1;
+            if (status != 0)
+            {
+                close(created);
+                return -1;
+            }
+            offsets[groups] = offset;
+            lengths[groups] = total;
+            offset += (off_t)total * (off_t)sizeof(int);
+        }
+
+        // The merged runs become the input of the next pass
+        int swap = spill;
+        spill = other;
+        other = swap;
+        runs = groups;
+        ++passes;
+    }
+
+    run_sink sink;
+    int status = sink_open(&sink, job->memory / (size_t)(runs + 1), out_fd, out_offset, format, 0, job->count);
+    if (status == 0)
+        status = merge_runs(job, spill, offsets, lengths, runs, &sink);
+    if (sink_close(&sink, &job->writes) != 0)
+        status = -1;
+    if (created >= 0)
+        close(created);
+    return (status == 0) ? passes + 1 : -1;
+}
+
+long long bitonic_sort_file(bitonic_context *ctx, const char *in_path, const char *out_path,
+                            bitonic_output_format format, size_t memory, bitonic_extsort_stats *stats)
+{
+    unsigned char header[BITONIC_IO_HEADER_BYTES];
+    int elem;
+    uint64_t count;
+    struct stat st;
+
+    int in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0)
+    {
+        perror("Failed to open input file");
+        return -1;
+    }
+    if (fstat(in_fd, &st) != 0 || pread(in_fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        bitonic_decode_header(header, &elem, &count) != 0)
+    {
+        fprintf(stderr, "External sort needs binary input (see docs/RUN.md)\n");
+        close(in_fd);
+        return -1;
+    }
+    if (((uint64_t)st.st_size - BITONIC_IO_HEADER_BYTES) / elem < count)
+    {
+        fprintf(stderr, "Binary input is truncated\n");
+        close(in_fd);
+        return -1;
+    }
+
+    extsort_job job = {.ctx = ctx, .memory = (memory < EXTSORT_MIN_MEMORY) ? EXTSORT_MIN_MEMORY : memory,
+                       .count = count};
+
+    // Run formation holds three chunks (plus narrowed copies of int64 input)
+    // and the engine scratch of the one being sorted (about n ints)
+    size_t chunk = job.memory / (3 * (size_t)(elem == 4 ? elem : elem + (int)sizeof(int)) + sizeof(int));
+    unsigned long long run_count = (count + chunk - 1) / chunk;
+    if (run_count > INT_MAX)
+    {
+        fprintf(stderr, "Memory budget too small for %llu values\n", (unsigned long long)count);
+        close(in_fd);
+        return -1;
+    }
+    int runs = (int)run_count;
+
+    // A pass merges as many runs as keep read blocks of EXTSORT_MIN_BLOCK bytes
+    int fan_in = (int)(job.memory / (2 * EXTSORT_MIN_BLOCK)) - 1;
+    if (fan_in < 2)
+        fan_in = 2;
+    if (fan_in < EXTSORT_WARN_FAN_IN && runs > fan_in)
+        fprintf(stderr,
+                "Warning: a %zu-byte memory budget merges only %d of %d runs per pass; "
+                "%zu bytes or more merge %d\n",
+                job.memory, fan_in, runs, 2 * EXTSORT_MIN_BLOCK * (EXTSORT_WARN_FAN_IN + 1), EXTSORT_WARN_FAN_IN);
+
+    if (stats)
+    {
+        stats->count = count;
+        stats->runs = runs;
+        stats->passes = 0;
+    }
+
+    // Everything fits in one chunk: an ordinary in-memory sort
+    if (runs <= 1)
+    {
+        close(in_fd);
+        void *values = NULL;
+        long long n = bitonic_read(ctx, in_path, &bitonic_int_codec, &values);
+        int status = (n >= 0) ? bitonic_sort(ctx, values, n, BITONIC_KEY_INT32, BITONIC_PAYLOAD_NONE) : -1;
+        if (status == 0)
+            status = bitonic_write(ctx, out_path, &bitonic_int_codec, values, n, format);
+        free(values);
+        return (status == 0) ? (long long)count : -1;
+    }
+
+    off_t *offsets = malloc((size_t)runs * sizeof(off_t));
+    long long *lengths = malloc((size_t)runs * sizeof(long long));
+    int spill = spill_file();
+    int out_fd = -1;
+    int status = (offsets && lengths && spill >= 0) ? 0 : -1;
+
+    if (status == 0 && io_start(&job.reads) != 0)
+        status = -1;
+    else if (status == 0 && io_start(&job.writes) != 0)
+    {
+        io_stop(&job.reads);
+        status = -1;
+    }
+
+    if (status == 0)
+    {
+        for (int r = 0; r < runs; ++r)
+        {
+            unsigned long long lo = (unsigned long long)r * chunk;
+            offsets[r] = (off_t)lo * (off_t)sizeof(int);
+            lengths[r] = (long long)((count - lo < chunk) ? count - lo : chunk);
+        }
+        status = form_runs(&job, in_fd, elem, chunk, spill, runs);
+
+        off_t out_offset = 0;
+        if (status == 0 && format != BITONIC_OUTPUT_NONE)
+        {
+            out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out_fd < 0)
+            {
+                perror("Failed to open output file");
+                status = -1;
+            }
+            else if (format == BITONIC_OUTPUT_BINARY)
+            {
+                bitonic_encode_header(header, sizeof(int), count);
+                if (pwrite(out_fd, header, sizeof(header), 0) != (ssize_t)sizeof(header))
+                    status = -1;
+                out_offset = BITONIC_IO_HEADER_BYTES;
+            }
+        }
+
+        int passes = (status == 0)
+                         ? merge_passes(&job, spill, offsets, lengths, runs, fan_in, out_fd, out_offset, format)
+                         : -1;
+        if (passes < 0)
+            status = -1;
+        else if (stats)
+            stats->passes = passes;
+
+        io_stop(&job.reads);
+        io_stop(&job.writes);
+    }
+
+    if (out_fd >= 0 && close(out_fd) != 0)
+        status = -1;
+    if (status != 0)
+        fprintf(stderr, "External sort failed\n");
+    if (spill >= 0)
+        close(spill);
+    close(in_fd);
+    free(offsets);
+    free(lengths);
+    return (status == 0) ? (long long)count : -1;
+}
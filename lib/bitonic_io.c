@@ -0,0 +1,656 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitonic_io.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bitonic_numa.h"
+#include "bitonic_omp.h"
+
+/* Files smaller than this are parsed on the calling thread */
+#define IO_PARALLEL_MIN_BYTES (1 << 20)
+/* Elements per work item when converting binary payloads */
+#define IO_BINARY_BLOCK (1 << 20)
+/* Elements each thread formats per write round */
+#define IO_TEXT_BLOCK (1 << 18)
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define IO_HOST_LITTLE_ENDIAN 0
+#else
+#define IO_HOST_LITTLE_ENDIAN 1
+#endif
+
+static int io_threads(size_t bytes)
+{
+#ifdef _OPENMP
+    return (bytes >= IO_PARALLEL_MIN_BYTES) ? omp_get_max_threads() : 1;
+#else
+    (void)bytes;
+    return 1;
+#endif
+}
+
+static inline int is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static uint64_t load_le64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int b = 7; b >= 0; --b)
+        v = (v << 8) | p[b];
+    return v;
+}
+
+static uint32_t load_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void bitonic_encode_header(unsigned char *header, int elem_size, uint64_t count)
+{
+    memcpy(header, BITONIC_IO_MAGIC, 4);
+    header[4] = BITONIC_IO_VERSION;
+    header[5] = (unsigned char)elem_size;
+    header[6] = 0;
+    header[7] = 0;
+    for (int b = 0; b < 8; ++b)
+        header[8 + b] = (unsigned char)(count >> (8 * b));
+}
+
+int bitonic_decode_header(const unsigned char *header, int *elem_size, uint64_t *count)
+{
+    if (memcmp(header, BITONIC_IO_MAGIC, 4) != 0 || header[4] != BITONIC_IO_VERSION ||
+        (header[5] != 4 && header[5] != 8))
+        return -1;
+    *elem_size = header[5];
+    *count = load_le64(header + 8);
+    return 0;
+}
+
+int bitonic_decode_values(const unsigned char *payload, int elem_size, long long count, int *out)
+{
+    long long blocks = (count + IO_BINARY_BLOCK - 1) / IO_BINARY_BLOCK;
+    int out_of_range = 0;
+
+#pragma omp parallel for schedule(static) num_threads(io_threads((size_t)count * elem_size)) reduction(|| : out_of_range)
+    for (long long b = 0; b < blocks; ++b)
+    {
+        long long lo = b * IO_BINARY_BLOCK;
+        long long hi = (lo + IO_BINARY_BLOCK < count) ? lo + IO_BINARY_BLOCK : count;
+        if (elem_size == 4 && IO_HOST_LITTLE_ENDIAN)
+        {
+            if ((const void *)payload != (const void *)out)
+                memcpy(out + lo, payload + (size_t)lo * 4, (size_t)(hi - lo) * 4);
+        }
+        else if (elem_size == 4)
+        {
+            for (long long i = lo; i < hi; ++i)
+                out[i] = (int)load_le32(payload + (size_t)i * 4);
+        }
+        else
+        {
+            for (long long i = lo; i < hi; ++i)
+            {
+                int64_t v = (int64_t)load_le64(payload + (size_t)i * 8);
+                if (v < INT_MIN || v > INT_MAX)
+                    out_of_range = 1;
+                out[i] = (int)v;
+            }
+        }
+    }
+
+    return out_of_range ? -1 : 0;
+}
+
+/**
+ * Function: parse_token
+ * ---------------------
+ * Parses one optionally signed decimal integer starting at *pos and advances
+ * *pos past it. The token must end at whitespace or at 'end' and fit in an
+ * int. Returns 0 on success, -1 for invalid data.
+ */
+static int parse_token(const char **pos, const char *end, int *value)
+{
+    const char *p = *pos;
+    int negative = 0;
+    long long v = 0;
+
+    if (*p == '-' || *p == '+')
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == end || *p < '0' || *p > '9')
+        return -1;
+
+    const long long limit = negative ? -(long long)INT_MIN : INT_MAX;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        v = v * 10 + (*p - '0');
+        if (v > limit)
+            return -1;
+        ++p;
+    }
+    if (p < end && !is_space(*p))
+        return -1;
+
+    *value = (int)(negative ? -v : v);
+    *pos = p;
+    return 0;
+}
+
+/* Codec parse callback for int: every token of [p, end) */
+static long long parse_int_range(const char *p, const char *end, void *out)
+{
+    int *values = out;
+    long long count = 0;
+    while (p < end)
+    {
+        if (is_space(*p))
+        {
+            ++p;
+            continue;
+        }
+        if (parse_token(&p, end, values + count) != 0)
+            return -1;
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * Function: place_output
+ * ----------------------
+ * Faults a freshly allocated array of n records in with the team and static
+ * split the sort will use (see bitonic_numa.h), before the parser fills it
+ * from other threads' ranges.
+ */
+static void place_output(void *data, long long n, size_t size)
+{
+    int team = bitonic_omp_threads(n);
+    if (team > 1)
+        bitonic_first_touch(data, (size_t)n * size, team);
+}
+
+/**
+ * Function: parse_text
+ * --------------------
+ * Parallel two-pass parser over a mapped text file.
+ * 1. Cut [0, size) into one range per thread, moving each cut forward to
+ *    just after a whitespace character so no token spans two ranges
+ * 2. Each thread counts the tokens of its range; a prefix sum gives every
+ *    thread its output offset
+ * 3. Each thread converts its tokens straight into the final array with the
+ *    codec's (type-specialized) range parser
+ */
+static long long parse_text(const char *buf, size_t size, const bitonic_record_codec *codec, void **out_data)
+{
+    int threads = io_threads(size);
+    size_t *cuts = malloc((threads + 1) * sizeof(size_t));
+    long long *offsets = malloc((threads + 1) * sizeof(long long));
+    char *data = NULL;
+    int status = 0;
+
+    if (!cuts || !offsets)
+    {
+        free(cuts);
+        free(offsets);
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+
+    cuts[0] = 0;
+    for (int t = 1; t < threads; ++t)
+    {
+        size_t p = size / threads * t;
+        if (p < cuts[t - 1])
+            p = cuts[t - 1];
+        while (p > 0 && p < size && !is_space(buf[p - 1]))
+            ++p;
+        cuts[t] = p;
+    }
+    cuts[threads] = size;
+
+    // Pass 1: count tokens per range
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+    for (int t = 0; t < threads; ++t)
+    {
+        long long tokens = 0;
+        for (size_t p = cuts[t]; p < cuts[t + 1]; ++p)
+        {
+            if (!is_space(buf[p]) && (p == cuts[t] || is_space(buf[p - 1])))
+                ++tokens;
+        }
+        offsets[t + 1] = tokens;
+    }
+
+    offsets[0] = 0;
+    for (int t = 0; t < threads; ++t)
+        offsets[t + 1] += offsets[t];
+    long long total = offsets[threads];
+
+    if (!(data = malloc((total > 0 ? total : 1) * codec->size)))
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        status = -1;
+    }
+
+    // Pass 2: convert tokens into place
+    if (status == 0)
+    {
+        place_output(data, total, codec->size);
+        int invalid = 0;
+#pragma omp parallel for schedule(static, 1) num_threads(threads) reduction(|| : invalid)
+        for (int t = 0; t < threads; ++t)
+        {
+            void *out = data + offsets[t] * codec->size;
+            if (codec->parse(buf + cuts[t], buf + cuts[t + 1], out) < 0)
+                invalid = 1;
+        }
+        if (invalid)
+        {
+            fprintf(stderr, "Invalid data in input file\n");
+            status = -1;
+        }
+    }
+
+    free(cuts);
+    free(offsets);
+    if (status != 0)
+    {
+        free(data);
+        return -1;
+    }
+    *out_data = data;
+    return total;
+}
+
+/**
+ * Function: parse_binary
+ * ----------------------
+ * Validates the header and size, then converts the little-endian payload with
+ * the codec's decoder.
+ */
+static long long parse_binary(const unsigned char *buf, size_t size, const bitonic_record_codec *codec,
+                              void **out_data)
+{
+    int elem;
+    uint64_t count;
+    if (size < BITONIC_IO_HEADER_BYTES || bitonic_decode_header(buf, &elem, &count) != 0)
+    {
+        fprintf(stderr, "Unsupported binary input header\n");
+        return -1;
+    }
+    if ((size - BITONIC_IO_HEADER_BYTES) / elem < count)
+    {
+        fprintf(stderr, "Binary input is truncated\n");
+        return -1;
+    }
+
+    long long n = (long long)count;
+    void *data = malloc((n > 0 ? n : 1) * codec->size);
+    if (!data)
+    {
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+    place_output(data, n, codec->size);
+
+    if (codec->decode(buf + BITONIC_IO_HEADER_BYTES, elem, n, data) != 0)
+    {
+        free(data);
+        fprintf(stderr, "Binary input values do not fit the key type\n");
+        return -1;
+    }
+    *out_data = data;
+    return n;
+}
+
+long long bitonic_read_records(const char *path, const bitonic_record_codec *codec, void **out_data)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("Failed to open input file");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror("Failed to stat input file");
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        *out_data = malloc(codec->size);
+        return *out_data ? 0 : -1;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Failed to map input file");
+        return -1;
+    }
+
+    long long count;
+    if (size >= 4 && memcmp(map, BITONIC_IO_MAGIC, 4) == 0)
+        count = parse_binary((const unsigned char *)map, size, codec, out_data);
+    else
+        count = parse_text((const char *)map, size, codec, out_data);
+
+    munmap(map, size);
+    return count;
+}
+
+int bitonic_parse_output_format(const char *name, bitonic_output_format *format)
+{
+    if (strcmp(name, "text") == 0)
+        *format = BITONIC_OUTPUT_TEXT;
+    else if (strcmp(name, "binary") == 0)
+        *format = BITONIC_OUTPUT_BINARY;
+    else if (strcmp(name, "none") == 0)
+        *format = BITONIC_OUTPUT_NONE;
+    else
+        return -1;
+    return 0;
+}
+
+const char *bitonic_output_path(const char *program, bitonic_output_format format)
+{
+    static char path[256];
+    snprintf(path, sizeof(path), "OutputFiles/%s_output.%s", program,
+             format == BITONIC_OUTPUT_BINARY ? "bin" : "txt");
+    return path;
+}
+
+/* "00" "01" ... "99": two digits per table lookup */
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+int bitonic_format_uint64(char *out, uint64_t value)
+{
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+
+    // Two digits per step from the end of a small scratch buffer
+    while (value >= 100)
+    {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        *--p = digit_pairs[value * 2 + 1];
+        *--p = digit_pairs[value * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + value);
+    }
+
+    int len = (int)(tmp + sizeof(tmp) - p);
+    memcpy(out, p, len);
+    return len;
+}
+
+int bitonic_format_int64(char *out, int64_t value)
+{
+    if (value < 0)
+    {
+        *out = '-';
+        return 1 + bitonic_format_uint64(out + 1, 0 - (uint64_t)value);
+    }
+    return bitonic_format_uint64(out, (uint64_t)value);
+}
+
+size_t bitonic_format_text(char *out, const int *data, long long count, int ends_output)
+{
+    size_t len = 0;
+    for (long long i = 0; i < count; ++i)
+    {
+        len += bitonic_format_int64(out + len, data[i]);
+        out[len++] = ' ';
+    }
+    if (ends_output && len > 0)
+        out[len - 1] = '\n';
+    return len;
+}
+
+/* pwrite() until all 'len' bytes are written; returns 0 or -1 */
+static int pwrite_all(int fd, const char *buf, size_t len, off_t offset)
+{
+    while (len > 0)
+    {
+        ssize_t written = pwrite(fd, buf, len, offset);
+        if (written < 0)
+            return -1;
+        buf += written;
+        len -= (size_t)written;
+        offset += written;
+    }
+    return 0;
+}
+
+/**
+ * Function: write_text
+ * --------------------
+ * Parallel text writer. Work proceeds in rounds of IO_TEXT_BLOCK elements
+ * per thread: every thread formats its block into its own buffer, one
+ * thread turns the lengths into file offsets, then all threads pwrite()
+ * their buffers concurrently.
+ */
+static int write_text(int fd, const bitonic_record_codec *codec, const void *data, long long count)
+{
+    int threads = io_threads((size_t)count * codec->size);
+    size_t capacity = (size_t)IO_TEXT_BLOCK * codec->text_width;
+    char *buffers = malloc((size_t)threads * capacity);
+    size_t *lengths = malloc(threads * sizeof(size_t));
+    off_t *offsets = malloc(threads * sizeof(off_t));
+    off_t file_end = 0;
+    int failed = 0;
+
+    if (!buffers || !lengths || !offsets)
+    {
+        free(buffers);
+        free(lengths);
+        free(offsets);
+        fprintf(stderr, "Memory allocation failed\n");
+        return -1;
+    }
+
+#pragma omp parallel num_threads(threads)
+    {
+#ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int team = omp_get_num_threads();
+#else
+        int tid = 0;
+        int team = 1;
+#endif
+        char *mine = buffers + (size_t)tid * capacity;
+
+        for (long long base = 0; base < count; base += (long long)team * IO_TEXT_BLOCK)
+        {
+            long long lo = base + (long long)tid * IO_TEXT_BLOCK;
+            long long hi = (lo + IO_TEXT_BLOCK < count) ? lo + IO_TEXT_BLOCK : count;
+            size_t len = 0;
+            if (lo < hi)
+                len = codec->format(mine, (const char *)data + lo * codec->size, hi - lo, hi == count);
+            lengths[tid] = len;
+
+#pragma omp barrier
+#pragma omp single
+            {
+                for (int t = 0; t < team; ++t)
+                {
+                    offsets[t] = file_end;
+                    file_end += lengths[t];
+                }
+            }
+
+            if (len > 0 && pwrite_all(fd, mine, len, offsets[tid]) != 0)
+            {
+#pragma omp atomic write
+                failed = 1;
+            }
+        }
+    }
+
+    free(buffers);
+    free(lengths);
+    free(offsets);
+    return failed ? -1 : 0;
+}
+
+/**
+ * Function: write_binary
+ * ----------------------
+ * Writes the header, then IO_BINARY_BLOCK-record slices of the payload in
+ * parallel at their offsets. The codec encodes each slice to little-endian
+ * keys. Key-only records on a little-endian host are already in that layout
+ * and the codecs return them as is, so each thread allocates its one block
+ * of scratch only when the keys really need converting.
+ */
+static int write_binary(int fd, const bitonic_record_codec *codec, const void *data, long long count)
+{
+    unsigned char header[BITONIC_IO_HEADER_BYTES];
+    int elem = codec->key_size;
+    long long blocks = (count + IO_BINARY_BLOCK - 1) / IO_BINARY_BLOCK;
+    int native = IO_HOST_LITTLE_ENDIAN && codec->size == (size_t)elem;
+    int failed = 0;
+
+    bitonic_encode_header(header, elem, (uint64_t)count);
+    if (pwrite_all(fd, (const char *)header, sizeof(header), 0) != 0)
+        return -1;
+
+#pragma omp parallel num_threads(io_threads((size_t)count * codec->size)) reduction(|| : failed)
+    {
+        unsigned char *scratch = NULL;
+        if (!native && blocks > 0)
+        {
+            long long slice = (count < IO_BINARY_BLOCK) ? count : IO_BINARY_BLOCK;
+            scratch = malloc((size_t)slice * elem);
+            failed = !scratch;
+        }
+
+#pragma omp for schedule(static)
+        for (long long b = 0; b < blocks; ++b)
+        {
+            long long lo = b * IO_BINARY_BLOCK;
+            long long hi = (lo + IO_BINARY_BLOCK < count) ? lo + IO_BINARY_BLOCK : count;
+            off_t offset = BITONIC_IO_HEADER_BYTES + (off_t)lo * elem;
+            if (failed)
+                continue;
+            const void *bytes = codec->encode((const char *)data + (size_t)lo * codec->size, hi - lo, scratch);
+            if (pwrite_all(fd, (const char *)bytes, (size_t)(hi - lo) * elem, offset) != 0)
+                failed = 1;
+        }
+        free(scratch);
+    }
+
+    return failed ? -1 : 0;
+}
+
+int bitonic_write_records(const char *path, const bitonic_record_codec *codec, const void *data, long long count,
+                          bitonic_output_format format)
+{
+    if (format == BITONIC_OUTPUT_NONE)
+        return 0;
+    if (format == BITONIC_OUTPUT_BINARY && !codec->encode)
+    {
+        fprintf(stderr, "Binary output is not available for this record type\n");
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror("Failed to open output file");
+        return -1;
+    }
+
+    int status = (format == BITONIC_OUTPUT_BINARY) ? write_binary(fd, codec, data, count)
+                                                   : write_text(fd, codec, data, count);
+    if (close(fd) != 0)
+        status = -1;
+    if (status != 0)
+        perror("Failed to write output file");
+    return status;
+}
+
+/* Codec encode callback for int: little-endian int32 keys */
+static const void *encode_int(const void *data, long long count, unsigned char *scratch)
+{
+#if IO_HOST_LITTLE_ENDIAN
+    (void)count;
+    (void)scratch;
+    return data;
+#else
+    const int *values = data;
+    for (long long i = 0; i < count; ++i)
+    {
+        uint32_t v = (uint32_t)values[i];
+        for (int byte = 0; byte < 4; ++byte)
+            scratch[(size_t)i * 4 + byte] = (unsigned char)(v >> (8 * byte));
+    }
+    return scratch;
+#endif
+}
+
+/* Codec format callback for int */
+static size_t format_int_records(char *out, const void *data, long long count, int ends_output)
+{
+    return bitonic_format_text(out, data, count, ends_output);
+}
+
+/* Codec decode callback for int */
+static int decode_int_records(const unsigned char *payload, int elem_size, long long count, void *out)
+{
+    return bitonic_decode_values(payload, elem_size, count, out);
+}
+
+const bitonic_record_codec bitonic_int_codec = {
+    sizeof(int),
+    4,
+    BITONIC_IO_MAX_TEXT_WIDTH,
+    parse_int_range,
+    decode_int_records,
+    encode_int,
+    format_int_records,
+};
+
+long long bitonic_read_input(const char *path, int **out_data)
+{
+    void *data = NULL;
+    long long count = bitonic_read_records(path, &bitonic_int_codec, &data);
+    *out_data = data;
+    return count;
+}
+
+int bitonic_write_output(const char *path, const int *data, long long count, bitonic_output_format format)
+{
+    return bitonic_write_records(path, &bitonic_int_codec, data, count, format);
+}
@@ -0,0 +1,179 @@
+#ifndef BITONIC_IO_H
+#define BITONIC_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Input loading and output writing shared by the Serial, OpenMP and MPI
+ * programs.
+ *
+ * Two on-disk formats are accepted and told apart by the first bytes:
+ *
+ * Text:   integers separated by any whitespace (the original InputFiles/
+ *         format). The file is mmap'ed, cut into one byte range per thread on
+ *         whitespace boundaries, and parsed in two parallel passes (count,
+ *         then convert into place).
+ *
+ * Binary: a 16-byte little-endian header followed by the raw values
+ *           bytes 0-3   magic "BTNS"
+ *           byte  4     format version (1)
+ *           byte  5     element size in bytes: 4 (int32) or 8 (int64)
+ *           bytes 6-7   reserved, zero
+ *           bytes 8-15  element count (uint64)
+ *         int64 files are narrowed to int and rejected if a value does not
+ *         fit.
+ *
+ * Output is written in the same text layout (values separated by one space,
+ * newline at the end) or binary format. Threads format disjoint ranges into
+ * their own preallocated buffers and write them with pwrite() at offsets
+ * computed from a prefix sum of the formatted lengths.
+ *
+ * With OpenMP the parsers and writers use OMP_NUM_THREADS threads; without
+ * it they run on the calling thread.
+ *
+ * The int entry points (bitonic_read_input / bitonic_write_output) are thin
+ * wrappers over the record entry points with the built-in int codec; other
+ * key and record types (bitonic_keys.h) supply their own codec.
+ */
+
+#define BITONIC_IO_MAGIC "BTNS"
+#define BITONIC_IO_VERSION 1
+#define BITONIC_IO_HEADER_BYTES 16
+/* Longest formatted value plus separator: "-2147483648 " */
+#define BITONIC_IO_MAX_TEXT_WIDTH 12
+
+typedef enum
+{
+    BITONIC_OUTPUT_TEXT,    // Space-separated decimal values
+    BITONIC_OUTPUT_BINARY,  // Binary header + key payload
+    BITONIC_OUTPUT_NONE     // Skip output (benchmarking)
+} bitonic_output_format;
+
+/**
+ * Type-specific callbacks used by the generic readers and writers. Each
+ * callback handles a whole range of records, so the parallel loops pay one
+ * indirect call per block rather than per value.
+ */
+typedef struct
+{
+    size_t size;     // Bytes per in-memory record
+    int key_size;    // Bytes per key in the binary format
+    int text_width;  // Longest formatted record plus separator
+
+    /* Parses every token of [p, end) into out; returns the count or -1 */
+    long long (*parse)(const char *p, const char *end, void *out);
+    /* Converts 'count' little-endian keys of 'elem_size' bytes; 0 or -1 */
+    int (*decode)(const unsigned char *payload, int elem_size, long long count, void *out);
+    /* Returns the little-endian keys of 'count' records, either the records
+       themselves or 'scratch' (count * key_size bytes); NULL = text only */
+    const void *(*encode)(const void *data, long long count, unsigned char *scratch);
+    /* Same contract as bitonic_format_text */
+    size_t (*format)(char *out, const void *data, long long count, int ends_output);
+} bitonic_record_codec;
+
+/* Codec of the int programs: int32 keys, int32/int64 binary input */
+extern const bitonic_record_codec bitonic_int_codec;
+
+/**
+ * Function: bitonic_read_input
+ * ----------------------------
+ * Loads every value of 'path' (text or binary, auto-detected) into a newly
+ * malloc'ed array stored in *out_data.
+ *
+ * @return: Number of values read, or -1 on error (a message is printed)
+ */
+long long bitonic_read_input(const char *path, int **out_data);
+
+/**
+ * Function: bitonic_read_records
+ * ------------------------------
+ * bitonic_read_input for any record type: loads 'path' into a newly
+ * malloc'ed array of codec->size records.
+ *
+ * @return: Number of records read, or -1 on error (a message is printed)
+ */
+long long bitonic_read_records(const char *path, const bitonic_record_codec *codec, void **out_data);
+
+/**
+ * Function: bitonic_parse_output_format
+ * -------------------------------------
+ * Maps "text", "binary" or "none" to a format.
+ * Returns 0 on success, -1 for an unknown name.
+ */
+int bitonic_parse_output_format(const char *name, bitonic_output_format *format);
+
+/**
+ * Function: bitonic_output_path
+ * -----------------------------
+ * Returns the default output path for 'program' ("serial", "openmp", "mpi"):
+ * OutputFiles/<program>_output.txt, or .bin for binary output. The string
+ * lives in a static buffer.
+ */
+const char *bitonic_output_path(const char *program, bitonic_output_format format);
+
+/**
+ * Function: bitonic_write_output
+ * ------------------------------
+ * Writes data[0, count) to 'path' in 'format' (nothing for
+ * BITONIC_OUTPUT_NONE).
+ *
+ * @return: 0 on success, -1 on error (a message is printed)
+ */
+int bitonic_write_output(const char *path, const int *data, long long count, bitonic_output_format format);
+
+/**
+ * Function: bitonic_write_records
+ * -------------------------------
+ * bitonic_write_output for any record type. Binary output fails when the
+ * codec has no encoder.
+ *
+ * @return: 0 on success, -1 on error (a message is printed)
+ */
+int bitonic_write_records(const char *path, const bitonic_record_codec *codec, const void *data, long long count,
+                          bitonic_output_format format);
+
+/**
+ * Function: bitonic_encode_header
+ * -------------------------------
+ * Fills a BITONIC_IO_HEADER_BYTES header for 'count' values of 'elem_size'
+ * bytes.
+ */
+void bitonic_encode_header(unsigned char *header, int elem_size, uint64_t count);
+
+/**
+ * Function: bitonic_decode_header
+ * -------------------------------
+ * Reads the element size and count from a binary header.
+ * Returns 0 on success, -1 if the magic, version or element size is invalid.
+ */
+int bitonic_decode_header(const unsigned char *header, int *elem_size, uint64_t *count);
+
+/**
+ * Function: bitonic_decode_values
+ * -------------------------------
+ * Converts 'count' little-endian values of 'elem_size' bytes to int. For
+ * int32 payloads 'out' may alias 'payload' (converted in place).
+ * Returns 0 on success, -1 if an int64 value does not fit in an int.
+ */
+int bitonic_decode_values(const unsigned char *payload, int elem_size, long long count, int *out);
+
+/**
+ * Function: bitonic_format_text
+ * -----------------------------
+ * Formats data[0, count) as decimal values each followed by a space into
+ * 'out', which needs room for count * BITONIC_IO_MAX_TEXT_WIDTH bytes. With
+ * 'ends_output' the last separator is a newline. Returns the bytes written.
+ */
+size_t bitonic_format_text(char *out, const int *data, long long count, int ends_output);
+
+/**
+ * Function: bitonic_format_int64 / bitonic_format_uint64
+ * ------------------------------------------------------
+ * Writes the decimal digits of 'value' (no terminator) to 'out', which needs
+ * room for 20 bytes. Returns the number of bytes written.
+ */
+int bitonic_format_int64(char *out, int64_t value);
+int bitonic_format_uint64(char *out, uint64_t value);
+
+#endif
@@ -0,0 +1,385 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bitonic_keys.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#include "bitonic_omp.h"
+#endif
+
+#include "bitonic_cpu.h"
+#include "bitonic_simd.h"
+
+#define KEYS_SIGNED 0
+#define KEYS_UNSIGNED 1
+#define KEYS_REAL 2
+
+/* Comparator pairs per work item of a stage that spans several tiles */
+#define KEYS_PAIR_BLOCK 4096
+/* Longest floating-point token accepted by the text parser */
+#define KEYS_TOKEN_MAX 63
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define KEYS_HOST_LITTLE_ENDIAN 0
+#else
+#define KEYS_HOST_LITTLE_ENDIAN 1
+#endif
+
+#define KEYS_CAT_(a, b) a##_##b
+#define KEYS_CAT(a, b) KEYS_CAT_(a, b)
+
+/* Team size of the generic network: same policy as the int engine */
+static int keys_threads(long long n)
+{
+#ifdef _OPENMP
+    return bitonic_omp_threads(n);
+#else
+    (void)n;
+    return 1;
+#endif
+}
+
+/**
+ * Function: keys_tile
+ * -------------------
+ * Cache tile in records, shrunk like the int engine's until every thread
+ * owns a tile. BITONIC_TILE=0 (unblocked) becomes 2-record tiles, which
+ * turns every stage but the last into a whole-array stage.
+ */
+static int keys_tile(size_t record_size, long long n, int threads)
+{
+    int tile = bitonic_tile_elems(record_size);
+    while (tile > 1024 && n / tile < threads)
+        tile >>= 1;
+    return tile > 2 ? tile : 2;
+}
+
+static inline int keys_is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Accumulates the decimal digits at *pos; -1 on overflow or no digits */
+static int keys_parse_digits(const char **pos, const char *end, uint64_t limit, uint64_t *value)
+{
+    const char *p = *pos;
+    uint64_t v = 0;
+
+    if (p == end || *p < '0' || *p > '9')
+        return -1;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        unsigned digit = (unsigned)(*p - '0');
+        if (v > (limit - digit) / 10)
+            return -1;
+        v = v * 10 + digit;
+        ++p;
+    }
+    if (p < end && !keys_is_space(*p))
+        return -1;
+
+    *pos = p;
+    *value = v;
+    return 0;
+}
+
+static int keys_parse_signed(const char **pos, const char *end, int64_t *value)
+{
+    const char *p = *pos;
+    int negative = 0;
+    uint64_t magnitude;
+
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+    if (keys_parse_digits(&p, end, negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX, &magnitude) != 0)
+        return -1;
+
+    *value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    *pos = p;
+    return 0;
+}
+
+static int keys_parse_unsigned(const char **pos, const char *end, uint64_t *value)
+{
+    const char *p = *pos;
+    if (*p == '+')
+        ++p;
+    if (keys_parse_digits(&p, end, UINT64_MAX, value) != 0)
+        return -1;
+    *pos = p;
+    return 0;
+}
+
+/* Copies the token at *pos into a terminated buffer for strtof/strtod */
+static int keys_copy_token(const char **pos, const char *end, char *token)
+{
+    const char *p = *pos;
+    size_t len = 0;
+
+    while (p < end && !keys_is_space(*p))
+    {
+        if (len == KEYS_TOKEN_MAX)
+            return -1;
+        token[len++] = *p++;
+    }
+    token[len] = '\0';
+    *pos = p;
+    return 0;
+}
+
+void bitonic_sort_i32(int32_t *data, long long n)
+{
+#ifdef _OPENMP
+    bitonic_omp_sort(data, n, bitonic_tile_elems(sizeof(int32_t)));
+#else
+    bitonic_simd_sort(data, n);
+#endif
+}
+
+/* ------------------------------------------------------ specializations */
+
+#define SUFFIX i32
+#define REC_T int32_t
+#define KEY_T int32_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MAX INT32_MAX
+#define KEY_NAME "int32"
+#define KEY_ENUM INT32
+#define NATIVE_INT
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX i64
+#define REC_T int64_t
+#define KEY_T int64_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MIN INT64_MIN
+#define KEY_MAX INT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "int64"
+#define KEY_ENUM INT64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX u64
+#define REC_T uint64_t
+#define KEY_T uint64_t
+#define KEY_KIND KEYS_UNSIGNED
+#define KEY_MAX UINT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "uint64"
+#define KEY_ENUM UINT64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX f32
+#define REC_T float
+#define KEY_T float
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtof
+#define KEY_FORMAT "%.9g"
+#define KEY_WIDTH 16
+#define KEY_NAME "float"
+#define KEY_ENUM FLOAT
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX f64
+#define REC_T double
+#define KEY_T double
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtod
+#define KEY_FORMAT "%.17g"
+#define KEY_WIDTH 24
+#define KEY_NAME "double"
+#define KEY_ENUM DOUBLE
+#include "bitonic_keys_impl.h"
+
+/* Key + payload records */
+#define SUFFIX kv_i32_u32
+#define REC_T bitonic_kv_i32_u32
+#define KEY_T int32_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MIN INT32_MIN
+#define KEY_MAX INT32_MAX
+#define KEY_WIDTH 11
+#define KEY_NAME "int32"
+#define KEY_ENUM INT32
+#define PAYLOAD_T uint32_t
+#define PAYLOAD_NAME "index32"
+#define PAYLOAD_ENUM U32
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_i32_u64
+#define REC_T bitonic_kv_i32_u64
+#define KEY_T int32_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MIN INT32_MIN
+#define KEY_MAX INT32_MAX
+#define KEY_WIDTH 11
+#define KEY_NAME "int32"
+#define KEY_ENUM INT32
+#define PAYLOAD_T uint64_t
+#define PAYLOAD_NAME "index64"
+#define PAYLOAD_ENUM U64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_i64_u32
+#define REC_T bitonic_kv_i64_u32
+#define KEY_T int64_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MIN INT64_MIN
+#define KEY_MAX INT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "int64"
+#define KEY_ENUM INT64
+#define PAYLOAD_T uint32_t
+#define PAYLOAD_NAME "index32"
+#define PAYLOAD_ENUM U32
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_i64_u64
+#define REC_T bitonic_kv_i64_u64
+#define KEY_T int64_t
+#define KEY_KIND KEYS_SIGNED
+#define KEY_MIN INT64_MIN
+#define KEY_MAX INT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "int64"
+#define KEY_ENUM INT64
+#define PAYLOAD_T uint64_t
+#define PAYLOAD_NAME "index64"
+#define PAYLOAD_ENUM U64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_u64_u32
+#define REC_T bitonic_kv_u64_u32
+#define KEY_T uint64_t
+#define KEY_KIND KEYS_UNSIGNED
+#define KEY_MAX UINT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "uint64"
+#define KEY_ENUM UINT64
+#define PAYLOAD_T uint32_t
+#define PAYLOAD_NAME "index32"
+#define PAYLOAD_ENUM U32
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_u64_u64
+#define REC_T bitonic_kv_u64_u64
+#define KEY_T uint64_t
+#define KEY_KIND KEYS_UNSIGNED
+#define KEY_MAX UINT64_MAX
+#define KEY_WIDTH 20
+#define KEY_NAME "uint64"
+#define KEY_ENUM UINT64
+#define PAYLOAD_T uint64_t
+#define PAYLOAD_NAME "index64"
+#define PAYLOAD_ENUM U64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_f32_u32
+#define REC_T bitonic_kv_f32_u32
+#define KEY_T float
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtof
+#define KEY_FORMAT "%.9g"
+#define KEY_WIDTH 16
+#define KEY_NAME "float"
+#define KEY_ENUM FLOAT
+#define PAYLOAD_T uint32_t
+#define PAYLOAD_NAME "index32"
+#define PAYLOAD_ENUM U32
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_f32_u64
+#define REC_T bitonic_kv_f32_u64
+#define KEY_T float
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtof
+#define KEY_FORMAT "%.9g"
+#define KEY_WIDTH 16
+#define KEY_NAME "float"
+#define KEY_ENUM FLOAT
+#define PAYLOAD_T uint64_t
+#define PAYLOAD_NAME "index64"
+#define PAYLOAD_ENUM U64
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_f64_u32
+#define REC_T bitonic_kv_f64_u32
+#define KEY_T double
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtod
+#define KEY_FORMAT "%.17g"
+#define KEY_WIDTH 24
+#define KEY_NAME "double"
+#define KEY_ENUM DOUBLE
+#define PAYLOAD_T uint32_t
+#define PAYLOAD_NAME "index32"
+#define PAYLOAD_ENUM U32
+#include "bitonic_keys_impl.h"
+
+#define SUFFIX kv_f64_u64
+#define REC_T bitonic_kv_f64_u64
+#define KEY_T double
+#define KEY_KIND KEYS_REAL
+#define KEY_MAX NAN
+#define KEY_STRTO strtod
+#define KEY_FORMAT "%.17g"
+#define KEY_WIDTH 24
+#define KEY_NAME "double"
+#define KEY_ENUM DOUBLE
+#define PAYLOAD_T uint64_t
+#define PAYLOAD_NAME "index64"
+#define PAYLOAD_ENUM U64
+#include "bitonic_keys_impl.h"
+
+/* ----------------------------------------------------------------- lookup */
+
+/* [key][payload] */
+static const bitonic_key_ops *const key_ops[5][3] = {
+    {&ops_i32, &ops_kv_i32_u32, &ops_kv_i32_u64},
+    {&ops_i64, &ops_kv_i64_u32, &ops_kv_i64_u64},
+    {&ops_u64, &ops_kv_u64_u32, &ops_kv_u64_u64},
+    {&ops_f32, &ops_kv_f32_u32, &ops_kv_f32_u64},
+    {&ops_f64, &ops_kv_f64_u32, &ops_kv_f64_u64},
+};
+
+int bitonic_key_parse(const char *name, bitonic_key_type *key)
+{
+    static const char *const names[] = {"int32", "int64", "uint64", "float", "double"};
+    for (int i = 0; i < 5; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *key = (bitonic_key_type)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int bitonic_payload_parse(const char *name, bitonic_payload_type *payload)
+{
+    static const char *const names[] = {"none", "index32", "index64"};
+    for (int i = 0; i < 3; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *payload = (bitonic_payload_type)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const bitonic_key_ops *bitonic_key_ops_for(bitonic_key_type key, bitonic_payload_type payload)
+{
+    return key_ops[key][payload];
+}
@@ -0,0 +1,117 @@
+#ifndef BITONIC_KEYS_H
+#define BITONIC_KEYS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bitonic_io.h"
+
+/**
+ * Bitonic sorting of key types other than int, and of key + payload records.
+ *
+ * Every (key, payload) combination is a separate compile-time specialization
+ * of one template body (bitonic_keys_impl.h), so the comparator is inlined
+ * into the network rather than called through a pointer. Records compare by
+ * key, then by payload, which makes the order total and the sort stable when
+ * the payload is the input index. Floating-point keys order NaN after every
+ * number.
+ *
+ * Plain int32 keys keep the existing SIMD/OpenMP engine.
+ */
+
+typedef enum
+{
+    BITONIC_KEY_INT32,
+    BITONIC_KEY_INT64,
+    BITONIC_KEY_UINT64,
+    BITONIC_KEY_FLOAT,
+    BITONIC_KEY_DOUBLE
+} bitonic_key_type;
+
+typedef enum
+{
+    BITONIC_PAYLOAD_NONE,  // Keys only
+    BITONIC_PAYLOAD_U32,   // 32-bit payload ("index32": the input position)
+    BITONIC_PAYLOAD_U64    // 64-bit payload ("index64": the input position)
+} bitonic_payload_type;
+
+/* Key + payload records, named bitonic_kv_<key>_<payload> */
+typedef struct { int32_t key;  uint32_t value; } bitonic_kv_i32_u32;
+typedef struct { int32_t key;  uint64_t value; } bitonic_kv_i32_u64;
+typedef struct { int64_t key;  uint32_t value; } bitonic_kv_i64_u32;
+typedef struct { int64_t key;  uint64_t value; } bitonic_kv_i64_u64;
+typedef struct { uint64_t key; uint32_t value; } bitonic_kv_u64_u32;
+typedef struct { uint64_t key; uint64_t value; } bitonic_kv_u64_u64;
+typedef struct { float key;    uint32_t value; } bitonic_kv_f32_u32;
+typedef struct { float key;    uint64_t value; } bitonic_kv_f32_u64;
+typedef struct { double key;   uint32_t value; } bitonic_kv_f64_u32;
+typedef struct { double key;   uint64_t value; } bitonic_kv_f64_u64;
+
+/**
+ * Function: bitonic_sort_<type>
+ * -----------------------------
+ * Sorts data[0, n) ascending (any n). With OpenMP the network runs on
+ * OMP_NUM_THREADS threads once n reaches BITONIC_PARALLEL_MIN elements.
+ */
+void bitonic_sort_i32(int32_t *data, long long n);
+void bitonic_sort_i64(int64_t *data, long long n);
+void bitonic_sort_u64(uint64_t *data, long long n);
+void bitonic_sort_f32(float *data, long long n);
+void bitonic_sort_f64(double *data, long long n);
+void bitonic_sort_kv_i32_u32(bitonic_kv_i32_u32 *data, long long n);
+void bitonic_sort_kv_i32_u64(bitonic_kv_i32_u64 *data, long long n);
+void bitonic_sort_kv_i64_u32(bitonic_kv_i64_u32 *data, long long n);
+void bitonic_sort_kv_i64_u64(bitonic_kv_i64_u64 *data, long long n);
+void bitonic_sort_kv_u64_u32(bitonic_kv_u64_u32 *data, long long n);
+void bitonic_sort_kv_u64_u64(bitonic_kv_u64_u64 *data, long long n);
+void bitonic_sort_kv_f32_u32(bitonic_kv_f32_u32 *data, long long n);
+void bitonic_sort_kv_f32_u64(bitonic_kv_f32_u64 *data, long long n);
+void bitonic_sort_kv_f64_u32(bitonic_kv_f64_u32 *data, long long n);
+void bitonic_sort_kv_f64_u64(bitonic_kv_f64_u64 *data, long long n);
+
+/**
+ * Operations on one record type, for the drivers that pick the type at run
+ * time. Every pointer refers to a specialization of the template body.
+ */
+typedef struct
+{
+    const char *name;               // e.g. "int64" or "float+index32"
+    bitonic_key_type key;
+    bitonic_payload_type payload;
+    size_t size;                    // Bytes per record
+    size_t payload_offset;          // Offset of the payload (0 without one)
+    const bitonic_record_codec *codec;
+
+    /* Sorts data[0, n) ascending */
+    void (*sort)(void *data, long long n);
+    /* Compare-split of two sorted n-record blocks: the lowest (keep_low) or
+       highest n records of mine + theirs, sorted, into out */
+    void (*split)(const void *mine, const void *theirs, long long n, void *out, int keep_low);
+    /* Merges sorted a[0, na) and b[0, nb) into out */
+    void (*merge)(const void *a, long long na, const void *b, long long nb, void *out);
+    /* Fills data[from, to) with records ordered after every real record */
+    void (*fill_max)(void *data, long long from, long long to);
+    /* Sets the payload of data[i] to i (no-op without a payload) */
+    void (*number)(void *data, long long n);
+    /* Returns 1 if record *a may precede record *b */
+    int (*in_order)(const void *a, const void *b);
+} bitonic_key_ops;
+
+/**
+ * Function: bitonic_key_parse / bitonic_payload_parse
+ * ---------------------------------------------------
+ * Map "int32", "int64", "uint64", "float" or "double" to a key type and
+ * "none", "index32" or "index64" to a payload type.
+ * Return 0 on success, -1 for an unknown name.
+ */
+int bitonic_key_parse(const char *name, bitonic_key_type *key);
+int bitonic_payload_parse(const char *name, bitonic_payload_type *payload);
+
+/**
+ * Function: bitonic_key_ops_for
+ * -----------------------------
+ * Returns the operations of the (key, payload) specialization.
+ */
+const bitonic_key_ops *bitonic_key_ops_for(bitonic_key_type key, bitonic_payload_type payload);
+
+#endif
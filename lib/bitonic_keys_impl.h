@@ -0,0 +1,397 @@
+/**
+ * Template body of bitonic_keys.c, included once per (key, payload) type.
+ * Not a standalone header: the includer defines
+ *
+ *   SUFFIX       name suffix, e.g. i64 or kv_f32_u32
+ *   REC_T        record type (KEY_T itself without a payload)
+ *   KEY_T        key type
+ *   KEY_KIND     KEYS_SIGNED, KEYS_UNSIGNED or KEYS_REAL
+ *   KEY_MAX      largest key (NaN for KEYS_REAL)
+ *   KEY_MIN      smallest key (KEYS_SIGNED only)
+ *   KEY_STRTO    strtof or strtod (KEYS_REAL only)
+ *   KEY_FORMAT   printf format of a key (KEYS_REAL only)
+ *   KEY_WIDTH    longest formatted key
+ *   KEY_NAME     option name of the key
+ *   KEY_ENUM     bitonic_key_type suffix, e.g. INT64
+ *   PAYLOAD_T    payload type, left undefined for plain keys
+ *   PAYLOAD_NAME option name of the payload
+ *   PAYLOAD_ENUM bitonic_payload_type suffix, e.g. U32
+ *   NATIVE_INT   defined for plain int32 keys, which keep the SIMD engine
+ *                and the int codec of bitonic_io.c
+ *
+ * and every macro is undefined again at the end.
+ */
+
+#define FN(name) KEYS_CAT(name, SUFFIX)
+
+#ifdef PAYLOAD_T
+#define KEY_OF(r) ((r).key)
+#define PAYLOAD_WIDTH (1 + 20)
+#else
+#define KEY_OF(r) (r)
+#define PAYLOAD_WIDTH 0
+#endif
+
+/* Total order: by key, NaN last; records then by payload */
+static inline int FN(key_less)(KEY_T a, KEY_T b)
+{
+#if KEY_KIND == KEYS_REAL
+    return a < b || (b != b && a == a);
+#else
+    return a < b;
+#endif
+}
+
+static inline int FN(less)(const REC_T *a, const REC_T *b)
+{
+#ifdef PAYLOAD_T
+    if (FN(key_less)(a->key, b->key))
+        return 1;
+    if (FN(key_less)(b->key, a->key))
+        return 0;
+    return a->value < b->value;
+#else
+    return FN(key_less)(*a, *b);
+#endif
+}
+
+/* ---------------------------------------------------------------- sort */
+
+#ifndef NATIVE_INT
+
+static inline void FN(cmpx)(REC_T *data, long long i, long long partner)
+{
+    if (FN(less)(data + partner, data + i))
+    {
+        REC_T t = data[i];
+        data[i] = data[partner];
+        data[partner] = t;
+    }
+}
+
+/**
+ * Function: stage_pairs
+ * ---------------------
+ * Comparator pairs [lo, hi) of stage j of merge step k, in the
+ * all-ascending form used by bitonic_simd.c: pair p compares
+ * i = (p / j) * 2j + p % j with its mirror in the block when 2j == k,
+ * otherwise with i + j. Partners past n (the virtual +inf tail) are skipped.
+ */
+static void FN(stage_pairs)(REC_T *data, long long n, long long k, long long j, long long lo, long long hi)
+{
+    for (long long p = lo; p < hi; ++p)
+    {
+        long long base = (p / j) * 2 * j;
+        long long off = p % j;
+        long long partner = (2 * j == k) ? base + 2 * j - 1 - off : base + off + j;
+        if (partner < n)
+            FN(cmpx)(data, base + off, partner);
+    }
+}
+
+/**
+ * Function: tile_stages
+ * ---------------------
+ * Stages j, j/2, ..., 1 of merge step k restricted to the aligned tile
+ * [lo, lo + tile), which holds every comparator of those stages it touches
+ * as long as 2j <= tile.
+ */
+static void FN(tile_stages)(REC_T *data, long long n, long long k, long long j, long long lo, int tile)
+{
+    long long hi = (lo + tile < n) ? lo + tile : n;
+    for (; j > 0; j >>= 1)
+    {
+        for (long long base = lo; base < hi; base += 2 * j)
+        {
+            for (long long off = 0; off < j; ++off)
+            {
+                long long partner = (2 * j == k) ? base + 2 * j - 1 - off : base + off + j;
+                if (partner >= hi)
+                {
+                    if (2 * j == k)
+                        continue;
+                    break;
+                }
+                FN(cmpx)(data, base + off, partner);
+            }
+        }
+    }
+}
+
+void KEYS_CAT(bitonic_sort, SUFFIX)(REC_T *data, long long n)
+{
+    if (n < 2)
+        return;
+
+    // Stages with 2j <= tile stay inside one cache tile and run tile by tile
+    int threads = keys_threads(n);
+    int tile = keys_tile(sizeof(REC_T), n, threads);
+    long long tiles = (n + tile - 1) / tile;
+
+#pragma omp parallel num_threads(threads)
+    {
+#pragma omp for schedule(static)
+        for (long long t = 0; t < tiles; ++t)
+        {
+            for (long long k = 2; k <= tile && (k >> 1) < n; k <<= 1)
+                FN(tile_stages)(data, n, k, k >> 1, t * tile, tile);
+        }
+
+        for (long long k = 2 * tile; (k >> 1) < n; k <<= 1)
+        {
+            long long j = k >> 1;
+            for (; 2 * j > tile; j >>= 1)
+            {
+                long long pairs = bitonic_simd_stage_pairs(n, j);
+#pragma omp for schedule(static)
+                for (long long b = 0; b < pairs; b += KEYS_PAIR_BLOCK)
+                    FN(stage_pairs)(data, n, k, j, b, (b + KEYS_PAIR_BLOCK < pairs) ? b + KEYS_PAIR_BLOCK : pairs);
+            }
+
+#pragma omp for schedule(static)
+            for (long long t = 0; t < tiles; ++t)
+                FN(tile_stages)(data, n, k, j, t * tile, tile);
+        }
+    }
+}
+
+#endif /* NATIVE_INT */
+
+static void FN(sort_any)(void *data, long long n)
+{
+    KEYS_CAT(bitonic_sort, SUFFIX)(data, n);
+}
+
+/* ------------------------------------------------------ merge and split */
+
+static void FN(merge)(const void *a_any, long long na, const void *b_any, long long nb, void *out_any)
+{
+    const REC_T *a = a_any;
+    const REC_T *b = b_any;
+    REC_T *out = out_any;
+    long long i = 0, j = 0, m = 0;
+
+    while (i < na && j < nb)
+        out[m++] = FN(less)(b + j, a + i) ? b[j++] : a[i++];
+    while (i < na)
+        out[m++] = a[i++];
+    while (j < nb)
+        out[m++] = b[j++];
+}
+
+static void FN(split)(const void *mine_any, const void *theirs_any, long long n, void *out_any, int keep_low)
+{
+    const REC_T *mine = mine_any;
+    const REC_T *theirs = theirs_any;
+    REC_T *out = out_any;
+
+    if (keep_low)
+    {
+        long long i = 0, j = 0;
+        for (long long m = 0; m < n; ++m)
+            out[m] = (j < n && (i >= n || FN(less)(theirs + j, mine + i))) ? theirs[j++] : mine[i++];
+    }
+    else
+    {
+        long long i = n - 1, j = n - 1;
+        for (long long m = n - 1; m >= 0; --m)
+            out[m] = (j >= 0 && (i < 0 || FN(less)(mine + i, theirs + j))) ? theirs[j--] : mine[i--];
+    }
+}
+
+static void FN(fill_max)(void *data_any, long long from, long long to)
+{
+    REC_T *data = data_any;
+    for (long long i = from; i < to; ++i)
+    {
+        KEY_OF(data[i]) = KEY_MAX;
+#ifdef PAYLOAD_T
+        data[i].value = (PAYLOAD_T)-1;
+#endif
+    }
+}
+
+static void FN(number)(void *data_any, long long n)
+{
+#ifdef PAYLOAD_T
+    REC_T *data = data_any;
+    for (long long i = 0; i < n; ++i)
+        data[i].value = (PAYLOAD_T)i;
+#else
+    (void)data_any;
+    (void)n;
+#endif
+}
+
+static int FN(in_order)(const void *a, const void *b)
+{
+    return !FN(less)(b, a);
+}
+
+/* ---------------------------------------------------------------- codec */
+
+#ifndef NATIVE_INT
+
+static long long FN(parse)(const char *p, const char *end, void *out_any)
+{
+    REC_T *out = out_any;
+    long long count = 0;
+
+    while (p < end)
+    {
+        if (keys_is_space(*p))
+        {
+            ++p;
+            continue;
+        }
+#if KEY_KIND == KEYS_REAL
+        char token[KEYS_TOKEN_MAX + 1];
+        char *stop;
+        if (keys_copy_token(&p, end, token) != 0)
+            return -1;
+        KEY_T key = KEY_STRTO(token, &stop);
+        if (stop == token || *stop != '\0')
+            return -1;
+#elif KEY_KIND == KEYS_UNSIGNED
+        uint64_t key;
+        if (keys_parse_unsigned(&p, end, &key) != 0)
+            return -1;
+#else
+        int64_t key;
+        if (keys_parse_signed(&p, end, &key) != 0 || key < KEY_MIN || key > KEY_MAX)
+            return -1;
+#endif
+        KEY_OF(out[count]) = (KEY_T)key;
+        ++count;
+    }
+    return count;
+}
+
+static int FN(decode)(const unsigned char *payload, int elem_size, long long count, void *out_any)
+{
+    REC_T *out = out_any;
+    if (elem_size != (int)sizeof(KEY_T))
+        return -1;
+
+    for (long long i = 0; i < count; ++i)
+    {
+        KEY_T key;
+#if KEYS_HOST_LITTLE_ENDIAN
+        memcpy(&key, payload + (size_t)i * sizeof(KEY_T), sizeof(KEY_T));
+#else
+        unsigned char bytes[sizeof(KEY_T)];
+        for (size_t b = 0; b < sizeof(KEY_T); ++b)
+            bytes[b] = payload[(size_t)i * sizeof(KEY_T) + sizeof(KEY_T) - 1 - b];
+        memcpy(&key, bytes, sizeof(KEY_T));
+#endif
+        KEY_OF(out[i]) = key;
+    }
+    return 0;
+}
+
+static size_t FN(format)(char *out, const void *data_any, long long count, int ends_output)
+{
+    const REC_T *data = data_any;
+    size_t len = 0;
+
+    for (long long i = 0; i < count; ++i)
+    {
+#if KEY_KIND == KEYS_REAL
+        len += (size_t)snprintf(out + len, KEY_WIDTH + 1, KEY_FORMAT, (double)KEY_OF(data[i]));
+#elif KEY_KIND == KEYS_UNSIGNED
+        len += bitonic_format_uint64(out + len, KEY_OF(data[i]));
+#else
+        len += bitonic_format_int64(out + len, KEY_OF(data[i]));
+#endif
+#ifdef PAYLOAD_T
+        out[len++] = ':';
+        len += bitonic_format_uint64(out + len, data[i].value);
+#endif
+        out[len++] = ' ';
+    }
+    if (ends_output && len > 0)
+        out[len - 1] = '\n';
+    return len;
+}
+
+#ifndef PAYLOAD_T
+static const void *FN(encode)(const void *data, long long count, unsigned char *scratch)
+{
+#if KEYS_HOST_LITTLE_ENDIAN
+    (void)count;
+    (void)scratch;
+    return data;
+#else
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < (size_t)count * sizeof(KEY_T); i += sizeof(KEY_T))
+        for (size_t b = 0; b < sizeof(KEY_T); ++b)
+            scratch[i + b] = bytes[i + sizeof(KEY_T) - 1 - b];
+    return scratch;
+#endif
+}
+#endif
+
+static const bitonic_record_codec FN(codec) = {
+    sizeof(REC_T),
+    (int)sizeof(KEY_T),
+    KEY_WIDTH + PAYLOAD_WIDTH + 1,
+    FN(parse),
+    FN(decode),
+#ifdef PAYLOAD_T
+    NULL,  // Binary files hold keys only
+#else
+    FN(encode),
+#endif
+    FN(format),
+};
+#define CODEC (&FN(codec))
+
+#else
+#define CODEC (&bitonic_int_codec)
+#endif /* NATIVE_INT */
+
+/* --------------------------------------------------------------- table */
+
+static const bitonic_key_ops FN(ops) = {
+#ifdef PAYLOAD_T
+    KEY_NAME "+" PAYLOAD_NAME,
+    KEYS_CAT(BITONIC_KEY, KEY_ENUM),
+    KEYS_CAT(BITONIC_PAYLOAD, PAYLOAD_ENUM),
+    sizeof(REC_T),
+    offsetof(REC_T, value),
+#else
+    KEY_NAME,
+    KEYS_CAT(BITONIC_KEY, KEY_ENUM),
+    BITONIC_PAYLOAD_NONE,
+    sizeof(REC_T),
+    0,
+#endif
+    CODEC,
+    FN(sort_any),
+    FN(split),
+    FN(merge),
+    FN(fill_max),
+    FN(number),
+    FN(in_order),
+};
+
+#undef CODEC
+#undef PAYLOAD_WIDTH
+#undef KEY_OF
+#undef FN
+
+#undef SUFFIX
+#undef REC_T
+#undef KEY_T
+#undef KEY_KIND
+#undef KEY_MAX
+#undef KEY_MIN
+#undef KEY_STRTO
+#undef KEY_FORMAT
+#undef KEY_WIDTH
+#undef KEY_NAME
+#undef KEY_ENUM
+#undef PAYLOAD_T
+#undef PAYLOAD_NAME
+#undef PAYLOAD_ENUM
+#undef NATIVE_INT
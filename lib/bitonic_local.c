@@ -0,0 +1,320 @@
+#include "bitonic_local.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bitonic_adaptive.h"
+#include "bitonic_cpu.h"
+#include "bitonic_omp.h"
+#include "bitonic_simd.h"
+
+/* Blocks sorted by the SIMD network before the hybrid engine starts merging */
+#define HYBRID_BLOCK 64
+/* Below this many elements the engines stay on the calling thread */
+#define LOCAL_PARALLEL_MIN 65536
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+static int local_threads(long long n)
+{
+#ifdef _OPENMP
+    return (n >= LOCAL_PARALLEL_MIN) ? omp_get_max_threads() : 1;
+#else
+    (void)n;
+    return 1;
+#endif
+}
+
+void local_insertion_sort(int *data, long long n)
+{
+    for (long long i = 1; i < n; ++i)
+    {
+        int value = data[i];
+        long long j = i - 1;
+        while (j >= 0 && data[j] > value)
+        {
+            data[j + 1] = data[j];
+            --j;
+        }
+        data[j + 1] = value;
+    }
+}
+
+/**
+ * Function: radix_digit
+ * ---------------------
+ * Digit of a signed key at 'shift'. Flipping the sign bit makes the unsigned
+ * order of the keys match their signed order.
+ */
+static inline unsigned radix_digit(int value, int shift)
+{
+    return (((unsigned)value ^ 0x80000000u) >> shift) & (RADIX_BUCKETS - 1);
+}
+
+/**
+ * Function: radix_sort
+ * --------------------
+ * LSD radix sort with four 8-bit passes. Each thread histograms and then
+ * scatters its own static slice, so the per-thread offsets computed from the
+ * histograms keep the sort stable. A pass whose digit is the same for every
+ * key (common for small or clustered values) is skipped.
+ */
+static int radix_sort(int *data, long long n, int *scratch)
+{
+    int threads = local_threads(n);
+    int *owned = scratch ? NULL : malloc(local_sort_scratch_size(n, LOCAL_SORT_RADIX) * sizeof(int));
+    if (!scratch)
+        scratch = owned;
+    if (!scratch)
+        return -1;
+    long long *counts = (long long *)scratch;  // threads x RADIX_BUCKETS histograms, then n ints
+
+    int *src = data;
+    int *dst = scratch + 2 * (size_t)threads * RADIX_BUCKETS;
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS)
+    {
+        int skip = 0;
+
+#pragma omp parallel num_threads(threads)
+        {
+#ifdef _OPENMP
+            int tid = omp_get_thread_num();
+            int team = omp_get_num_threads();
+#else
+            int tid = 0;
+            int team = 1;
+#endif
+            long long lo = n * tid / team;
+            long long hi = n * (tid + 1) / team;
+            long long *mine = counts + tid * RADIX_BUCKETS;
+
+            memset(mine, 0, RADIX_BUCKETS * sizeof(long long));
+            for (long long i = lo; i < hi; ++i)
+                mine[radix_digit(src[i], shift)]++;
+
+#pragma omp barrier
+#pragma omp single
+            {
+                // Exclusive prefix over (digit, thread) turns counts into offsets
+                long long running = 0;
+                for (int d = 0; d < RADIX_BUCKETS; ++d)
+                {
+                    long long total = 0;
+                    for (int t = 0; t < team; ++t)
+                    {
+                        long long c = counts[t * RADIX_BUCKETS + d];
+                        counts[t * RADIX_BUCKETS + d] = running;
+                        running += c;
+                        total += c;
+                    }
+                    if (total == n)
+                        skip = 1;
+                }
+            }
+
+            if (!skip)
+            {
+                for (long long i = lo; i < hi; ++i)
+                    dst[mine[radix_digit(src[i], shift)]++] = src[i];
+            }
+        }
+
+        if (!skip)
+        {
+            int *swap = src;
+            src = dst;
+            dst = swap;
+        }
+    }
+
+    if (src != data)
+        memcpy(data, src, (size_t)n * sizeof(int));
+
+    free(owned);
+    return 0;
+}
+
+/**
+ * Function: merge_runs
+ * --------------------
+ * Stable merge of src[lo, mid) and src[mid, hi) into dst[lo, hi).
+ */
+static void merge_runs(const int *src, int *dst, long long lo, long long mid, long long hi)
+{
+    long long l = lo, r = mid, m = lo;
+    while (l < mid && r < hi)
+        dst[m++] = (src[r] < src[l]) ? src[r++] : src[l++];
+    while (l < mid)
+        dst[m++] = src[l++];
+    while (r < hi)
+        dst[m++] = src[r++];
+}
+
+/**
+ * Function: hybrid_sort
+ * ---------------------
+ * Sorts HYBRID_BLOCK-element blocks with the vectorized bitonic network
+ * (insertion sort for the short last block), then merges runs bottom-up,
+ * ping-ponging between data and one scratch array. Blocks and the merges of
+ * each pass are spread over the threads; once a pass has fewer pairs than
+ * threads, every pair is cut into equal merge-path ranges over the team
+ * (bitonic_merge_range), so the last, largest passes stay parallel.
+ */
+static int hybrid_sort(int *data, long long n, int *scratch)
+{
+    int threads = local_threads(n);
+
+    if (n <= HYBRID_BLOCK)
+    {
+        local_insertion_sort(data, n);
+        return 0;
+    }
+
+    long long blocks = (n + HYBRID_BLOCK - 1) / HYBRID_BLOCK;
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (long long b = 0; b < blocks; ++b)
+    {
+        long long lo = b * HYBRID_BLOCK;
+        if (lo + HYBRID_BLOCK <= n)
+            bitonic_simd_sort(data + lo, HYBRID_BLOCK);
+        else
+            local_insertion_sort(data + lo, n - lo);
+    }
+
+    int *owned = scratch ? NULL : malloc((size_t)n * sizeof(int));
+    if (!scratch)
+        scratch = owned;
+    if (!scratch)
+        return -1;
+
+    int *src = data;
+    int *dst = scratch;
+    for (long long width = HYBRID_BLOCK; width < n; width *= 2)
+    {
+        long long pairs = (n + 2 * width - 1) / (2 * width);
+        if (pairs >= threads)
+        {
+#pragma omp parallel for schedule(static) num_threads(threads)
+            for (long long p = 0; p < pairs; ++p)
+            {
+                long long lo = p * 2 * width;
+                long long mid = (lo + width < n) ? lo + width : n;
+                long long hi = (mid + width < n) ? mid + width : n;
+                merge_runs(src, dst, lo, mid, hi);
+            }
+        }
+        else
+        {
+#pragma omp parallel num_threads(threads)
+            {
+#ifdef _OPENMP
+                int tid = omp_get_thread_num();
+                int team = omp_get_num_threads();
+#else
+                int tid = 0, team = 1;
+#endif
+                for (long long p = 0; p < pairs; ++p)
+                {
+                    long long lo = p * 2 * width;
+                    long long mid = (lo + width < n) ? lo + width : n;
+                    long long hi = (mid + width < n) ? mid + width : n;
+                    long long m0 = (hi - lo) * tid / team;
+                    long long m1 = (hi - lo) * (tid + 1) / team;
+                    bitonic_merge_range(src + lo, mid - lo, src + mid, hi - mid, m0, m1, dst + lo + m0);
+                }
+            }
+        }
+        int *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != data)
+        memcpy(data, src, (size_t)n * sizeof(int));
+    free(owned);
+    return 0;
+}
+
+size_t local_sort_scratch_size(long long n, local_sort_engine engine)
+{
+    switch (engine)
+    {
+    case LOCAL_SORT_RADIX:
+        return (size_t)n + 2 * (size_t)local_threads(n) * RADIX_BUCKETS;
+    case LOCAL_SORT_HYBRID:
+        return (size_t)n;
+    default:
+        return 0;
+    }
+}
+
+int local_sort_parse(const char *name, local_sort_engine *engine)
+{
+    static const struct
+    {
+        const char *name;
+        local_sort_engine engine;
+    } names[] = {
+        {"radix", LOCAL_SORT_RADIX},
+        {"hybrid", LOCAL_SORT_HYBRID},
+        {"bitonic", LOCAL_SORT_BITONIC},
+        {"insertion", LOCAL_SORT_INSERTION},
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+        if (strcmp(name, names[i].name) == 0)
+        {
+            *engine = names[i].engine;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char *local_sort_name(local_sort_engine engine)
+{
+    switch (engine)
+    {
+    case LOCAL_SORT_RADIX:
+        return "radix";
+    case LOCAL_SORT_HYBRID:
+        return "hybrid";
+    case LOCAL_SORT_BITONIC:
+        return "bitonic";
+    case LOCAL_SORT_INSERTION:
+        return "insertion";
+    }
+    return "unknown";
+}
+
+int local_sort(int *data, long long n, local_sort_engine engine)
+{
+    return local_sort_scratch(data, n, engine, NULL);
+}
+
+int local_sort_scratch(int *data, long long n, local_sort_engine engine, int *scratch)
+{
+    if (n < 2)
+        return 0;
+
+    switch (engine)
+    {
+    case LOCAL_SORT_RADIX:
+        return radix_sort(data, n, scratch);
+    case LOCAL_SORT_BITONIC:
+        bitonic_omp_sort(data, n, bitonic_tile_elems(sizeof(int)));  // Calling process' team, cache-tiled
+        return 0;
+    case LOCAL_SORT_INSERTION:
+        local_insertion_sort(data, n);
+        return 0;
+    case LOCAL_SORT_HYBRID:
+    default:
+        return hybrid_sort(data, n, scratch);
+    }
+}
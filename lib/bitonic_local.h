@@ -0,0 +1,69 @@
+#ifndef BITONIC_LOCAL_H
+#define BITONIC_LOCAL_H
+
+#include <stddef.h>
+
+/**
+ * In-memory local sort engines for one process' block of 32-bit keys.
+ *
+ * Used by the MPI ranks for their local phase. Every engine sorts ascending
+ * and, when compiled with OpenMP, spreads its work over the calling process'
+ * threads (OMP_NUM_THREADS per rank).
+ */
+typedef enum
+{
+    LOCAL_SORT_RADIX,     // LSD radix sort, 8-bit digits, parallel histograms
+    LOCAL_SORT_HYBRID,    // SIMD bitonic blocks + parallel bottom-up merges
+    LOCAL_SORT_BITONIC,   // Full SIMD bitonic network on the team (bitonic_omp_sort)
+    LOCAL_SORT_INSERTION  // Insertion sort (small inputs / base case)
+} local_sort_engine;
+
+/**
+ * Function: local_sort_parse
+ * --------------------------
+ * Maps "radix", "hybrid", "bitonic" or "insertion" to an engine.
+ * Returns 0 on success, -1 for an unknown name.
+ */
+int local_sort_parse(const char *name, local_sort_engine *engine);
+
+/**
+ * Function: local_sort_name
+ * -------------------------
+ * Returns the name accepted by local_sort_parse for 'engine'.
+ */
+const char *local_sort_name(local_sort_engine engine);
+
+/**
+ * Function: local_sort
+ * --------------------
+ * Sorts data[0, n) ascending with the chosen engine.
+ * Returns 0 on success, -1 if scratch memory could not be allocated.
+ */
+int local_sort(int *data, long long n, local_sort_engine engine);
+
+/**
+ * Function: local_sort_scratch
+ * ----------------------------
+ * local_sort with caller-owned scratch space of local_sort_scratch_size(n,
+ * engine) ints (NULL allocates it per call), so repeated sorts can reuse
+ * one buffer.
+ */
+int local_sort_scratch(int *data, long long n, local_sort_engine engine, int *scratch);
+
+/**
+ * Function: local_sort_scratch_size
+ * ---------------------------------
+ * Scratch ints local_sort_scratch needs for n elements on the calling
+ * thread's team: n plus per-thread histograms for radix, n for hybrid and
+ * 0 for the in-place engines.
+ */
+size_t local_sort_scratch_size(long long n, local_sort_engine engine);
+
+/**
+ * Function: local_insertion_sort
+ * ------------------------------
+ * Insertion sort of data[0, n); the base case of the hybrid engine.
+ */
+void local_insertion_sort(int *data, long long n);
+
+#endif
@@ -0,0 +1,239 @@
+#define _GNU_SOURCE  // sched_getaffinity, sched_setaffinity, CPU_SET
+#include "bitonic_numa.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Largest number of CPUs / nodes the pinning plan handles */
+#define NUMA_MAX_CPUS 1024
+#define NUMA_MAX_NODES 64
+
+int bitonic_parse_cpulist(const char *list, int *ids, int max)
+{
+    int count = 0;
+    const char *p = list;
+    while (*p && *p != '\n')
+    {
+        char *end;
+        long lo = strtol(p, &end, 10);
+        if (end == p || lo < 0)
+            return -1;
+        long hi = lo;
+        p = end;
+        if (*p == '-')
+        {
+            hi = strtol(p + 1, &end, 10);
+            if (end == p + 1 || hi < lo)
+                return -1;
+            p = end;
+        }
+        for (long id = lo; id <= hi && count < max; ++id)
+            ids[count++] = (int)id;
+        if (*p == ',')
+            ++p;
+        else if (*p && *p != '\n')
+            return -1;
+    }
+    return count;
+}
+
+/* Reads the first line of a sysfs file; returns 0 on success */
+static int read_line(const char *path, char *line, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return -1;
+    int ok = (fgets(line, (int)size, f) != NULL);
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+/* Online node ids; returns their number (0 if unknown) */
+static int online_nodes(int *nodes)
+{
+    char line[512];
+    if (read_line("/sys/devices/system/node/online", line, sizeof(line)) != 0)
+        return 0;
+    int count = bitonic_parse_cpulist(line, nodes, NUMA_MAX_NODES);
+    return count > 0 ? count : 0;
+}
+
+int bitonic_numa_nodes(void)
+{
+    int nodes[NUMA_MAX_NODES];
+    int count = online_nodes(nodes);
+    return count > 0 ? count : 1;
+}
+
+#ifdef __linux__
+/* CPUs the process may use, captured before any thread is pinned */
+static cpu_set_t process_cpus;
+static int process_cpus_valid;
+
+__attribute__((constructor)) static void capture_process_cpus(void)
+{
+    process_cpus_valid = (sched_getaffinity(0, sizeof(process_cpus), &process_cpus) == 0);
+}
+
+static int cpu_allowed(int cpu)
+{
+    return cpu >= 0 && cpu < CPU_SETSIZE && (!process_cpus_valid || CPU_ISSET(cpu, &process_cpus));
+}
+
+/* Pinning plan: thread t runs on pin_cpus[t % pin_count] (pin_count 0 = no pinning) */
+static int pin_cpus[NUMA_MAX_CPUS];
+static int pin_count;
+static atomic_int pin_ready;
+
+/**
+ * Function: plan_scatter
+ * ----------------------
+ * Orders the allowed CPUs round-robin over the NUMA nodes: the first CPU of
+ * every node, then the second of every node, and so on.
+ */
+static int plan_scatter(int *cpus)
+{
+    int nodes[NUMA_MAX_NODES];
+    int node_count = online_nodes(nodes);
+    static int node_cpus[NUMA_MAX_NODES][NUMA_MAX_CPUS];
+    int lengths[NUMA_MAX_NODES] = {0};
+
+    for (int i = 0; i < node_count; ++i)
+    {
+        char path[96], line[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", nodes[i]);
+        if (read_line(path, line, sizeof(line)) != 0)
+            continue;
+        int listed[NUMA_MAX_CPUS];
+        int count = bitonic_parse_cpulist(line, listed, NUMA_MAX_CPUS);
+        for (int c = 0; c < count; ++c)
+        {
+            if (cpu_allowed(listed[c]))
+                node_cpus[i][lengths[i]++] = listed[c];
+        }
+    }
+
+    int total = 0;
+    for (int round = 0; total < NUMA_MAX_CPUS; ++round)
+    {
+        int added = 0;
+        for (int i = 0; i < node_count && total < NUMA_MAX_CPUS; ++i)
+        {
+            if (round < lengths[i])
+            {
+                cpus[total++] = node_cpus[i][round];
+                added = 1;
+            }
+        }
+        if (!added)
+            break;
+    }
+    return total;
+}
+
+static void plan_init(void)
+{
+    const char *env = getenv("BITONIC_PIN");
+    if (!env || !*env || strcmp(env, "none") == 0)
+        return;
+
+    int count = 0;
+    if (strcmp(env, "compact") == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < NUMA_MAX_CPUS; ++cpu)
+        {
+            if (cpu_allowed(cpu))
+                pin_cpus[count++] = cpu;
+        }
+    }
+    else if (strcmp(env, "scatter") == 0)
+    {
+        count = plan_scatter(pin_cpus);
+    }
+    else
+    {
+        int listed[NUMA_MAX_CPUS];
+        int parsed = bitonic_parse_cpulist(env, listed, NUMA_MAX_CPUS);
+        if (parsed < 0)
+            fprintf(stderr, "Ignoring BITONIC_PIN='%s' (expected none, compact, scatter or a CPU list)\n", env);
+        for (int c = 0; c < parsed; ++c)
+        {
+            if (listed[c] < CPU_SETSIZE)
+                pin_cpus[count++] = listed[c];
+        }
+    }
+    pin_count = count;
+}
+#endif
+
+void bitonic_pin_thread(int tid)
+{
+#ifdef __linux__
+    static _Thread_local int bound = -1;
+
+    if (!atomic_load_explicit(&pin_ready, memory_order_acquire))
+    {
+#pragma omp critical(bitonic_pin_plan)
+        if (!atomic_load_explicit(&pin_ready, memory_order_relaxed))
+        {
+            plan_init();
+            atomic_store_explicit(&pin_ready, 1, memory_order_release);
+        }
+    }
+    if (pin_count == 0)
+        return;
+
+    int cpu = pin_cpus[tid % pin_count];
+    if (cpu == bound)
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        bound = cpu;
+#else
+    (void)tid;
+#endif
+}
+
+void bitonic_first_touch(void *data, size_t bytes, int threads)
+{
+    if (bytes == 0)
+        return;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t page = (page_size > 0) ? (uintptr_t)page_size : 4096;
+    uintptr_t base = (uintptr_t)data;
+
+#pragma omp parallel num_threads(threads) proc_bind(close) if (threads > 1)
+    {
+#ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int team = omp_get_num_threads();
+#else
+        int tid = 0;
+        int team = 1;
+        (void)threads;
+#endif
+        bitonic_pin_thread(tid);
+
+        // A page belongs to the thread whose slice holds its first byte
+        uintptr_t lo = base + (uintptr_t)((unsigned long long)bytes * tid / team);
+        uintptr_t hi = base + (uintptr_t)((unsigned long long)bytes * (tid + 1) / team);
+        uintptr_t first = (tid == 0) ? base : (lo + page - 1) / page * page;
+        for (uintptr_t p = first; p < hi; p = (p / page + 1) * page)
+        {
+            volatile char *cell = (volatile char *)p;
+            *cell = *cell;  // Write fault, contents preserved
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef BITONIC_NUMA_H
+#define BITONIC_NUMA_H
+
+#include <stddef.h>
+
+/**
+ * NUMA placement helpers: host topology, thread pinning and first-touch
+ * page placement.
+ *
+ * Linux places a page on the node of the thread that first writes it, and
+ * the OpenMP engine gives thread t the t-th contiguous slice of the array in
+ * every stage. Arrays that a single thread fills therefore live on one node
+ * and the other socket's threads read them across the interconnect on every
+ * stage. bitonic_first_touch faults an array in with the same split before
+ * it is filled, so each slice is local to the thread that sorts it.
+ *
+ * Pinning (BITONIC_PIN) keeps thread t on the same CPU across parallel
+ * regions, so the placement stays valid:
+ * - unset or "none": placement is left to OMP_PLACES / OMP_PROC_BIND
+ * - "compact": thread t runs on the t-th CPU the process may use
+ * - "scatter": threads alternate between NUMA nodes (t % nodes)
+ * - a CPU list such as "0-7,16-23": thread t runs on its t-th entry
+ * Teams larger than the CPU list wrap around it.
+ */
+
+/**
+ * Function: bitonic_parse_cpulist
+ * -------------------------------
+ * Parses a Linux CPU / node list ("0-3,8,10-11") into up to 'max' ids.
+ * Returns the number of ids, or -1 if the list is malformed.
+ */
+int bitonic_parse_cpulist(const char *list, int *ids, int max);
+
+/**
+ * Function: bitonic_numa_nodes
+ * ----------------------------
+ * Number of online NUMA nodes (1 where the topology is unknown).
+ */
+int bitonic_numa_nodes(void);
+
+/**
+ * Function: bitonic_pin_thread
+ * ----------------------------
+ * Pins the calling thread as team member 'tid' under the BITONIC_PIN policy.
+ * Cheap after the first call on a thread: the binding is cached per thread
+ * and only changed when the thread's slot moves.
+ */
+void bitonic_pin_thread(int tid);
+
+/**
+ * Function: bitonic_first_touch
+ * -----------------------------
+ * Faults in the pages of data[0, bytes) with 'threads' pinned threads, thread
+ * t touching the t-th contiguous slice (one thread: the calling thread
+ * touches them all). The contents are preserved.
+ */
+void bitonic_first_touch(void *data, size_t bytes, int threads);
+
+#endif
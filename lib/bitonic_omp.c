@@ -0,0 +1,735 @@
+#include "bitonic_omp.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "bitonic_barrier.h"
+#include "bitonic_numa.h"
+#include "bitonic_simd.h"
+#include "bitonic_trace.h"
+
+/*
+ * Number of comparator pairs handed to the SIMD kernel per fused chunk when
+ * the schedule is unblocked. Must be a multiple of the widest vector (16 ints)
+ * so chunks stay aligned.
+ */
+#define BITONIC_CHUNK_PAIRS 4096
+
+/* Inputs smaller than this are sorted by a single thread (BITONIC_PARALLEL_MIN) */
+#define BITONIC_DEFAULT_PARALLEL_MIN 16384
+
+/**
+ * Function: parallel_threshold
+ * ----------------------------
+ * Returns the minimum size that is worth a thread team. Below it the
+ * barrier cost of log2(n)^2 / 2 stages outweighs the work per stage.
+ */
+static int parallel_threshold(void)
+{
+    const char *env = getenv("BITONIC_PARALLEL_MIN");
+    return env ? atoi(env) : BITONIC_DEFAULT_PARALLEL_MIN;
+}
+
+/**
+ * Function: split_range
+ * ---------------------
+ * Static partition of [0, total) units across 'parts' threads.
+ * Thread 'part' owns [*lo, *hi); every stage uses the same slices.
+ */
+static void split_range(long long total, int part, int parts, long long *lo, long long *hi)
+{
+    *lo = total * part / parts;
+    *hi = total * (part + 1) / parts;
+}
+
+/**
+ * Function: effective_tile
+ * ------------------------
+ * Shrinks the cache tile until every thread owns at least one tile, so the
+ * fused phases still use the whole team on small inputs. Returns 0 (flat
+ * schedule) when blocking is disabled or the tile would be smaller than two
+ * vectors.
+ */
+static int effective_tile(int tile, long long n, int threads)
+{
+    int min_tile = 2 * bitonic_simd_width();
+
+    if (tile <= 0)
+        return 0;
+    while (tile > min_tile && n / tile < threads)
+        tile >>= 1;
+    return (tile >= min_tile) ? tile : 0;
+}
+
+int bitonic_omp_threads(long long n)
+{
+    return (n >= parallel_threshold()) ? omp_get_max_threads() : 1;
+}
+
+int bitonic_omp_tile(int tile, long long n)
+{
+    return effective_tile(tile, n, bitonic_omp_threads(n));
+}
+
+/**
+ * Function: stage_wait
+ * --------------------
+ * Barrier between stages; a no-op for a network run by a single thread.
+ */
+static void stage_wait(bitonic_barrier *barrier, int *sense)
+{
+    if (barrier)
+        bitonic_barrier_wait(barrier, sense);
+}
+
+/**
+ * Function: stage_end
+ * -------------------
+ * stage_wait at the end of stage (k, j) of a team network. With tracing on
+ * (lib/bitonic_trace.h) it also records the thread's work and barrier wait
+ * since *clock, and thread 0 the stage's wall time.
+ */
+static void stage_end(bitonic_barrier *barrier, int *sense, int tid, long long k, long long j, int fused,
+                      double *clock)
+{
+    if (!bitonic_trace_on || !barrier)
+    {
+        stage_wait(barrier, sense);
+        return;
+    }
+    double arrived = omp_get_wtime();
+    stage_wait(barrier, sense);
+    double left = omp_get_wtime();
+    bitonic_trace_thread(tid, arrived - *clock, left - arrived);
+    if (tid == 0)
+        bitonic_trace_stage(k, j, fused, left - *clock);
+    *clock = left;
+}
+
+/**
+ * Function: run_network
+ * ---------------------
+ * Thread tid's share of the whole network over data[0, n) (see
+ * bitonic_omp_sort for the schedule). 'tile' must already be effective for
+ * the team; a NULL barrier runs the network on the calling thread alone.
+ */
+static void run_network(int *data, long long n, int tile, int tid, int threads, bitonic_barrier *barrier, int *sense)
+{
+    int width = bitonic_simd_width();
+    long long k = 2;
+    long long c_lo, c_hi;
+    double clock = bitonic_trace_on ? omp_get_wtime() : 0.0;
+
+    // Chunk for fused tails: a tile, or 2 * BITONIC_CHUNK_PAIRS when unblocked
+    long long chunk = (tile > 0) ? tile : 2 * BITONIC_CHUNK_PAIRS;
+    long long chunks = (n + chunk - 1) / chunk;
+
+    // Static slice of the fused chunks
+    split_range(chunks, tid, threads, &c_lo, &c_hi);
+
+    // Fused tile sort: all stages of k = 2 .. tile in one pass
+    if (tile > 0)
+    {
+        for (long long c = c_lo; c < c_hi; ++c)
+        {
+            long long hi = (c * tile + tile < n) ? c * tile + tile : n;
+            for (long long kk = 2; kk <= tile; kk <<= 1)
+            {
+                bitonic_simd_merge_tail(data, kk, kk >> 1, c * tile, hi);
+            }
+        }
+        stage_end(barrier, sense, tid, tile, 0, 1, &clock);
+        k = tile << 1;
+    }
+
+    // k represents the size of bitonic sequences being built
+    for (; (k >> 1) < n; k <<= 1)
+    {
+        // j represents the comparison distance
+        for (long long j = k >> 1; j > 0; j >>= 1)
+        {
+            if (j < width || (tile > 0 && 2 * j <= tile))
+            {
+                // Chunks are multiples of 2j, so every comparator stays inside one
+                for (long long c = c_lo; c < c_hi; ++c)
+                {
+                    long long lo = c * chunk;
+                    long long hi = (lo + chunk < n) ? lo + chunk : n;
+                    bitonic_simd_merge_tail(data, k, j, lo, hi);
+                }
+                stage_end(barrier, sense, tid, k, j, 1, &clock);
+                break;  // Stages j, j/2, ..., 1 are done
+            }
+
+            // 16-aligned slice of the pairs that have work in this stage
+            long long pairs = bitonic_simd_stage_pairs(n, j);
+            long long p_lo, p_hi;
+            split_range((pairs + 15) / 16, tid, threads, &p_lo, &p_hi);
+            p_lo = (16 * p_lo < pairs) ? 16 * p_lo : pairs;
+            p_hi = (16 * p_hi < pairs) ? 16 * p_hi : pairs;
+            if (p_lo < p_hi)
+            {
+                bitonic_simd_stage(data, n, k, j, p_lo, p_hi);
+            }
+            stage_end(barrier, sense, tid, k, j, 0, &clock);
+        }
+    }
+}
+
+/**
+ * Function: bitonic_omp_sort
+ * --------------------------
+ * Implements the parallel bitonic sort algorithm using OpenMP.
+ * Bitonic sort works by repeatedly building and merging bitonic sequences.
+ * 
+ * Algorithm:
+ * - Outer loop (k): Controls the size of bitonic sequences (2, 4, 8, ...,
+ *   up to the power of 2 covering n)
+ * - Middle loop (j): Controls the comparison distance within each sequence
+ * - Inner step: Each thread runs its static slice of the comparator pairs
+ *   of stage (k, j) through the vectorized kernel in lib/bitonic_simd.c
+ *
+ * Any n is accepted: the kernel skips the comparators that would reach the
+ * virtual padding past n, and only the pairs below
+ * bitonic_simd_stage_pairs(n, j) are split across the team.
+ * 
+ * - Large j: branchless vector min/max over contiguous blocks
+ * - Small j (below the vector width): every remaining stage of this k runs
+ *   in registers, so the j loop ends after a single fused pass
+ *
+ * Cache-blocked schedule (tile > 0):
+ * - Every k <= tile only touches pairs inside one tile, so each thread sorts
+ *   its tiles through all of those stages behind a single barrier
+ * - For larger k, once 2j <= tile the remaining stages j, j/2, ..., 1 stay
+ *   inside a tile and are fused into one pass per thread
+ * Only the stages with 2j > tile stream the whole array, which cuts DRAM
+ * passes from log2(n)^2 / 2 to roughly (log2(n) - log2(tile))^2 / 2 + log2(n).
+ *
+ * Threading:
+ * - One parallel region spans the whole sort; stages are separated by a
+ *   sense-reversing spin barrier (lib/bitonic_barrier.c) instead of a
+ *   fork/join per stage. proc_bind(close) keeps the team pinned to the
+ *   places given by OMP_PLACES, and BITONIC_PIN pins thread t to a fixed
+ *   CPU (lib/bitonic_numa.c) so its slices stay on its NUMA node.
+ * - Inputs below parallel_threshold() run on a team of one thread.
+ */
+void bitonic_omp_sort(int *data, long long n, int tile)
+{
+    int team = bitonic_omp_threads(n);
+    bitonic_barrier barrier;
+
+    tile = effective_tile(tile, n, team);
+
+#pragma omp parallel num_threads(team) proc_bind(close)
+    {
+        int tid = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int sense = 0;  // Local sense for the barrier
+
+        bitonic_pin_thread(tid);
+#pragma omp single
+        bitonic_barrier_init(&barrier, threads);
+
+        run_network(data, n, tile, tid, threads, &barrier, &sense);
+    }
+}
+
+int bitonic_omp_block_swap(void)
+{
+    const char *env = getenv("BITONIC_BLOCK_SWAP");
+    return env && atoi(env) > 0;
+}
+
+/* Real length of block b of 'size' elements over n values (0 past the end) */
+static long long block_length(long long n, long long size, int b)
+{
+    long long lo = b * size;
+    if (lo >= n)
+        return 0;
+    return (n - lo < size) ? n - lo : size;
+}
+
+/**
+ * Function: merge_low / merge_high
+ * --------------------------------
+ * The two halves of a compare-split of the sorted blocks a[0, la) (lower
+ * block, full) and b[0, lb) (upper block, 0 < lb <= la): the la smallest
+ * values go to out in ascending order, or the lb largest ones. Ties are
+ * taken from a first, so the halves partition the values. The selects
+ * compile to conditional moves.
+ */
+static void merge_low(int *out, const int *a, long long la, const int *b, long long lb)
+{
+    long long i = 0, t = 0;
+    for (long long m = 0; m < la; ++m)
+    {
+        int x = a[i];
+        int y = b[(t < lb) ? t : lb - 1];
+        int take = (t < lb) & (y < x);
+        out[m] = take ? y : x;
+        t += take;
+        i += !take;
+    }
+}
+
+static void merge_high(int *out, const int *a, long long la, const int *b, long long lb)
+{
+    long long i = la - 1, t = lb - 1;
+    for (long long m = lb - 1; m >= 0; --m)
+    {
+        int x = a[i];
+        int y = b[(t >= 0) ? t : 0];
+        int take = (t >= 0) & (y >= x);
+        out[m] = take ? y : x;
+        t -= take;
+        i -= !take;
+    }
+}
+
+/**
+ * Function: bitonic_omp_sort_blocks
+ * ---------------------------------
+ * Blocked variant of bitonic_omp_sort for NUMA hosts. Thread t owns block
+ * t, data[t * S, (t + 1) * S) with S = ceil(n / T), for the whole sort:
+ *
+ * 1. Each thread sorts its block alone with the cache-blocked network, so
+ *    every stage with j < S stays in memory local to the thread
+ * 2. The stages with j >= S become the same network over the T blocks, with
+ *    every comparator replaced by a compare-split (as in the MPI exchange):
+ *    the first stage of step k pairs block t with its mirror t ^ (k - 1),
+ *    the others with t ^ j, and the lower block keeps the smaller half.
+ *    Each thread streams the two blocks once and writes only its own half,
+ *    so a cross-socket stage is one bulk read of the partner's block
+ *    instead of a strided min/max pass over the whole array
+ *
+ * Rounds ping-pong between data and scratch[0, n) per block; a pair
+ * whose blocks are already in order, or whose upper block is empty, is
+ * skipped. The virtual +infinity padding of the last block never moves, as
+ * in the flat network. Falls back to bitonic_omp_sort when the team is not
+ * a power of 2 larger than 1 or scratch is NULL.
+ */
+size_t bitonic_omp_blocks_scratch(long long n)
+{
+    return (size_t)n + 2 * (size_t)bitonic_omp_threads(n);
+}
+
+void bitonic_omp_sort_blocks(int *data, long long n, int tile, int *scratch)
+{
+    int team = bitonic_omp_threads(n);
+    if (team < 2 || (team & (team - 1)) != 0 || !scratch)
+    {
+        bitonic_omp_sort(data, n, tile);
+        return;
+    }
+    // in_scratch[r % 2][b]: block b lives in scratch before round r (the
+    // flags follow the n-int buffer in the caller's scratch)
+    int *in_scratch = scratch + n;
+    memset(in_scratch, 0, 2 * (size_t)team * sizeof(int));
+
+    long long size = n / team + (n % team != 0);
+    int block_tile = effective_tile(tile, size, 1);
+    bitonic_barrier barrier;
+
+#pragma omp parallel num_threads(team) proc_bind(close)
+    {
+        int tid = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int sense = 0;
+
+        bitonic_pin_thread(tid);
+#pragma omp single
+        bitonic_barrier_init(&barrier, threads);
+
+        if (threads == team)
+        {
+            long long lo = tid * size;
+            long long len = block_length(n, size, tid);
+            int round = 0;
+
+            // Step 1: local network over the thread's own block
+            if (len > 0)
+                run_network(data + lo, len, block_tile, 0, 1, NULL, NULL);
+            bitonic_barrier_wait(&barrier, &sense);
+
+            // Step 2: compare-split network over the blocks. Both members of
+            // a pair read the round's row of in_scratch; each writes only its
+            // own entry of the next row
+            for (int k = 2; k <= threads; k <<= 1)
+            {
+                for (int j = k >> 1; j > 0; j >>= 1, ++round)
+                {
+                    const int *now = in_scratch + (round % 2) * threads;
+                    int *next = in_scratch + ((round + 1) % 2) * threads;
+                    int partner = (j == k >> 1) ? tid ^ (k - 1) : tid ^ j;
+                    int low = (tid < partner) ? tid : partner;
+                    int high = low ^ (tid ^ partner);
+                    long long la = block_length(n, size, low);
+                    long long lb = block_length(n, size, high);
+                    const int *a = (now[low] ? scratch : data) + (size_t)low * size;
+                    const int *b = (now[high] ? scratch : data) + (size_t)high * size;
+
+                    next[tid] = now[tid];
+                    if (lb > 0 && a[la - 1] > b[0])
+                    {
+                        int *out = (now[tid] ? data : scratch) + (size_t)lo;
+                        if (tid == low)
+                            merge_low(out, a, la, b, lb);
+                        else
+                            merge_high(out, a, la, b, lb);
+                        next[tid] = !now[tid];
+                    }
+                    bitonic_barrier_wait(&barrier, &sense);
+                }
+            }
+
+            if (len > 0 && in_scratch[(round % 2) * threads + tid])
+                memcpy(data + lo, scratch + lo, (size_t)len * sizeof(int));
+        }
+        else
+        {
+            // Short team: plain network
+            run_network(data, n, effective_tile(tile, n, threads), tid, threads, &barrier, &sense);
+        }
+    }
+}
+
+/* Comparator pairs per task when a task-engine stage is split */
+#define TASK_STAGE_PAIRS 16384
+
+/**
+ * Function: task_cutoff
+ * ---------------------
+ * Leaf size of the task engine: BITONIC_TASK_CUTOFF, else the cache tile,
+ * rounded down to a power of 2 of at least two vectors.
+ */
+static int task_cutoff(int tile)
+{
+    const char *env = getenv("BITONIC_TASK_CUTOFF");
+    int cutoff = env ? atoi(env) : tile;
+    int leaf = 2 * bitonic_simd_width();
+
+    if (cutoff <= 0)
+        cutoff = 2 * BITONIC_CHUNK_PAIRS;
+    while (leaf <= cutoff / 2)
+        leaf <<= 1;
+    return leaf;
+}
+
+/**
+ * Function: task_stage
+ * --------------------
+ * Stage (k, j) of the block data[base, base + 2j), split into tasks of
+ * TASK_STAGE_PAIRS comparator pairs. base is a multiple of 2j, so the
+ * block's pairs are [base / 2, base / 2 + j).
+ */
+static void task_stage(int *data, long long n, long long k, long long j, long long base)
+{
+    long long p_lo = base / 2;
+    long long p_hi = p_lo + j;
+    long long pairs = bitonic_simd_stage_pairs(n, j);
+    if (p_hi > pairs)
+        p_hi = pairs;
+
+    for (long long p = p_lo; p < p_hi; p += TASK_STAGE_PAIRS)
+    {
+        long long hi = (p + TASK_STAGE_PAIRS < p_hi) ? p + TASK_STAGE_PAIRS : p_hi;
+#pragma omp task firstprivate(p, hi)
+        bitonic_simd_stage(data, n, k, j, p, hi);
+    }
+#pragma omp taskwait
+}
+
+/**
+ * Function: task_merge
+ * --------------------
+ * Stages size/2, size/4, ..., 1 of merge step k on data[base, base + size):
+ * the stage over the whole block, then the two halves as independent tasks.
+ * Blocks of at most 'cutoff' elements run every remaining stage in cache
+ * with bitonic_simd_merge_tail.
+ */
+static void task_merge(int *data, long long n, long long k, long long base, long long size, int cutoff)
+{
+    if (base >= n)
+        return;
+    if (size <= cutoff)
+    {
+        long long hi = (base + size < n) ? base + size : n;
+        bitonic_simd_merge_tail(data, k, size >> 1, base, hi);
+        return;
+    }
+
+    long long half = size >> 1;
+    task_stage(data, n, k, half, base);
+#pragma omp task
+    task_merge(data, n, k, base, half, cutoff);
+    task_merge(data, n, k, base + half, half, cutoff);
+#pragma omp taskwait
+}
+
+/**
+ * Function: task_sort
+ * -------------------
+ * Sorts data[base, base + size) (size a power of 2, clipped to n): both
+ * halves as independent tasks, then merge step k = size over the block.
+ * Blocks of at most 'cutoff' elements are sorted by one thread in cache.
+ */
+static void task_sort(int *data, long long n, long long base, long long size, int cutoff)
+{
+    if (base >= n)
+        return;
+    if (size <= cutoff)
+    {
+        long long len = (base + size < n) ? size : n - base;
+        bitonic_simd_sort(data + base, len);
+        return;
+    }
+
+    long long half = size >> 1;
+#pragma omp task
+    task_sort(data, n, base, half, cutoff);
+    task_sort(data, n, base + half, half, cutoff);
+#pragma omp taskwait
+    task_merge(data, n, size, base, size, cutoff);
+}
+
+/**
+ * Function: bitonic_omp_sort_tasks
+ * --------------------------------
+ * Task-based variant of bitonic_omp_sort: the same all-ascending network,
+ * walked recursively as in bitonic_sort_recursive / bitonic_merge
+ * (lib/bitonic_dist.c) instead of stage by stage.
+ *
+ * - Sub-sorts and sub-merges are OpenMP tasks; idle threads take queued
+ *   tasks from the runtime's pool, so a slow or descheduled thread delays
+ *   only its own tasks instead of every thread at a barrier
+ * - Leaves of 'cutoff' elements (the cache tile by default) are sorted or
+ *   merged entirely in cache by one thread
+ * - Only the stages of blocks larger than the cutoff stream memory; they
+ *   are split into tasks of TASK_STAGE_PAIRS pairs and joined with a
+ *   taskwait that covers just that block
+ *
+ * BITONIC_TASK_CUTOFF overrides the leaf size. Inputs below
+ * parallel_threshold() run on a team of one thread.
+ */
+void bitonic_omp_sort_tasks(int *data, long long n, int tile)
+{
+    int team = bitonic_omp_threads(n);
+    int cutoff = task_cutoff(tile);
+    long long size = 1;
+    while (size < n)
+        size <<= 1;
+
+#pragma omp parallel num_threads(team) proc_bind(close)
+    {
+        bitonic_pin_thread(omp_get_thread_num());
+#pragma omp single
+        task_sort(data, n, 0, size, cutoff);
+    }
+}
+
+long long bitonic_omp_topk_width(long long k)
+{
+    long long width = 1;
+    while (width < k)
+        width <<= 1;
+    return width;
+}
+
+/**
+ * Function: topk_absorb
+ * ---------------------
+ * Folds the 'fill' candidates in buf[K, K + fill) into the running best
+ * buf[0, K): pads them to K with INT_MAX, sorts them and keeps the K
+ * smallest of both with a truncated merge.
+ */
+static void topk_absorb(int *buf, long long width, long long fill)
+{
+    for (long long i = fill; i < width; ++i)
+        buf[width + i] = INT_MAX;
+    bitonic_simd_sort(buf + width, width);
+    bitonic_simd_merge_low(buf, width);
+}
+
+/**
+ * Function: bitonic_omp_topk
+ * --------------------------
+ * Partial sort: the k smallest values of data[0, n), ascending, in out.
+ *
+ * Every thread scans its static slice of the input and keeps a running best
+ * of K = bitonic_omp_topk_width(k) values in its 2K-int scratch buffer:
+ * - a value can only enter the k smallest if it is below the current k-th
+ *   best, so the scan just appends those candidates to the upper half
+ * - once K candidates are collected they are sorted (a K-element bitonic
+ *   network, in cache) and folded in with bitonic_simd_merge_low, which
+ *   keeps the K smallest and discards the rest
+ * The thread results are then folded into thread 0's buffer the same way.
+ * Each merge costs O(K log K), and after the first few blocks the
+ * threshold rejects almost every value of a random input, so the work is
+ * close to one pass over the data for k much smaller than n.
+ *
+ * 'scratch' holds bitonic_omp_threads(n) * 2K ints.
+ */
+void bitonic_omp_topk(const int *data, long long n, long long k, int *out, int *scratch)
+{
+    long long width = bitonic_omp_topk_width(k);
+    int team = bitonic_omp_threads(n);
+
+#pragma omp parallel num_threads(team) proc_bind(close)
+    {
+        int tid = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        int *buf = scratch + (size_t)tid * 2 * width;
+        long long lo, hi;
+
+        bitonic_pin_thread(tid);
+        for (long long i = 0; i < width; ++i)
+            buf[i] = INT_MAX;
+
+        // The k-th best so far; only values below it can be among the k smallest
+        int threshold = INT_MAX;
+        long long fill = 0;
+        split_range(n, tid, threads, &lo, &hi);
+        for (long long i = lo; i < hi; ++i)
+        {
+            int value = data[i];
+            if (value < threshold)
+            {
+                buf[width + fill++] = value;
+                if (fill == width)
+                {
+                    topk_absorb(buf, width, fill);
+                    threshold = buf[k - 1];
+                    fill = 0;
+                }
+            }
+        }
+        if (fill > 0)
+            topk_absorb(buf, width, fill);
+
+#pragma omp barrier
+#pragma omp single
+        {
+            for (int t = 1; t < threads; ++t)
+            {
+                memcpy(scratch + width, scratch + (size_t)t * 2 * width, (size_t)width * sizeof(int));
+                bitonic_simd_merge_low(scratch, width);
+            }
+            memcpy(out, scratch, (size_t)k * sizeof(int));
+        }
+    }
+}
+
+/* Size classes of the segmented sort: class c pads to 2^c elements */
+#define SEGMENT_CLASSES 32
+/* Segments this short are insertion-sorted in registers and L1 */
+#define SEGMENT_INSERTION_MAX 8
+/* Largest per-thread segment buffer: BITONIC_PARALLEL_MIN is clamped to it */
+#define SEGMENT_MAX_LIMIT (1 << 20)
+
+/* Padded size class of a segment: ceil(log2(len)) */
+static int segment_class(long long len)
+{
+    int c = 0;
+    while ((1LL << c) < len)
+        ++c;
+    return c;
+}
+
+int bitonic_omp_segment_limit(void)
+{
+    int limit = parallel_threshold();
+    return (limit > SEGMENT_MAX_LIMIT) ? SEGMENT_MAX_LIMIT : limit;
+}
+
+/* Buffer of one thread: the class size of the longest short segment */
+static size_t segment_pad(int limit)
+{
+    return (limit > 1) ? (size_t)1 << segment_class(limit - 1) : 1;
+}
+
+size_t bitonic_omp_segments_scratch(int segments, int threads)
+{
+    return (size_t)segments + (size_t)threads * segment_pad(bitonic_omp_segment_limit());
+}
+
+/**
+ * Function: bitonic_omp_sort_segments
+ * -----------------------------------
+ * Segments shorter than bitonic_omp_segment_limit() are sorted one per
+ * thread: a counting sort orders them by padded size class, largest class
+ * first, and one parallel loop hands them out in that order in small
+ * dynamic chunks, so each thread runs long streaks of the same kernel and
+ * the big ones cannot straggle at the end. A segment is copied into the
+ * thread's buffer, padded with INT_MAX to its class size 2^c and sorted by
+ * the SIMD network with no ragged edges (power-of-2 segments are sorted in
+ * place, those of up to SEGMENT_INSERTION_MAX values by insertion).
+ * Longer segments are left to the caller.
+ */
+void bitonic_omp_sort_segments(int *data, const long long *offsets, int segments, int *scratch)
+{
+    int limit = bitonic_omp_segment_limit();
+    int team = omp_get_max_threads();
+    size_t pad = segment_pad(limit);
+    int *order = scratch;
+    int *buffers = scratch + segments;
+
+    // Counting sort of the short segments by class, largest class first
+    int start[SEGMENT_CLASSES + 1] = {0};
+    for (int s = 0; s < segments; ++s)
+    {
+        long long len = offsets[s + 1] - offsets[s];
+        if (len > 1 && len < limit)
+            ++start[SEGMENT_CLASSES - 1 - segment_class(len) + 1];
+    }
+    for (int c = 0; c < SEGMENT_CLASSES; ++c)
+        start[c + 1] += start[c];
+    int small = start[SEGMENT_CLASSES];
+    for (int s = 0; s < segments; ++s)
+    {
+        long long len = offsets[s + 1] - offsets[s];
+        if (len > 1 && len < limit)
+            order[start[SEGMENT_CLASSES - 1 - segment_class(len)]++] = s;
+    }
+
+    if (small > 0)
+    {
+#pragma omp parallel num_threads(small < team ? small : team) proc_bind(close)
+        {
+            int tid = omp_get_thread_num();
+            int *buf = buffers + tid * pad;
+
+            bitonic_pin_thread(tid);
+#pragma omp for schedule(dynamic, 16)
+            for (int i = 0; i < small; ++i)
+            {
+                int *seg = data + offsets[order[i]];
+                long long len = offsets[order[i] + 1] - offsets[order[i]];
+                int width = 1 << segment_class(len);
+                if (len <= SEGMENT_INSERTION_MAX)
+                {
+                    for (int a = 1; a < len; ++a)
+                    {
+                        int v = seg[a], b = a;
+                        for (; b > 0 && seg[b - 1] > v; --b)
+                            seg[b] = seg[b - 1];
+                        seg[b] = v;
+                    }
+                }
+                else if (width == len)
+                {
+                    bitonic_simd_sort(seg, len);
+                }
+                else
+                {
+                    memcpy(buf, seg, (size_t)len * sizeof(int));
+                    for (long long t = len; t < width; ++t)
+                        buf[t] = INT_MAX;
+                    bitonic_simd_sort(buf, width);
+                    memcpy(seg, buf, (size_t)len * sizeof(int));
+                }
+            }
+        }
+    }
+}
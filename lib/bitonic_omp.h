@@ -0,0 +1,92 @@
+#ifndef BITONIC_OMP_H
+#define BITONIC_OMP_H
+
+#include <stddef.h>
+
+/**
+ * OpenMP bitonic sort engine (shared by the OpenMP program and the hybrid
+ * MPI + OpenMP mode of the MPI program).
+ */
+
+/**
+ * Function: bitonic_omp_sort
+ * --------------------------
+ * Sorts data[0, n) ascending with a persistent OpenMP team running the SIMD
+ * bitonic network (any n, no padding needed). 'tile' is the cache tile in
+ * elements (see bitonic_tile_elems); 0 selects the unblocked schedule.
+ */
+void bitonic_omp_sort(int *data, long long n, int tile);
+
+/**
+ * Function: bitonic_omp_sort_blocks
+ * ---------------------------------
+ * bitonic_omp_sort with one contiguous block per thread: each thread sorts
+ * its block, then the blocks are merged by compare-split rounds between
+ * pairs of threads instead of whole-array stages (see lib/bitonic_omp.c).
+ * 'scratch' holds bitonic_omp_blocks_scratch(n) ints (the n-int ping-pong
+ * buffer and the per-block placement flags), so the call allocates
+ * nothing; without it, or on a team that is not a power of 2, the call
+ * falls back to bitonic_omp_sort.
+ */
+void bitonic_omp_sort_blocks(int *data, long long n, int tile, int *scratch);
+size_t bitonic_omp_blocks_scratch(long long n);
+
+/**
+ * Function: bitonic_omp_sort_tasks
+ * --------------------------------
+ * bitonic_omp_sort with the network walked recursively as OpenMP tasks:
+ * sub-sorts and sub-merges are scheduled by the runtime's work stealing
+ * and leaves of BITONIC_TASK_CUTOFF elements (default: 'tile') run in
+ * cache on one thread (see lib/bitonic_omp.c).
+ */
+void bitonic_omp_sort_tasks(int *data, long long n, int tile);
+
+/**
+ * Function: bitonic_omp_topk / bitonic_omp_topk_width
+ * ---------------------------------------------------
+ * Writes the k smallest values of data[0, n) (1 <= k <= n) to out[0, k) in
+ * ascending order without sorting the rest (see lib/bitonic_omp.c).
+ * 'scratch' holds bitonic_omp_threads(n) * 2 * bitonic_omp_topk_width(k)
+ * ints; the width is k rounded up to a power of 2.
+ */
+void bitonic_omp_topk(const int *data, long long n, long long k, int *out, int *scratch);
+long long bitonic_omp_topk_width(long long k);
+
+/**
+ * Function: bitonic_omp_sort_segments
+ * -----------------------------------
+ * Sorts every segment data[offsets[s], offsets[s + 1]) of 'segments'
+ * shorter than bitonic_omp_segment_limit() elements (BITONIC_PARALLEL_MIN,
+ * at most 2^20) independently (see lib/bitonic_omp.c): they are spread
+ * over the team one per thread, grouped by padded power-of-2 size. Longer
+ * segments are left untouched. 'scratch' holds
+ * bitonic_omp_segments_scratch(segments, omp_get_max_threads()) ints.
+ */
+void bitonic_omp_sort_segments(int *data, const long long *offsets, int segments, int *scratch);
+size_t bitonic_omp_segments_scratch(int segments, int threads);
+int bitonic_omp_segment_limit(void);
+
+/**
+ * Function: bitonic_omp_block_swap
+ * --------------------------------
+ * Returns 1 if BITONIC_BLOCK_SWAP selects bitonic_omp_sort_blocks for int
+ * sorts (BITONIC_BLOCK_SWAP=1), 0 otherwise.
+ */
+int bitonic_omp_block_swap(void);
+
+/**
+ * Function: bitonic_omp_threads
+ * -----------------------------
+ * Team size bitonic_omp_sort uses for n elements: OMP_NUM_THREADS, or 1
+ * below the BITONIC_PARALLEL_MIN threshold.
+ */
+int bitonic_omp_threads(long long n);
+
+/**
+ * Function: bitonic_omp_tile
+ * --------------------------
+ * Cache tile bitonic_omp_sort actually uses for n elements (0 = unblocked).
+ */
+int bitonic_omp_tile(int tile, long long n);
+
+#endif
@@ -0,0 +1,504 @@
+#include "bitonic_simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITONIC_HAVE_X86 1
+#else
+#define BITONIC_HAVE_X86 0
+#endif
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+/* Compare-exchange a[t] with b[t] (min to a) for t in [0, len) */
+typedef void (*run_fn)(int *a, int *b, long long len);
+/* Compare-exchange a[t] with b[-t] (min to a) for t in [0, len) */
+typedef void (*mirror_fn)(int *a, int *b, long long len);
+/* Apply stages j_hi, ..., j_lo (all below the vector width) to data[lo, hi) */
+typedef void (*block_fn)(int *data, long long lo, long long hi, long long k, long long j_hi, long long j_lo);
+
+/**
+ * Function: cmpx_pair
+ * -------------------
+ * Scalar compare-exchange of comparator pair p in stage (k, j) of an
+ * n-element array. Used for the unaligned edges of a pair range.
+ */
+static ALWAYS_INLINE void cmpx_pair(int *data, long long n, long long k, long long j, long long p)
+{
+    long long base = (p / j) * 2 * j;
+    long long i = base + p % j;
+    long long partner = (2 * j == k) ? base + 2 * j - 1 - p % j : i + j;
+    if (partner >= n)
+        return;  // Partner is virtual padding (+infinity): nothing moves
+    int x = data[i];
+    int y = data[partner];
+    data[i] = x < y ? x : y;
+    data[partner] = x < y ? y : x;
+}
+
+/**
+ * Function: scalar_stages
+ * -----------------------
+ * Applies stages j_hi, ..., j_lo to data[lo, hi) one comparator at a time.
+ * lo must be a multiple of 2 * j_hi; hi is a multiple of 2 * j_hi or the end
+ * of the array, and comparators reaching past it are skipped.
+ */
+static void scalar_stages(int *data, long long lo, long long hi, long long k, long long j_hi, long long j_lo)
+{
+    for (long long j = j_hi; j >= j_lo; j >>= 1)
+    {
+        for (long long base = lo; base < hi; base += 2 * j)
+        {
+            if (2 * j == k)
+            {
+                long long first = base + 2 * j - hi;  // Lowest offset whose mirror is in range
+                for (long long t = (first > 0) ? first : 0; t < j; ++t)
+                {
+                    int *a = data + base + t;
+                    int *b = data + base + 2 * j - 1 - t;
+                    int x = *a, y = *b;
+                    *a = x < y ? x : y;
+                    *b = x < y ? y : x;
+                }
+            }
+            else
+            {
+                for (long long t = base; t < base + j && t + j < hi; ++t)
+                {
+                    int x = data[t];
+                    int y = data[t + j];
+                    data[t] = x < y ? x : y;
+                    data[t + j] = x < y ? y : x;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Function: scalar_run
+ * --------------------
+ * Branchless min/max over two contiguous runs; simple enough for the
+ * compiler to auto-vectorize.
+ */
+static void scalar_run(int *a, int *b, long long len)
+{
+    for (long long t = 0; t < len; ++t)
+    {
+        int x = a[t];
+        int y = b[t];
+        a[t] = x < y ? x : y;
+        b[t] = x < y ? y : x;
+    }
+}
+
+/**
+ * Function: scalar_mirror_run
+ * ---------------------------
+ * Like scalar_run, but the partners of a[0, len) run downwards from b[0].
+ */
+static void scalar_mirror_run(int *a, int *b, long long len)
+{
+    for (long long t = 0; t < len; ++t)
+    {
+        int x = a[t];
+        int y = b[-t];
+        a[t] = x < y ? x : y;
+        b[-t] = x < y ? y : x;
+    }
+}
+
+/**
+ * Function: stage_impl
+ * --------------------
+ * Shared driver for one (k, j) stage over comparator pairs [pair_lo, pair_hi).
+ * Always inlined into each ISA wrapper so run/mirror/block become direct
+ * calls. Pairs whose partner lies at or past n are skipped.
+ */
+static ALWAYS_INLINE void stage_impl(int *data, long long n, long long k, long long j, long long pair_lo,
+                                     long long pair_hi, int width, run_fn run, mirror_fn mirror, block_fn block)
+{
+    long long p = pair_lo;
+
+    if (j >= width)
+    {
+        // Pairs form runs of length j inside each 2j block starting at 'base'
+        while (p < pair_hi)
+        {
+            long long off = p % j;
+            long long len = j - off;
+            if (len > pair_hi - p)
+                len = pair_hi - p;
+            long long base = (p / j) * 2 * j;
+
+            if (2 * j == k)
+            {
+                // Mirror stage: offsets below 'first' have partners past n
+                long long first = base + 2 * j - n;
+                if (first >= j)
+                    break;  // Upper half of this and every later block is padding
+                if (off < first)
+                {
+                    long long skip = first - off;
+                    if (skip >= len)
+                    {
+                        p += len;
+                        continue;
+                    }
+                    p += skip;
+                    off += skip;
+                    len -= skip;
+                }
+                mirror(data + base + off, data + base + 2 * j - 1 - off, len);
+            }
+            else
+            {
+                // Only offsets below n - base - j have partners in range
+                long long valid = n - base - j;
+                if (valid <= off)
+                    break;
+                if (len > valid - off)
+                    len = valid - off;
+                run(data + base + off, data + base + off + j, len);
+            }
+            p += len;
+        }
+        return;
+    }
+
+    // Small j: each vector of 'width' elements holds width/2 complete pairs
+    long long half = width / 2;
+    while (p < pair_hi && p % half != 0)
+    {
+        cmpx_pair(data, n, k, j, p++);
+    }
+    long long vec_end = p + (pair_hi - p) / half * half;
+    if (vec_end > p)
+    {
+        long long hi = (2 * vec_end < n) ? 2 * vec_end : n;
+        if (2 * p < hi)
+            block(data, 2 * p, hi, k, j, j);
+        p = vec_end;
+    }
+    while (p < pair_hi)
+    {
+        cmpx_pair(data, n, k, j, p++);
+    }
+}
+
+/**
+ * Function: tail_impl
+ * -------------------
+ * Shared driver for stages j, ..., 1 of merge step k over data[lo, hi).
+ */
+static ALWAYS_INLINE void tail_impl(int *data, long long k, long long j, long long lo, long long hi,
+                                    int width, run_fn run, mirror_fn mirror, block_fn block)
+{
+    for (; j >= width && j > 0; j >>= 1)
+    {
+        for (long long base = lo; base < hi; base += 2 * j)
+        {
+            if (2 * j == k)
+            {
+                long long first = base + 2 * j - hi;
+                if (first < 0)
+                    first = 0;
+                if (first < j)
+                    mirror(data + base + first, data + base + 2 * j - 1 - first, j - first);
+            }
+            else
+            {
+                long long len = hi - base - j;
+                if (len > j)
+                    len = j;
+                if (len > 0)
+                    run(data + base, data + base + j, len);
+            }
+        }
+    }
+    if (j > 0)
+    {
+        block(data, lo, hi, k, j, 1);
+    }
+}
+
+static void scalar_stage(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi)
+{
+    stage_impl(data, n, k, j, pair_lo, pair_hi, 1, scalar_run, scalar_mirror_run, scalar_stages);
+}
+
+static void scalar_tail(int *data, long long k, long long j, long long lo, long long hi)
+{
+    tail_impl(data, k, j, lo, hi, 1, scalar_run, scalar_mirror_run, scalar_stages);
+}
+
+#if BITONIC_HAVE_X86
+
+/* ---------------------------------------------------------------- AVX2 */
+
+__attribute__((target("avx2")))
+static void avx2_run(int *a, int *b, long long len)
+{
+    long long t = 0;
+    for (; t + 8 <= len; t += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + t));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + t));
+        _mm256_storeu_si256((__m256i *)(a + t), _mm256_min_epi32(x, y));
+        _mm256_storeu_si256((__m256i *)(b + t), _mm256_max_epi32(x, y));
+    }
+    if (t < len)
+    {
+        scalar_run(a + t, b + t, len - t);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_mirror_run(int *a, int *b, long long len)
+{
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    long long t = 0;
+    for (; t + 8 <= len; t += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + t));
+        __m256i y = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(b - t - 7)), reverse);
+        __m256i mx = _mm256_max_epi32(x, y);
+        _mm256_storeu_si256((__m256i *)(a + t), _mm256_min_epi32(x, y));
+        _mm256_storeu_si256((__m256i *)(b - t - 7), _mm256_permutevar8x32_epi32(mx, reverse));
+    }
+    if (t < len)
+    {
+        scalar_mirror_run(a + t, b - t, len - t);
+    }
+}
+
+/**
+ * Function: avx2_block
+ * --------------------
+ * In-register network for j < 8: the partner of lane l is lane l ^ j (or
+ * l ^ (2j - 1) in the mirror stage), so a lane permute, one min, one max and
+ * a blend finish a whole stage per vector.
+ */
+__attribute__((target("avx2")))
+static void avx2_block(int *data, long long lo, long long hi, long long k, long long j_hi, long long j_lo)
+{
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    long long head = (lo + 7) & ~7;
+    if (head > hi)
+        head = hi;
+    if (head > lo)
+        scalar_stages(data, lo, head, k, j_hi, j_lo);
+
+    long long base = head;
+    for (; base + 8 <= hi; base += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + base));
+        for (long long j = j_hi; j >= j_lo; j >>= 1)
+        {
+            __m256i jvec = _mm256_set1_epi32((int)j);
+            __m256i pvec = _mm256_set1_epi32((int)((2 * j == k) ? 2 * j - 1 : j));
+            __m256i partner = _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(lane, pvec));
+            __m256i mn = _mm256_min_epi32(v, partner);
+            __m256i mx = _mm256_max_epi32(v, partner);
+            // The lower lane of every pair takes the min
+            __m256i lower = _mm256_cmpeq_epi32(_mm256_and_si256(lane, jvec), zero);
+            v = _mm256_blendv_epi8(mx, mn, lower);
+        }
+        _mm256_storeu_si256((__m256i *)(data + base), v);
+    }
+
+    if (base < hi)
+        scalar_stages(data, base, hi, k, j_hi, j_lo);
+}
+
+__attribute__((target("avx2")))
+static void avx2_stage(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi)
+{
+    stage_impl(data, n, k, j, pair_lo, pair_hi, 8, avx2_run, avx2_mirror_run, avx2_block);
+}
+
+__attribute__((target("avx2")))
+static void avx2_tail(int *data, long long k, long long j, long long lo, long long hi)
+{
+    tail_impl(data, k, j, lo, hi, 8, avx2_run, avx2_mirror_run, avx2_block);
+}
+
+/* ------------------------------------------------------------- AVX-512 */
+
+__attribute__((target("avx512f")))
+static void avx512_run(int *a, int *b, long long len)
+{
+    long long t = 0;
+    for (; t + 16 <= len; t += 16)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + t));
+        __m512i y = _mm512_loadu_si512((const void *)(b + t));
+        _mm512_storeu_si512((void *)(a + t), _mm512_min_epi32(x, y));
+        _mm512_storeu_si512((void *)(b + t), _mm512_max_epi32(x, y));
+    }
+    if (t < len)
+    {
+        scalar_run(a + t, b + t, len - t);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_mirror_run(int *a, int *b, long long len)
+{
+    const __m512i reverse = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                              7, 6, 5, 4, 3, 2, 1, 0);
+    long long t = 0;
+    for (; t + 16 <= len; t += 16)
+    {
+        __m512i x = _mm512_loadu_si512((const void *)(a + t));
+        __m512i y = _mm512_permutexvar_epi32(reverse, _mm512_loadu_si512((const void *)(b - t - 15)));
+        __m512i mx = _mm512_max_epi32(x, y);
+        _mm512_storeu_si512((void *)(a + t), _mm512_min_epi32(x, y));
+        _mm512_storeu_si512((void *)(b - t - 15), _mm512_permutexvar_epi32(reverse, mx));
+    }
+    if (t < len)
+    {
+        scalar_mirror_run(a + t, b - t, len - t);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void avx512_block(int *data, long long lo, long long hi, long long k, long long j_hi, long long j_lo)
+{
+    const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                           8, 9, 10, 11, 12, 13, 14, 15);
+
+    long long head = (lo + 15) & ~15;
+    if (head > hi)
+        head = hi;
+    if (head > lo)
+        scalar_stages(data, lo, head, k, j_hi, j_lo);
+
+    long long base = head;
+    for (; base + 16 <= hi; base += 16)
+    {
+        __m512i v = _mm512_loadu_si512((const void *)(data + base));
+        for (long long j = j_hi; j >= j_lo; j >>= 1)
+        {
+            __m512i pvec = _mm512_set1_epi32((int)((2 * j == k) ? 2 * j - 1 : j));
+            __m512i partner = _mm512_permutexvar_epi32(_mm512_xor_si512(lane, pvec), v);
+            __m512i mn = _mm512_min_epi32(v, partner);
+            __m512i mx = _mm512_max_epi32(v, partner);
+            __mmask16 upper = _mm512_test_epi32_mask(lane, _mm512_set1_epi32((int)j));
+            v = _mm512_mask_blend_epi32(upper, mn, mx);
+        }
+        _mm512_storeu_si512((void *)(data + base), v);
+    }
+
+    if (base < hi)
+        scalar_stages(data, base, hi, k, j_hi, j_lo);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_stage(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi)
+{
+    stage_impl(data, n, k, j, pair_lo, pair_hi, 16, avx512_run, avx512_mirror_run, avx512_block);
+}
+
+__attribute__((target("avx512f")))
+static void avx512_tail(int *data, long long k, long long j, long long lo, long long hi)
+{
+    tail_impl(data, k, j, lo, hi, 16, avx512_run, avx512_mirror_run, avx512_block);
+}
+
+#endif /* BITONIC_HAVE_X86 */
+
+/* ------------------------------------------------------------ dispatch */
+
+typedef struct
+{
+    const char *name;
+    int width;
+    void (*stage)(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi);
+    void (*tail)(int *data, long long k, long long j, long long lo, long long hi);
+} simd_ops;
+
+static const simd_ops scalar_ops = {"scalar", 1, scalar_stage, scalar_tail};
+#if BITONIC_HAVE_X86
+static const simd_ops avx2_ops = {"avx2", 8, avx2_stage, avx2_tail};
+static const simd_ops avx512_ops = {"avx512", 16, avx512_stage, avx512_tail};
+#endif
+
+/**
+ * Function: select_ops
+ * --------------------
+ * Picks the widest implementation the CPU supports, optionally capped by the
+ * BITONIC_SIMD environment variable. The result is cached after the first
+ * call; concurrent first calls all compute the same answer.
+ */
+static const simd_ops *select_ops(void)
+{
+    static const simd_ops *selected = NULL;
+    if (selected)
+        return selected;
+
+    const simd_ops *ops = &scalar_ops;
+#if BITONIC_HAVE_X86
+    const char *cap = getenv("BITONIC_SIMD");
+    int allow_avx512 = !cap || strcmp(cap, "avx512") == 0;
+    int allow_avx2 = allow_avx512 || strcmp(cap, "avx2") == 0;
+
+    __builtin_cpu_init();
+    if (allow_avx512 && __builtin_cpu_supports("avx512f"))
+        ops = &avx512_ops;
+    else if (allow_avx2 && __builtin_cpu_supports("avx2"))
+        ops = &avx2_ops;
+#endif
+
+    selected = ops;
+    return selected;
+}
+
+void bitonic_simd_stage(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi)
+{
+    select_ops()->stage(data, n, k, j, pair_lo, pair_hi);
+}
+
+void bitonic_simd_merge_tail(int *data, long long k, long long j, long long lo, long long hi)
+{
+    select_ops()->tail(data, k, j, lo, hi);
+}
+
+void bitonic_simd_sort(int *data, long long n)
+{
+    const simd_ops *ops = select_ops();
+    // k runs up to the power of 2 covering n
+    for (long long k = 2; (k >> 1) < n; k <<= 1)
+    {
+        ops->tail(data, k, k >> 1, 0, n);
+    }
+}
+
+void bitonic_simd_merge_low(int *data, long long half)
+{
+    const simd_ops *ops = select_ops();
+    // Mirror stage of merge step 2 * half: the smaller of each pair lands below
+    ops->stage(data, 2 * half, 2 * half, half, 0, half);
+    // The lower half is now bitonic; the remaining stages sort it
+    ops->tail(data, 2 * half, half >> 1, 0, half);
+}
+
+long long bitonic_simd_stage_pairs(long long n, long long j)
+{
+    long long rem = n % (2 * j);
+    return (n / (2 * j)) * j + (rem < j ? rem : j);
+}
+
+int bitonic_simd_width(void)
+{
+    return select_ops()->width;
+}
+
+const char *bitonic_simd_isa(void)
+{
+    return select_ops()->name;
+}
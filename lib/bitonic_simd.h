@@ -0,0 +1,90 @@
+#ifndef BITONIC_SIMD_H
+#define BITONIC_SIMD_H
+
+/**
+ * Vectorized bitonic compare-exchange kernels shared by the Serial and
+ * OpenMP sorters.
+ *
+ * The network is the all-ascending form of bitonic sort: every comparator
+ * puts the minimum at the lower index. Within each 2j block the first stage
+ * of merge step k (j = k/2) compares element i with its mirror i ^ (k - 1),
+ * and every later stage compares i with i + j. The kernels walk the
+ * comparator pairs directly instead of looping over all indices, so no
+ * iteration is wasted on the "ixj > i" test. Pair p has its lower element at
+ * i = (p / j) * 2j + (p % j).
+ *
+ * Arbitrary n: the network runs over the next power of 2 as if the missing
+ * tail held +infinity. Because every comparator is ascending, a comparator
+ * whose upper element lies past the end would never move anything, so it is
+ * simply skipped; no padding is allocated or sorted.
+ *
+ * The implementation is chosen once at runtime: AVX-512, AVX2 or a portable
+ * scalar fallback (which is also used on non-x86 targets).
+ */
+
+/**
+ * Function: bitonic_simd_stage
+ * ----------------------------
+ * Applies one (k, j) stage of an n-element sort to the comparator pairs
+ * [pair_lo, pair_hi) (see bitonic_simd_stage_pairs for the range worth
+ * splitting). Splitting the pair range across threads gives each thread an
+ * independent, race-free slice of the stage.
+ *
+ * Large j: branchless vector min/max over the two contiguous halves.
+ * Small j: in-register permute + min/max network within each vector.
+ */
+void bitonic_simd_stage(int *data, long long n, long long k, long long j, long long pair_lo, long long pair_hi);
+
+/**
+ * Function: bitonic_simd_stage_pairs
+ * ----------------------------------
+ * Upper bound of the comparator pairs with work in a stage of distance j
+ * for n elements; pairs at or past it only touch the virtual padding.
+ */
+long long bitonic_simd_stage_pairs(long long n, long long j);
+
+/**
+ * Function: bitonic_simd_merge_tail
+ * ---------------------------------
+ * Applies stages j, j/2, ..., 1 of merge step k to data[lo, hi).
+ * lo must be a multiple of 2 * j and hi a multiple of 2 * j or the end of
+ * the array, so that every comparator of these stages stays inside the range
+ * (comparators reaching past the end are skipped). Once j drops below the vector width the
+ * remaining stages run entirely in registers with one load/store per vector.
+ */
+void bitonic_simd_merge_tail(int *data, long long k, long long j, long long lo, long long hi);
+
+/**
+ * Function: bitonic_simd_sort
+ * ---------------------------
+ * Sorts data[0, n) ascending with the full bitonic network (any n).
+ */
+void bitonic_simd_sort(int *data, long long n);
+
+/**
+ * Function: bitonic_simd_merge_low
+ * --------------------------------
+ * Truncated merge: data[0, half) and data[half, 2 * half) are each sorted
+ * ascending ('half' a power of 2); leaves the 'half' smallest values of
+ * both sorted in data[0, half) with one mirror stage and log2(half)
+ * stages over the lower half only. data[half, 2 * half) is clobbered.
+ */
+void bitonic_simd_merge_low(int *data, long long half);
+
+/**
+ * Function: bitonic_simd_width
+ * ----------------------------
+ * Returns the number of int lanes of the selected implementation
+ * (16 for AVX-512, 8 for AVX2, 1 for scalar).
+ */
+int bitonic_simd_width(void);
+
+/**
+ * Function: bitonic_simd_isa
+ * --------------------------
+ * Returns the name of the selected implementation ("avx512", "avx2", "scalar").
+ * Setting BITONIC_SIMD=scalar|avx2|avx512 in the environment caps the choice.
+ */
+const char *bitonic_simd_isa(void);
+
+#endif
@@ -0,0 +1,397 @@
+#define _GNU_SOURCE  // syscall
+#include "bitonic_trace.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Table limits: stages up to k = 2^39, threads and rounds past these are folded */
+#define TRACE_LOG_MAX 40
+#define TRACE_MAX_THREADS 256
+#define TRACE_MAX_ROUNDS 256
+
+#ifndef BITONIC_NO_TRACE
+int bitonic_trace_on;
+#endif
+
+static const char *const phase_names[BITONIC_PHASES] = {"read",     "distribute", "pad",   "sort",
+                                                        "exchange", "gather",     "merge", "write"};
+
+typedef struct
+{
+    double seconds;
+    long long calls;
+    int depth;  // Open begin / end pairs
+    unsigned long long counters[BITONIC_TRACE_EVENTS];
+} trace_phase;
+
+typedef struct
+{
+    double seconds;
+    long long calls;
+    int fused;
+} trace_stage;
+
+typedef struct
+{
+    double busy;
+    double wait;
+    long long stages;
+} trace_thread;
+
+typedef struct
+{
+    int partner;
+    long long calls;
+    double sent;
+    double received;
+    double seconds;
+} trace_round;
+
+static int trace_ready;
+static const char *trace_path;
+static int trace_threads = 1;
+static trace_phase phases[BITONIC_PHASES];
+// stages[log2 k][j ? log2 j + 1 : 0]
+static trace_stage stages[TRACE_LOG_MAX][TRACE_LOG_MAX + 1];
+static trace_thread threads[TRACE_MAX_THREADS];
+static trace_round rounds[TRACE_MAX_ROUNDS];
+static int round_count;
+
+/* Hardware counters: one fd per thread and event (-1 = not open) */
+static const struct
+{
+    const char *name;
+    unsigned long long config;
+} events[BITONIC_TRACE_EVENTS] = {
+#ifdef __linux__
+    {"cycles", PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache_references", PERF_COUNT_HW_CACHE_REFERENCES},
+    {"cache_misses", PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_COUNT_HW_BRANCH_MISSES},
+#else
+    {"cycles", 0}, {"instructions", 0}, {"cache_references", 0}, {"cache_misses", 0}, {"branch_misses", 0},
+#endif
+};
+static int counter_fds[TRACE_MAX_THREADS][BITONIC_TRACE_EVENTS];
+static int counters_open;  // Threads whose counters are open
+static const char *counters_error;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static int log2_floor(unsigned long long x)
+{
+    int l = 0;
+    while (x >>= 1)
+        ++l;
+    return l;
+}
+
+/**
+ * Function: open_counters
+ * -----------------------
+ * Opens the hardware events for the calling thread as team member 'tid'
+ * (user space only, counting while the thread runs on any CPU). Returns 0,
+ * or the errno of the first failure.
+ */
+static int open_counters(int tid)
+{
+#ifdef __linux__
+    for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = events[e].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counter_fds[tid][e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counter_fds[tid][e] < 0)
+        {
+            int error = errno;
+            for (int o = 0; o < BITONIC_TRACE_EVENTS; ++o)
+            {
+                if (o < e)
+                    close(counter_fds[tid][o]);
+                counter_fds[tid][o] = -1;
+            }
+            return error;
+        }
+    }
+    return 0;
+#else
+    (void)tid;
+    return ENOSYS;
+#endif
+}
+
+void bitonic_trace_init(int team)
+{
+    if (trace_ready)
+        return;
+    trace_ready = 1;
+
+    const char *path = getenv("BITONIC_TRACE");
+    if (!path || !*path)
+        return;
+    trace_path = path;
+    trace_threads = (team > 0) ? team : 1;
+
+    const char *counters = getenv("BITONIC_TRACE_COUNTERS");
+    if (counters && atoi(counters) > 0)
+    {
+        int slots = (trace_threads < TRACE_MAX_THREADS) ? trace_threads : TRACE_MAX_THREADS;
+        int failure = 0;
+        for (int t = 0; t < slots; ++t)
+        {
+            for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+                counter_fds[t][e] = -1;
+        }
+        // Each thread of the team opens its own events, as perf counts per thread
+#pragma omp parallel num_threads(slots) proc_bind(close) reduction(max : failure)
+        {
+#ifdef _OPENMP
+            int tid = omp_get_thread_num();
+#else
+            int tid = 0;
+#endif
+            failure = open_counters(tid);
+        }
+        if (failure == 0)
+            counters_open = slots;
+        else
+        {
+            counters_error = strerror(failure);
+            for (int t = 0; t < slots; ++t)
+            {
+                for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+                {
+                    if (counter_fds[t][e] >= 0)
+                        close(counter_fds[t][e]);
+                }
+            }
+        }
+    }
+#ifndef BITONIC_NO_TRACE
+    bitonic_trace_on = 1;
+#endif
+}
+
+static void mark_now(bitonic_trace_mark *mark)
+{
+    memset(mark->counters, 0, sizeof(mark->counters));
+    for (int t = 0; t < counters_open; ++t)
+    {
+        for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+        {
+            unsigned long long value = 0;
+            if (counter_fds[t][e] >= 0 && read(counter_fds[t][e], &value, sizeof(value)) == (ssize_t)sizeof(value))
+                mark->counters[e] += value;
+        }
+    }
+    mark->start = now();
+}
+
+void bitonic_trace_phase_begin(bitonic_phase phase, bitonic_trace_mark *mark)
+{
+    if (phases[phase].depth++ == 0)
+        mark_now(mark);
+}
+
+void bitonic_trace_phase_add(bitonic_phase phase, const bitonic_trace_mark *mark)
+{
+    if (--phases[phase].depth > 0)
+        return;
+    bitonic_trace_mark end;
+    mark_now(&end);
+    phases[phase].seconds += end.start - mark->start;
+    phases[phase].calls++;
+    for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+        phases[phase].counters[e] += end.counters[e] - mark->counters[e];
+}
+
+void bitonic_trace_stage(long long k, long long j, int fused, double seconds)
+{
+    int lk = log2_floor((unsigned long long)k);
+    int lj = j ? log2_floor((unsigned long long)j) + 1 : 0;
+    if (lk >= TRACE_LOG_MAX)
+        return;
+    stages[lk][lj].seconds += seconds;
+    stages[lk][lj].calls++;
+    stages[lk][lj].fused = fused;
+}
+
+void bitonic_trace_thread(int tid, double busy, double wait)
+{
+    trace_thread *slot = &threads[tid % TRACE_MAX_THREADS];
+    slot->busy += busy;
+    slot->wait += wait;
+    slot->stages++;
+}
+
+void bitonic_trace_round(int round, int partner, size_t sent, size_t received, double seconds)
+{
+    if (round >= TRACE_MAX_ROUNDS)
+        round = TRACE_MAX_ROUNDS - 1;
+    trace_round *slot = &rounds[round];
+    slot->partner = partner;
+    slot->calls++;
+    slot->sent += (double)sent;
+    slot->received += (double)received;
+    slot->seconds += seconds;
+    if (round >= round_count)
+        round_count = round + 1;
+}
+
+void bitonic_trace_phase_seconds(double *seconds)
+{
+    for (int p = 0; p < BITONIC_PHASES; ++p)
+        seconds[p] = phases[p].seconds;
+}
+
+double bitonic_trace_bytes_sent(void)
+{
+    double total = 0.0;
+    for (int r = 0; r < round_count; ++r)
+        total += rounds[r].sent;
+    return total;
+}
+
+/* max / mean of values[0, count) (1 when all are zero) */
+static double imbalance(const double *values, int count, int stride)
+{
+    double max = 0.0, sum = 0.0;
+    for (int i = 0; i < count; ++i)
+    {
+        double v = values[(size_t)i * stride];
+        sum += v;
+        if (v > max)
+            max = v;
+    }
+    return (sum > 0.0) ? max * count / sum : 1.0;
+}
+
+int bitonic_trace_report(const char *program, int ranks, const double *rank_seconds, const double *rank_bytes)
+{
+    if (!bitonic_trace_on || !trace_path)
+        return -1;
+    FILE *f = (strcmp(trace_path, "-") == 0) ? stderr : fopen(trace_path, "w");
+    if (!f)
+    {
+        perror(trace_path);
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"program\": \"%s\",\n  \"ranks\": %d,\n  \"threads\": %d,\n", program, ranks, trace_threads);
+
+    // Counters
+    fprintf(f, "  \"counters\": {\"enabled\": %s", counters_open ? "true" : "false");
+    if (counters_error)
+        fprintf(f, ", \"error\": \"%s\"", counters_error);
+    fprintf(f, ", \"events\": [");
+    for (int e = 0; e < BITONIC_TRACE_EVENTS; ++e)
+        fprintf(f, "%s\"%s\"", e ? ", " : "", events[e].name);
+    fprintf(f, "]},\n");
+
+    // Phases of this process (rank 0)
+    fprintf(f, "  \"phases\": [");
+    for (int p = 0, first = 1; p < BITONIC_PHASES; ++p)
+    {
+        if (phases[p].calls == 0)
+            continue;
+        fprintf(f, "%s\n    {\"phase\": \"%s\", \"calls\": %lld, \"seconds\": %.9f", first ? "" : ",", phase_names[p],
+                phases[p].calls, phases[p].seconds);
+        for (int e = 0; counters_open && e < BITONIC_TRACE_EVENTS; ++e)
+            fprintf(f, ", \"%s\": %llu", events[e].name, phases[p].counters[e]);
+        fprintf(f, "}");
+        first = 0;
+    }
+    fprintf(f, "\n  ],\n");
+
+    // Per-rank phase times and their imbalance (max / mean)
+    if (rank_seconds)
+    {
+        fprintf(f, "  \"per_rank\": {");
+        for (int p = 0; p < BITONIC_PHASES; ++p)
+        {
+            fprintf(f, "%s\n    \"%s\": {\"imbalance\": %.4f, \"seconds\": [", p ? "," : "", phase_names[p],
+                    imbalance(rank_seconds + p, ranks, BITONIC_PHASES));
+            for (int r = 0; r < ranks; ++r)
+                fprintf(f, "%s%.9f", r ? ", " : "", rank_seconds[(size_t)r * BITONIC_PHASES + p]);
+            fprintf(f, "]}");
+        }
+        if (rank_bytes)
+        {
+            fprintf(f, ",\n    \"bytes_sent\": {\"imbalance\": %.4f, \"bytes\": [", imbalance(rank_bytes, ranks, 1));
+            for (int r = 0; r < ranks; ++r)
+                fprintf(f, "%s%.0f", r ? ", " : "", rank_bytes[r]);
+            fprintf(f, "]}");
+        }
+        fprintf(f, "\n  },\n");
+    }
+
+    // Network stages in execution order
+    fprintf(f, "  \"stages\": [");
+    for (int lk = 0, first = 1; lk < TRACE_LOG_MAX; ++lk)
+    {
+        for (int lj = TRACE_LOG_MAX; lj >= 0; --lj)
+        {
+            const trace_stage *s = &stages[lk][lj];
+            if (s->calls == 0)
+                continue;
+            fprintf(f, "%s\n    {\"k\": %llu, \"j\": %llu, \"fused\": %s, \"calls\": %lld, \"seconds\": %.9f}",
+                    first ? "" : ",", 1ULL << lk, lj ? 1ULL << (lj - 1) : 0ULL, s->fused ? "true" : "false",
+                    s->calls, s->seconds);
+            first = 0;
+        }
+    }
+    fprintf(f, "\n  ],\n");
+
+    // Per-thread busy / barrier-wait time over all traced stages
+    int team = 0;
+    double busy[TRACE_MAX_THREADS];
+    for (int t = 0; t < TRACE_MAX_THREADS; ++t)
+    {
+        busy[t] = threads[t].busy;
+        if (threads[t].stages > 0)
+            team = t + 1;
+    }
+    fprintf(f, "  \"thread_imbalance\": %.4f,\n  \"threads_detail\": [", imbalance(busy, team, 1));
+    for (int t = 0; t < team; ++t)
+        fprintf(f, "%s\n    {\"thread\": %d, \"stages\": %lld, \"busy_s\": %.9f, \"wait_s\": %.9f}", t ? "," : "", t,
+                threads[t].stages, threads[t].busy, threads[t].wait);
+    fprintf(f, "\n  ],\n");
+
+    // Compare-split rounds of this process
+    fprintf(f, "  \"rounds\": [");
+    for (int r = 0; r < round_count; ++r)
+        fprintf(f,
+                "%s\n    {\"round\": %d, \"partner\": %d, \"calls\": %lld, \"bytes_sent\": %.0f, "
+                "\"bytes_received\": %.0f, \"seconds\": %.9f}",
+                r ? "," : "", r, rounds[r].partner, rounds[r].calls, rounds[r].sent, rounds[r].received,
+                rounds[r].seconds);
+    fprintf(f, "\n  ]\n}\n");
+
+    if (f != stderr)
+        fclose(f);
+    return 0;
+}
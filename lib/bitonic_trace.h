@@ -0,0 +1,132 @@
+#ifndef BITONIC_TRACE_H
+#define BITONIC_TRACE_H
+
+#include <stddef.h>
+
+/**
+ * Hot-path instrumentation: where a sort spends its time.
+ *
+ * Enabled at run time with BITONIC_TRACE=<path> ("-" = stderr). A run then
+ * records:
+ * - wall time, calls and (optionally) hardware counters per phase: read,
+ *   distribute, pad, sort, exchange, gather, merge, write
+ * - per (k, j) stage of the OpenMP network: wall time of the stage, and per
+ *   thread the time spent working vs waiting at the stage barriers
+ * - per MPI compare-split round: partner, bytes sent and received, time
+ * and bitonic_trace_report writes them as one JSON document; the MPI
+ * program adds every rank's phase times (bitonic_dist_trace_report).
+ *
+ * BITONIC_TRACE_COUNTERS=1 also opens cycles, instructions, cache
+ * references / misses and branch misses through perf_event_open for each
+ * thread of the first context's team (Linux; reported as unavailable where
+ * the kernel or perf_event_paranoid refuses them).
+ *
+ * Disabled, every hook is one predictable branch on bitonic_trace_on per
+ * phase or stage, never per element; building with -DBITONIC_NO_TRACE
+ * turns the flag into the constant 0 so the hooks compile away entirely.
+ */
+
+typedef enum
+{
+    BITONIC_PHASE_READ,        // Input parsing / loading
+    BITONIC_PHASE_DISTRIBUTE,  // Count broadcast and scatter to the ranks
+    BITONIC_PHASE_PAD,         // Padding short blocks
+    BITONIC_PHASE_SORT,        // In-memory sorts (any engine)
+    BITONIC_PHASE_EXCHANGE,    // Compare-split rounds between ranks
+    BITONIC_PHASE_GATHER,      // Gather of the sorted blocks to rank 0
+    BITONIC_PHASE_MERGE,       // Rank-0 merge of the gathered blocks
+    BITONIC_PHASE_WRITE,       // Output formatting and writing
+    BITONIC_PHASES
+} bitonic_phase;
+
+/* Hardware events counted with BITONIC_TRACE_COUNTERS=1 */
+#define BITONIC_TRACE_EVENTS 5
+
+/**
+ * Structure: bitonic_trace_mark
+ * -----------------------------
+ * Start of a traced interval: time and counter readings.
+ */
+typedef struct
+{
+    double start;
+    unsigned long long counters[BITONIC_TRACE_EVENTS];
+} bitonic_trace_mark;
+
+#ifdef BITONIC_NO_TRACE
+#define bitonic_trace_on 0
+#else
+extern int bitonic_trace_on;
+#endif
+
+/**
+ * Function: bitonic_trace_init
+ * ----------------------------
+ * Reads BITONIC_TRACE / BITONIC_TRACE_COUNTERS and opens the counters for
+ * a team of 'threads' threads. Called by bitonic_context_create; only the
+ * first call has an effect.
+ */
+void bitonic_trace_init(int threads);
+
+/**
+ * Function: bitonic_trace_begin / bitonic_trace_end
+ * -------------------------------------------------
+ * Bracket a phase on the calling (master) thread: bitonic_trace_end adds
+ * the time and counter deltas since the matching begin to 'phase'. A phase
+ * nested in one of the same kind (a library sort inside a traced sort) is
+ * only counted by the outermost pair.
+ */
+void bitonic_trace_phase_begin(bitonic_phase phase, bitonic_trace_mark *mark);
+void bitonic_trace_phase_add(bitonic_phase phase, const bitonic_trace_mark *mark);
+
+static inline void bitonic_trace_begin(bitonic_phase phase, bitonic_trace_mark *mark)
+{
+    if (bitonic_trace_on)
+        bitonic_trace_phase_begin(phase, mark);
+}
+
+static inline void bitonic_trace_end(bitonic_phase phase, const bitonic_trace_mark *mark)
+{
+    if (bitonic_trace_on)
+        bitonic_trace_phase_add(phase, mark);
+}
+
+/**
+ * Function: bitonic_trace_stage / bitonic_trace_thread
+ * ----------------------------------------------------
+ * Network stage (k, j) took 'seconds' of wall time (j = 0: the fused
+ * in-tile sort of k-element tiles; fused: stages j .. 1 ran as one pass);
+ * reported by thread 0 only. bitonic_trace_thread adds one stage of thread
+ * tid: time working and time waiting at the barrier.
+ */
+void bitonic_trace_stage(long long k, long long j, int fused, double seconds);
+void bitonic_trace_thread(int tid, double busy, double wait);
+
+/**
+ * Function: bitonic_trace_round
+ * -----------------------------
+ * Compare-split round 'round' (0-based, in network order) with 'partner'
+ * moved the given bytes and took 'seconds'.
+ */
+void bitonic_trace_round(int round, int partner, size_t sent, size_t received, double seconds);
+
+/**
+ * Function: bitonic_trace_phase_seconds / bitonic_trace_bytes_sent
+ * ----------------------------------------------------------------
+ * This process' totals: seconds[BITONIC_PHASES] per phase, and bytes sent
+ * over all rounds (for gathering the per-rank view).
+ */
+void bitonic_trace_phase_seconds(double *seconds);
+double bitonic_trace_bytes_sent(void);
+
+/**
+ * Function: bitonic_trace_report
+ * ------------------------------
+ * Writes the JSON report to the BITONIC_TRACE path. rank_seconds holds
+ * ranks x BITONIC_PHASES phase times and rank_bytes the bytes each rank
+ * sent (both NULL for a single process). Returns 0, or -1 if tracing is
+ * off or the file cannot be written.
+ */
+int bitonic_trace_report(const char *program, int ranks, const double *rank_seconds, const double *rank_bytes);
+
+#endif
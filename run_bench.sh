@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Builds and runs the benchmark harness; arguments are passed through, e.g.
+#   bash run_bench.sh --sizes=10-26 --engines=all --threads=1,2,4,8 --format=json
+# Results go to OutputFiles/bench.csv (or .json); plot them with
+#   python3 graph/plot_comparison.py OutputFiles/bench.csv
+EXE=Bench/bitonic_bench
+
+echo "Building benchmark..."
+CC=${CC:-cc}
+OMP_FLAGS=${OMP_FLAGS:--fopenmp}
+CC="$CC" OMP_FLAGS="$OMP_FLAGS" bash build_lib.sh
+"$CC" -O2 -std=c11 $OMP_FLAGS Bench/bitonic_bench.c build/libbitonic.a -lm -o "$EXE"
+
+# Pin the persistent thread teams as the OpenMP script does
+export OMP_PLACES=${OMP_PLACES:-cores}
+
+"$EXE" "$@"
@@ -5,19 +5,41 @@ INPUT=${1:-InputFiles/input.txt}
 EXE=MPI/bitonic_mpi
 RESULTS=OutputFiles/mpi_times.txt
 MPI_RUN_OPTS=${MPI_RUN_OPTS:---oversubscribe}
+PROCS=${PROCS:-"1 2 4 8 16"}
+# Setting THREADS (e.g. THREADS="1 2 4 8") sweeps ranks x threads in --hybrid mode
+THREADS=${THREADS:-}
 
 mkdir -p OutputFiles
 
 echo "Building MPI version..."
-mpicc -O2 -std=c11 MPI/bitonic_mpi.c -o "$EXE"
+CC=mpicc OMP_FLAGS=-fopenmp bash build_lib.sh
+mpicc -O2 -std=c11 -fopenmp MPI/bitonic_mpi.c build/libbitonic_mpi.a build/libbitonic.a -o "$EXE"
 
 echo "Input file: $INPUT" > "$RESULTS"
-for p in 1 2 4 8 16; do
-    echo "Running with $p process(es)..."
-    run_output=$(mpirun $MPI_RUN_OPTS -np "$p" "$EXE" "$INPUT")
-    echo "$run_output"
-    exec_time=$(echo "$run_output" | awk '/Execution time/ {print $4}')
-    echo "$p $exec_time" >> "$RESULTS"
-done
+if [ -z "$THREADS" ]; then
+    for p in $PROCS; do
+        echo "Running with $p process(es)..."
+        run_output=$(mpirun $MPI_RUN_OPTS -np "$p" "$EXE" "$INPUT")
+        echo "$run_output"
+        exec_time=$(echo "$run_output" | awk '/Execution time/ {print $4}')
+        echo "$p $exec_time" >> "$RESULTS"
+    done
+else
+    # Place one rank per socket or node via HYBRID_MAP_OPTS, e.g.
+    # "--map-by ppr:1:socket:pe=8"; by default ranks are left unbound so each
+    # OpenMP team can spread over its node
+    HYBRID_MAP_OPTS=${HYBRID_MAP_OPTS:---bind-to none}
+    echo "# processes threads seconds" >> "$RESULTS"
+    for p in $PROCS; do
+        for t in $THREADS; do
+            echo "Running with $p process(es) x $t thread(s)..."
+            run_output=$(mpirun $MPI_RUN_OPTS $HYBRID_MAP_OPTS -x OMP_NUM_THREADS="$t" \
+                -np "$p" "$EXE" "$INPUT" --hybrid)
+            echo "$run_output"
+            exec_time=$(echo "$run_output" | awk '/Execution time/ {print $4}')
+            echo "$p $t $exec_time" >> "$RESULTS"
+        done
+    done
+fi
 
 echo "Execution times saved to $RESULTS"
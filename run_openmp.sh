@@ -10,7 +10,11 @@ mkdir -p OutputFiles
 echo "Building OpenMP version..."
 CC=${CC:-clang}
 OMP_FLAGS="-Xpreprocessor -fopenmp -I/opt/homebrew/opt/libomp/include -L/opt/homebrew/opt/libomp/lib -lomp"
-"$CC" -O2 -std=c11 $OMP_FLAGS OpenMP/bitonic_openmp.c -o "$EXE"
+CC="$CC" OMP_FLAGS="$OMP_FLAGS" bash build_lib.sh
+"$CC" -O2 -std=c11 $OMP_FLAGS OpenMP/bitonic_openmp.c build/libbitonic.a -o "$EXE"
+
+# Pin the persistent thread team (bitonic_omp_sort uses proc_bind(close))
+export OMP_PLACES=${OMP_PLACES:-cores}
 
 echo "Input file: $INPUT" > "$RESULTS"
 for t in 1 2 4 8 16; do
@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Large-count checks (docs/RUN.md, "Sizes"); run from the repository root:
+#   bash tests/large_count.sh
+# 1. Sorts COUNT int32 values (default 2^31 + 2^20, past the 32-bit
+#    boundary) from a binary file with the OpenMP program and verifies the
+#    output is sorted and a permutation of the input. In memory this needs
+#    about 8 x COUNT bytes of RAM; MEMORY=SIZE (e.g. MEMORY=2G) sorts out of
+#    core with --memory instead. Either way TEST_DIR needs about
+#    12 x COUNT bytes of disk.
+# 2. Rebuilds the MPI program with the large-count limits lowered
+#    (DIST_INT_LIMIT, DIST_PIECE_BYTES, MPIIO_VALUE_PIECE in
+#    lib/bitonic_dist.c), so the piecewise scatter / gather, sample-sort
+#    redistribution, typed compare-splits, top-k lists and multi-round
+#    MPI-IO all run on MPI_COUNT values, and compares every mode with the
+#    OpenMP result.
+# SKIP_LARGE=1 or SKIP_MPI=1 skips a part. NP lists the process counts
+# (default "1 3 4"; modes that need the exchange network skip 3).
+TEST_DIR=${TEST_DIR:-build/tests}
+COUNT=${COUNT:-2148532224}
+MEMORY=${MEMORY:-}
+MPI_COUNT=${MPI_COUNT:-100003}
+NP=${NP:-"1 3 4"}
+MPI_RUN_OPTS=${MPI_RUN_OPTS:---oversubscribe}
+SKIP_LARGE=${SKIP_LARGE:-0}
+SKIP_MPI=${SKIP_MPI:-0}
+CC=${CC:-cc}
+OMP_FLAGS=${OMP_FLAGS:--fopenmp}
+LOW_LIMITS="-DDIST_INT_LIMIT=1000 -DDIST_PIECE_BYTES=4000 -DMPIIO_VALUE_PIECE=333"
+
+echo "Building..."
+CC="$CC" OMP_FLAGS="$OMP_FLAGS" bash build_lib.sh
+mkdir -p "$TEST_DIR/OutputFiles"
+ROOT=$(pwd)
+DIR=$(cd "$TEST_DIR" && pwd)
+"$CC" -O2 -std=c11 $OMP_FLAGS OpenMP/bitonic_openmp.c build/libbitonic.a -o "$DIR/bitonic_openmp"
+"$CC" -O2 -std=c11 $OMP_FLAGS tests/large_count_check.c build/libbitonic.a -o "$DIR/large_count_check"
+
+# Programs write OutputFiles/ under the working directory
+cd "$DIR"
+failed=0
+
+if [ "$SKIP_LARGE" != 1 ]; then
+    echo "== $COUNT values${MEMORY:+ (--memory=$MEMORY)}"
+    ./large_count_check gen large.bin "$COUNT"
+    ./bitonic_openmp large.bin --output=binary ${MEMORY:+--memory=$MEMORY}
+    ./large_count_check verify large.bin OutputFiles/openmp_output.bin || failed=1
+    rm -f large.bin OutputFiles/openmp_output.bin
+fi
+
+if [ "$SKIP_MPI" != 1 ]; then
+    echo "== MPI large-count paths on $MPI_COUNT values ($LOW_LIMITS)"
+    mpicc -O2 -std=c11 -fopenmp $LOW_LIMITS "$ROOT/MPI/bitonic_mpi.c" "$ROOT/lib/bitonic_dist.c" \
+        "$ROOT/build/libbitonic.a" -o bitonic_mpi_low_limits
+    ./large_count_check gen small.bin "$MPI_COUNT" 7
+    ./large_count_check gen small.txt "$MPI_COUNT" 7  # Same values; int64 keys read text
+    ./bitonic_openmp small.bin --output=text > /dev/null
+    tr -s ' \n' '\n\n' < OutputFiles/openmp_output.txt > expected.txt
+
+    for np in $NP; do
+        pow2=$(( (np & (np - 1)) == 0 ))
+        for mode in "" "--hybrid" "--rank0-merge" "--key=int64" "--mpi-io" "--sample-sort" \
+            "--mpi-io --sample-sort" "--top-k=1000" "--top-k=2345"; do
+            case "$mode" in
+            *sample-sort* | *top-k*) ;;
+            *) [ "$pow2" = 1 ] || continue ;;
+            esac
+            rm -f OutputFiles/mpi_output.txt
+            k=$(echo "$mode" | sed -n 's/.*--top-k=\([0-9]*\).*/\1/p')
+            input=small.bin
+            [ "$mode" != "--key=int64" ] || input=small.txt
+            if mpirun $MPI_RUN_OPTS -np "$np" ./bitonic_mpi_low_limits $input --output=text $mode > run.log 2>&1 &&
+                tr -s ' \n' '\n\n' < OutputFiles/mpi_output.txt | cmp -s - <(head -n "${k:-$MPI_COUNT}" expected.txt); then
+                echo "ok    np=$np $mode"
+            else
+                echo "FAIL  np=$np $mode"
+                tail -n 5 run.log
+                failed=1
+            fi
+        done
+    done
+    rm -f small.bin small.txt expected.txt run.log
+fi
+
+if [ "$failed" = 0 ]; then
+    echo "All large-count checks passed"
+else
+    echo "Large-count checks FAILED"
+fi
+exit "$failed"
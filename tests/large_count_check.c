@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "../lib/bitonic_io.h"
+
+/* Values per buffered read or write */
+#define CHECK_BLOCK ((size_t)1 << 20)
+
+/**
+ * Function: mix64
+ * ---------------
+ * splitmix64 finalizer: value i of a generated file depends only on the
+ * seed and i, and the multiset fingerprint hashes every value with it.
+ */
+static uint64_t mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Function: generate
+ * ------------------
+ * Writes 'count' pseudo-random int32 values over the whole int range, one
+ * block at a time: as text if path ends in ".txt", else as a binary file
+ * (lib/bitonic_io.h). The same seed gives the same values in both.
+ */
+static int generate(const char *path, unsigned long long count, unsigned long long seed)
+{
+    FILE *f = fopen(path, "wb");
+    int *block = malloc(CHECK_BLOCK * sizeof(int));
+    if (!f || !block)
+    {
+        perror(path);
+        free(block);
+        if (f)
+            fclose(f);
+        return -1;
+    }
+
+    size_t length = strlen(path);
+    int text = (length > 4 && strcmp(path + length - 4, ".txt") == 0);
+    unsigned char header[BITONIC_IO_HEADER_BYTES];
+    bitonic_encode_header(header, sizeof(int), count);
+    int status = (text || fwrite(header, sizeof(header), 1, f) == 1) ? 0 : -1;
+    for (unsigned long long lo = 0; status == 0 && lo < count; lo += CHECK_BLOCK)
+    {
+        size_t n = (count - lo < CHECK_BLOCK) ? (size_t)(count - lo) : CHECK_BLOCK;
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i)
+            block[i] = (int)(uint32_t)mix64(seed ^ mix64(lo + i));
+        if (text)
+        {
+            for (size_t i = 0; i < n && status == 0; ++i)
+                status = (fprintf(f, "%d\n", block[i]) < 0) ? -1 : 0;
+        }
+        else if (fwrite(block, sizeof(int), n, f) != n)
+        {
+            status = -1;
+        }
+    }
+    if (fclose(f) != 0 || status != 0)
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        status = -1;
+    }
+    free(block);
+    return status;
+}
+
+/* Opens a binary int32 file and reads its count; NULL on error */
+static FILE *open_values(const char *path, uint64_t *count)
+{
+    unsigned char header[BITONIC_IO_HEADER_BYTES];
+    int elem;
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return NULL;
+    }
+    if (fread(header, sizeof(header), 1, f) != 1 || bitonic_decode_header(header, &elem, count) != 0 ||
+        elem != (int)sizeof(int))
+    {
+        fprintf(stderr, "%s is not a binary int32 file\n", path);
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+/**
+ * Function: verify
+ * ----------------
+ * Streams 'input' and 'output' (binary int32 files) block by block: the
+ * output must hold as many values as the input, in non-decreasing order,
+ * with the same multiset fingerprint. Returns 0 if it does.
+ */
+static int verify(const char *input, const char *output)
+{
+    uint64_t in_count = 0, out_count = 0;
+    FILE *in = open_values(input, &in_count);
+    FILE *out = open_values(output, &out_count);
+    int *block = malloc(CHECK_BLOCK * sizeof(int));
+    int status = (in && out && block) ? 0 : -1;
+    if (status == 0 && in_count != out_count)
+    {
+        fprintf(stderr, "Output holds %llu values, input %llu\n", (unsigned long long)out_count,
+                (unsigned long long)in_count);
+        status = -1;
+    }
+
+    uint64_t in_sum = 0, out_sum = 0;
+    int previous = INT32_MIN;
+    for (uint64_t lo = 0; status == 0 && lo < in_count; lo += CHECK_BLOCK)
+    {
+        size_t n = (in_count - lo < CHECK_BLOCK) ? (size_t)(in_count - lo) : CHECK_BLOCK;
+        uint64_t sum = 0;
+        if (fread(block, sizeof(int), n, in) != n)
+        {
+            fprintf(stderr, "%s is truncated\n", input);
+            status = -1;
+            break;
+        }
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+        for (size_t i = 0; i < n; ++i)
+            sum += mix64((uint32_t)block[i]);
+        in_sum += sum;
+
+        sum = 0;
+        int unsorted = 0;
+        if (fread(block, sizeof(int), n, out) != n)
+        {
+            fprintf(stderr, "%s is truncated\n", output);
+            status = -1;
+            break;
+        }
+#pragma omp parallel for reduction(+ : sum) reduction(| : unsorted) schedule(static)
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum += mix64((uint32_t)block[i]);
+            unsorted |= (i > 0 && block[i - 1] > block[i]);
+        }
+        out_sum += sum;
+        if (unsorted || block[0] < previous)
+        {
+            fprintf(stderr, "Output is not sorted in values [%llu, %llu)\n", (unsigned long long)lo,
+                    (unsigned long long)(lo + n));
+            status = -1;
+        }
+        previous = block[n - 1];
+    }
+    if (status == 0 && in_sum != out_sum)
+    {
+        fprintf(stderr, "Output is not a permutation of the input\n");
+        status = -1;
+    }
+
+    if (in)
+        fclose(in);
+    if (out)
+        fclose(out);
+    free(block);
+    return status;
+}
+
+/**
+ * Function: main
+ * --------------
+ * Input generator and result checker of tests/large_count.sh.
+ *
+ * Usage: large_count_check gen PATH COUNT [SEED]
+ *        large_count_check verify INPUT OUTPUT
+ */
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "gen") == 0)
+    {
+        unsigned long long seed = (argc > 4) ? strtoull(argv[4], NULL, 10) : 42;
+        return generate(argv[2], strtoull(argv[3], NULL, 10), seed) == 0 ? 0 : 1;
+    }
+    if (argc == 4 && strcmp(argv[1], "verify") == 0)
+    {
+        if (verify(argv[2], argv[3]) != 0)
+            return 1;
+        printf("verified: %s is sorted and a permutation of %s\n", argv[3], argv[2]);
+        return 0;
+    }
+    fprintf(stderr, "Usage: %s gen PATH COUNT [SEED] | verify INPUT OUTPUT\n", argv[0]);
+    return 1;
+}